@@ -0,0 +1,459 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#include "assetio.h"
+
+#include <spdlog/spdlog.h>
+
+#include <condition_variable>
+#include <deque>
+
+#include "mappedfile.h"
+#include "packarchive.h"
+#include "threadpool.h"
+#include "utility.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define FORKER_HAS_IO_URING
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#endif
+
+struct ReadRequest
+{
+    std::string               filename;
+    std::vector<std::uint8_t> data;
+    std::size_t               done = 0;  // bytes read so far
+    int                       fd = -1;
+    bool                      finished = false;
+    bool                      success = false;
+};
+
+// Queued reads by filename, removed when Read() takes them
+static std::mutex                                                    s_Mutex;
+static std::condition_variable                                       s_Condition;
+static std::unordered_map<std::string, std::shared_ptr<ReadRequest>> s_Requests;
+
+static void completeRequest(ReadRequest& request, bool success)
+{
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        request.finished = true;
+        request.success = success;
+        if (!success) request.data = std::vector<std::uint8_t>();
+    }
+    s_Condition.notify_all();
+}
+
+static bool readFile(const std::string& filename, std::vector<std::uint8_t>& data)
+{
+    std::ifstream in(filename, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) return false;
+
+    std::streamoff size = in.tellg();
+    if (size < 0) return false;
+
+    data.resize((std::size_t)size);
+    in.seekg(0, std::ios::beg);
+    in.read(reinterpret_cast<char*>(data.data()), size);
+    return (bool)in;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+class ReadBackend
+{
+public:
+    virtual ~ReadBackend() = default;
+
+    virtual const char* GetName() const = 0;
+    virtual void        Submit(std::shared_ptr<ReadRequest> request) = 0;
+};
+
+// Blocking reads on a few threads of their own
+class ThreadReadBackend : public ReadBackend
+{
+public:
+    ThreadReadBackend() : m_Pool(4) { }
+
+    const char* GetName() const override { return "threads"; }
+
+    void Submit(std::shared_ptr<ReadRequest> request) override
+    {
+        m_Pool.Enqueue([request]() {
+            bool success = readFile(request->filename, request->data);
+            completeRequest(*request, success);
+        });
+    }
+
+private:
+    ThreadPool m_Pool;
+};
+
+#ifdef FORKER_HAS_IO_URING
+
+// Reads are queued as IORING_OP_READ entries and submitted without waiting. One reaper
+// thread blocks on the completion queue, continues short reads and wakes up readers.
+class UringReadBackend : public ReadBackend
+{
+public:
+    static std::unique_ptr<UringReadBackend> Create()
+    {
+        std::unique_ptr<UringReadBackend> backend(new UringReadBackend());
+        if (!backend->setup()) return nullptr;
+        backend->m_Reaper = std::thread(&UringReadBackend::reapLoop, backend.get());
+        return backend;
+    }
+
+    ~UringReadBackend() override
+    {
+        if (m_Reaper.joinable())
+        {
+            // A NOP without request wakes up the reaper for the last time
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            io_uring_sqe* sqe = getSqe();
+            if (sqe)
+            {
+                sqe->opcode = IORING_OP_NOP;
+                sqe->user_data = 0;
+                pushSqe();
+                commitSqes(1);
+            }
+        }
+        if (m_Reaper.joinable()) m_Reaper.join();
+
+        for (auto& active : m_Active)
+        {
+            if (active.second->fd >= 0) close(active.second->fd);
+        }
+        if (m_Sqes) munmap(m_Sqes, m_SqesSize);
+        if (m_CqRing && m_CqRing != m_SqRing) munmap(m_CqRing, m_CqRingSize);
+        if (m_SqRing) munmap(m_SqRing, m_SqRingSize);
+        if (m_RingFd >= 0) close(m_RingFd);
+    }
+
+    const char* GetName() const override { return "io_uring"; }
+
+    void Submit(std::shared_ptr<ReadRequest> request) override
+    {
+        // Opening and sizing the file is cheap compared to reading it
+        request->fd = open(request->filename.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (request->fd < 0 || fstat(request->fd, &st) != 0)
+        {
+            if (request->fd >= 0) close(request->fd);
+            request->fd = -1;
+            completeRequest(*request, false);
+            return;
+        }
+        if (st.st_size == 0)
+        {
+            close(request->fd);
+            request->fd = -1;
+            completeRequest(*request, true);
+            return;
+        }
+        request->data.resize((std::size_t)st.st_size);
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        ReadRequest* key = request.get();
+        m_Active.emplace(key, std::move(request));
+        if (queueRead(key))
+            commitSqes(1);
+        else
+            m_Backlog.push_back(key);
+    }
+
+private:
+    static const unsigned    s_NumEntries = 64;
+    static const std::size_t s_MaxReadSize = 64 * 1024 * 1024;
+
+    int         m_RingFd = -1;
+    void*       m_SqRing = nullptr;
+    void*       m_CqRing = nullptr;
+    std::size_t m_SqRingSize = 0;
+    std::size_t m_CqRingSize = 0;
+    std::size_t m_SqesSize = 0;
+
+    unsigned*     m_SqHead = nullptr;
+    unsigned*     m_SqTail = nullptr;
+    unsigned*     m_SqMask = nullptr;
+    unsigned*     m_SqArray = nullptr;
+    io_uring_sqe* m_Sqes = nullptr;
+    unsigned*     m_CqHead = nullptr;
+    unsigned*     m_CqTail = nullptr;
+    unsigned*     m_CqMask = nullptr;
+    io_uring_cqe* m_Cqes = nullptr;
+    unsigned      m_NumSqEntries = 0;
+
+    // Submission side, shared by Submit() callers and the reaper
+    std::mutex                                                      m_Mutex;
+    unsigned                                                        m_InFlight = 0;
+    std::deque<ReadRequest*>                                        m_Backlog;
+    std::unordered_map<ReadRequest*, std::shared_ptr<ReadRequest>> m_Active;
+    std::thread                                                     m_Reaper;
+
+    UringReadBackend() = default;
+
+    bool setup()
+    {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        m_RingFd = (int)syscall(__NR_io_uring_setup, s_NumEntries, &params);
+        if (m_RingFd < 0) return false;
+
+        m_NumSqEntries = params.sq_entries;
+        m_SqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        m_CqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMmap) m_SqRingSize = m_CqRingSize = Max(m_SqRingSize, m_CqRingSize);
+
+        m_SqRing = mmap(nullptr, m_SqRingSize, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, m_RingFd, IORING_OFF_SQ_RING);
+        if (m_SqRing == MAP_FAILED)
+        {
+            m_SqRing = nullptr;
+            return false;
+        }
+        m_CqRing = singleMmap
+                       ? m_SqRing
+                       : mmap(nullptr, m_CqRingSize, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_POPULATE, m_RingFd, IORING_OFF_CQ_RING);
+        if (m_CqRing == MAP_FAILED)
+        {
+            m_CqRing = nullptr;
+            return false;
+        }
+        m_SqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = mmap(nullptr, m_SqesSize, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, m_RingFd, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) return false;
+        m_Sqes = static_cast<io_uring_sqe*>(sqes);
+
+        auto* sq = static_cast<std::uint8_t*>(m_SqRing);
+        m_SqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        m_SqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        m_SqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        m_SqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+        auto* cq = static_cast<std::uint8_t*>(m_CqRing);
+        m_CqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        m_CqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        m_CqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        m_Cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    // Next free submission entry (zeroed), nullptr if the queue is full. Under m_Mutex.
+    io_uring_sqe* getSqe()
+    {
+        unsigned head = __atomic_load_n(m_SqHead, __ATOMIC_ACQUIRE);
+        unsigned tail = *m_SqTail;
+        if (tail - head >= m_NumSqEntries) return nullptr;
+
+        unsigned index = tail & *m_SqMask;
+        m_SqArray[index] = index;
+        memset(&m_Sqes[index], 0, sizeof(io_uring_sqe));
+        return &m_Sqes[index];
+    }
+
+    // Makes the entry from getSqe() visible to the kernel
+    void pushSqe() { __atomic_store_n(m_SqTail, *m_SqTail + 1, __ATOMIC_RELEASE); }
+
+    void commitSqes(unsigned count)
+    {
+        while (syscall(__NR_io_uring_enter, m_RingFd, count, 0, 0, nullptr, 0) < 0 &&
+               errno == EINTR)
+        {
+        }
+    }
+
+    // Reads the rest of the file (in pieces of at most s_MaxReadSize). Under m_Mutex.
+    bool queueRead(ReadRequest* request)
+    {
+        // Completions must never outnumber the queue entries
+        if (m_InFlight >= m_NumSqEntries) return false;
+
+        io_uring_sqe* sqe = getSqe();
+        if (!sqe) return false;
+
+        std::size_t remaining = request->data.size() - request->done;
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = request->fd;
+        sqe->addr = (std::uint64_t)(std::uintptr_t)(request->data.data() + request->done);
+        sqe->len = (std::uint32_t)Min(remaining, s_MaxReadSize);
+        sqe->off = request->done;
+        sqe->user_data = (std::uint64_t)(std::uintptr_t)request;
+        pushSqe();
+        ++m_InFlight;
+        return true;
+    }
+
+    void finish(ReadRequest* request, bool success)
+    {
+        close(request->fd);
+        request->fd = -1;
+        std::shared_ptr<ReadRequest> owner = std::move(m_Active[request]);
+        m_Active.erase(request);
+        completeRequest(*owner, success);
+    }
+
+    // The ring is unusable, nobody may wait forever
+    void failAll()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        while (!m_Active.empty())
+            finish(m_Active.begin()->first, false);
+        m_Backlog.clear();
+    }
+
+    void reapLoop()
+    {
+        bool stopping = false;
+        while (!stopping)
+        {
+            int ret = (int)syscall(__NR_io_uring_enter, m_RingFd, 0, 1,
+                                   IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (ret < 0 && errno != EINTR)
+            {
+                spdlog::error("io_uring_enter failed: {}", strerror(errno));
+                failAll();
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            unsigned submitted = 0;
+            unsigned head = *m_CqHead;
+            unsigned tail = __atomic_load_n(m_CqTail, __ATOMIC_ACQUIRE);
+            for (; head != tail; ++head)
+            {
+                const io_uring_cqe& cqe = m_Cqes[head & *m_CqMask];
+                auto* request =
+                    reinterpret_cast<ReadRequest*>((std::uintptr_t)cqe.user_data);
+                if (!request)
+                {
+                    stopping = true;
+                    continue;
+                }
+                --m_InFlight;
+
+                if (cqe.res == -EINTR || cqe.res == -EAGAIN)
+                {
+                    m_Backlog.push_front(request);
+                }
+                else if (cqe.res == -EINVAL && request->done == 0)
+                {
+                    // IORING_OP_READ needs Linux 5.6, read it the old way
+                    finish(request, readFile(request->filename, request->data));
+                }
+                else if (cqe.res < 0)
+                {
+                    spdlog::warn("Failed to read \'{}\': {}", request->filename,
+                                 strerror(-cqe.res));
+                    finish(request, false);
+                }
+                else if (cqe.res == 0)  // file got shorter
+                {
+                    request->data.resize(request->done);
+                    finish(request, true);
+                }
+                else
+                {
+                    request->done += cqe.res;
+                    if (request->done < request->data.size())
+                        m_Backlog.push_front(request);
+                    else
+                        finish(request, true);
+                }
+            }
+            __atomic_store_n(m_CqHead, head, __ATOMIC_RELEASE);
+
+            while (!m_Backlog.empty() && queueRead(m_Backlog.front()))
+            {
+                m_Backlog.pop_front();
+                ++submitted;
+            }
+            if (submitted > 0) commitSqes(submitted);
+        }
+    }
+};
+
+#endif
+
+/////////////////////////////////////////////////////////////////////////////////
+
+static ReadBackend& getBackend()
+{
+    static std::unique_ptr<ReadBackend> s_Backend;
+    static std::once_flag               s_BackendFlag;
+    std::call_once(s_BackendFlag, []() {
+#ifdef FORKER_HAS_IO_URING
+        s_Backend = UringReadBackend::Create();
+        if (!s_Backend) spdlog::warn("io_uring is not available, reading on threads");
+#endif
+        if (!s_Backend) s_Backend = std::make_unique<ThreadReadBackend>();
+    });
+    return *s_Backend;
+}
+
+void AssetIO::Prefetch(const std::string& filename)
+{
+    if (PackArchive::Find(filename)) return;  // already in memory
+
+    auto request = std::make_shared<ReadRequest>();
+    request->filename = filename;
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        if (!s_Requests.emplace(filename, request).second) return;  // already queued
+    }
+    getBackend().Submit(request);
+}
+
+bool AssetIO::Read(const std::string& filename, std::vector<std::uint8_t>& data)
+{
+    // Files of the mounted pack archive
+    std::shared_ptr<const MappedFile> entry = PackArchive::Find(filename);
+    if (entry)
+    {
+        data.assign(entry->GetData(), entry->GetData() + entry->GetSize());
+        return true;
+    }
+
+    std::shared_ptr<ReadRequest> request;
+    {
+        std::unique_lock<std::mutex> lock(s_Mutex);
+        auto                         iter = s_Requests.find(filename);
+        if (iter != s_Requests.end())
+        {
+            request = iter->second;
+            s_Requests.erase(iter);
+            s_Condition.wait(lock, [&request]() { return request->finished; });
+        }
+    }
+
+    if (!request) return readFile(filename, data);
+    if (!request->success) return false;
+
+    data = std::move(request->data);
+    return true;
+}
+
+bool AssetIO::ReadText(const std::string& filename, std::string& text)
+{
+    std::vector<std::uint8_t> data;
+    if (!Read(filename, data)) return false;
+    text.assign(data.begin(), data.end());
+    return true;
+}
+
+const char* AssetIO::GetBackendName()
+{
+    return getBackend().GetName();
+}
@@ -0,0 +1,25 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#pragma once
+
+// Whole-file reads for asset loading. Prefetch() queues a read and returns at once, so
+// the reads of every file a loader knows about are in flight together while it keeps
+// parsing and decoding. Read() hands over the contents, waiting for the queued read if
+// there is one and reading synchronously otherwise. Files of a mounted pack archive are
+// taken from the archive.
+//
+// Backend: io_uring on Linux (raw system calls, no liburing), reader threads elsewhere
+// or when the kernel refuses to set up a ring.
+class AssetIO
+{
+public:
+    static void Prefetch(const std::string& filename);
+    static bool Read(const std::string& filename, std::vector<std::uint8_t>& data);
+
+    // Reads the file as text, e.g. for std::istringstream based parsers
+    static bool ReadText(const std::string& filename, std::string& text);
+
+    static const char* GetBackendName();
+};
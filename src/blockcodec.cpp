@@ -0,0 +1,167 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#include "blockcodec.h"
+
+#include <spdlog/spdlog.h>
+
+#include "utility.h"
+
+static const std::size_t s_MinMatch = 4;
+static const std::size_t s_LastLiterals = 5;   // a block always ends with literals
+static const std::size_t s_MatchSafeArea = 12;  // no match starts in the last bytes
+static const std::size_t s_MaxOffset = 65535;
+static const int         s_HashBits = 16;
+
+static inline std::uint32_t read32(const std::uint8_t* p)
+{
+    std::uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline std::uint32_t hash4(std::uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - s_HashBits);
+}
+
+// Length continuation: 255 bytes while the rest does not fit in one
+static void writeLength(std::vector<std::uint8_t>& out, std::size_t length)
+{
+    while (length >= 255)
+    {
+        out.push_back(255);
+        length -= 255;
+    }
+    out.push_back((std::uint8_t)length);
+}
+
+static void writeSequence(std::vector<std::uint8_t>& out, const std::uint8_t* literals,
+                          std::size_t numLiterals, std::size_t offset,
+                          std::size_t matchLength)
+{
+    std::size_t  matchCode = matchLength ? matchLength - s_MinMatch : 0;
+    std::uint8_t token = (std::uint8_t)((Min<std::size_t>(numLiterals, 15) << 4) |
+                                        Min<std::size_t>(matchCode, 15));
+    out.push_back(token);
+    if (numLiterals >= 15) writeLength(out, numLiterals - 15);
+    out.insert(out.end(), literals, literals + numLiterals);
+
+    if (matchLength == 0) return;  // last sequence
+    out.push_back((std::uint8_t)(offset & 0xFF));
+    out.push_back((std::uint8_t)(offset >> 8));
+    if (matchCode >= 15) writeLength(out, matchCode - 15);
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+std::size_t BlockCodec::GetMaxCompressedSize(std::size_t size)
+{
+    return size + size / 255 + 16;
+}
+
+std::size_t BlockCodec::Compress(const std::uint8_t* src, std::size_t size,
+                                 std::vector<std::uint8_t>& out)
+{
+    std::size_t start = out.size();
+    out.reserve(start + GetMaxCompressedSize(size));
+
+    // Greedy parse with a single-entry hash table of recent positions
+    std::vector<std::uint32_t> table((std::size_t)1 << s_HashBits, 0);
+    std::size_t                anchor = 0;  // first literal not emitted yet
+    std::size_t                pos = 0;
+
+    std::size_t matchLimit = size > s_MatchSafeArea ? size - s_MatchSafeArea : 0;
+
+    while (pos < matchLimit)
+    {
+        std::uint32_t  sequence = read32(src + pos);
+        std::uint32_t& slot = table[hash4(sequence)];
+        std::size_t    candidate = slot;
+        slot = (std::uint32_t)pos;
+
+        if (candidate >= pos || pos - candidate > s_MaxOffset ||
+            read32(src + candidate) != sequence)
+        {
+            ++pos;
+            continue;
+        }
+
+        // Extend the match, it must stop s_LastLiterals bytes before the end
+        std::size_t length = s_MinMatch;
+        std::size_t maxLength = size - s_LastLiterals - pos;
+        while (length < maxLength && src[candidate + length] == src[pos + length])
+            ++length;
+
+        writeSequence(out, src + anchor, pos - anchor, pos - candidate, length);
+        pos += length;
+        anchor = pos;
+    }
+
+    writeSequence(out, src + anchor, size - anchor, 0, 0);
+    return out.size() - start;
+}
+
+bool BlockCodec::Decompress(const std::uint8_t* src, std::size_t srcSize,
+                            std::uint8_t* dst, std::size_t dstSize)
+{
+    const std::uint8_t* ip = src;
+    const std::uint8_t* ipEnd = src + srcSize;
+    std::uint8_t*       op = dst;
+    std::uint8_t*       opEnd = dst + dstSize;
+
+    auto readLength = [&ip, ipEnd](std::size_t& length) {
+        std::uint8_t byte;
+        do
+        {
+            if (ip >= ipEnd) return false;
+            byte = *ip++;
+            length += byte;
+        } while (byte == 255);
+        return true;
+    };
+
+    while (ip < ipEnd)
+    {
+        std::uint8_t token = *ip++;
+
+        // Literals
+        std::size_t numLiterals = token >> 4;
+        if (numLiterals == 15 && !readLength(numLiterals)) return false;
+        if (numLiterals > (std::size_t)(ipEnd - ip) ||
+            numLiterals > (std::size_t)(opEnd - op))
+            return false;
+        memcpy(op, ip, numLiterals);
+        ip += numLiterals;
+        op += numLiterals;
+
+        if (ip == ipEnd) break;  // the last sequence has no match
+
+        // Match
+        if (ipEnd - ip < 2) return false;
+        std::size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        std::size_t length = token & 15;
+        if (length == 15 && !readLength(length)) return false;
+        length += s_MinMatch;
+
+        if (offset == 0 || offset > (std::size_t)(op - dst) ||
+            length > (std::size_t)(opEnd - op))
+            return false;
+
+        // An offset shorter than the length repeats the last bytes, copied one by one
+        const std::uint8_t* match = op - offset;
+        if (offset >= length)
+        {
+            memcpy(op, match, length);
+            op += length;
+        }
+        else
+        {
+            for (std::size_t i = 0; i < length; ++i)
+                *op++ = *match++;
+        }
+    }
+    return op == opEnd;
+}
@@ -0,0 +1,23 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#pragma once
+
+// LZ4 block format (no frame): sequences of literals and back references of at least
+// 4 bytes inside the same block. Blocks are independent, so they can be decompressed
+// in parallel straight into their place in the destination buffer.
+class BlockCodec
+{
+public:
+    // Worst case size of a compressed block
+    static std::size_t GetMaxCompressedSize(std::size_t size);
+
+    // Appends the compressed block to out, returns its size
+    static std::size_t Compress(const std::uint8_t* src, std::size_t size,
+                                std::vector<std::uint8_t>& out);
+
+    // Fails unless the block expands to exactly dstSize bytes (never writes past it)
+    static bool Decompress(const std::uint8_t* src, std::size_t srcSize, std::uint8_t* dst,
+                           std::size_t dstSize);
+};
@@ -110,14 +110,14 @@ Buffer3f::Buffer3f(int w, int h, InitType type) : Buffer(w, h)
         m_Data = std::vector<Data>(w * h, Data(MinFloat));
 }
 
-TGAImage Buffer3f::GenerateImage() const
+TGAImage Buffer3f::GenerateImage(bool encodeGamma) const
 {
     TGAImage image(m_Width, m_Height, TGAImage::RGB);
     for (int x = 0; x < m_Width; ++x)
     {
         for (int y = 0; y < m_Height; ++y)
         {
-            const Vector3f& color = GetValue(x, y);
+            Vector3f color = encodeGamma ? Pow(GetValue(x, y), InvGamma) : GetValue(x, y);
             image.Set(x, y,
                       TGAColor(color.r * 254.99f, color.g * 254.99f, color.b * 254.99f));
         }
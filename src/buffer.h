@@ -72,7 +72,7 @@ public:
         m_Data[index].value = value;
     }
 
-    TGAImage GenerateImage() const;
+    TGAImage GenerateImage(bool encodeGamma = false) const;  // linear -> sRGB
 
     // Paint Background Before Rendering
     void PaintColor(const Color3& color);
@@ -0,0 +1,87 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#pragma once
+
+#include "geometry.h"
+
+// Read-only views into vertex data owned by someone else (e.g. a mapped .glb file).
+// The owner must outlive every view.
+
+// Strided array of N floats per element
+template <int N>
+class AttributeView
+{
+public:
+    AttributeView() : m_Data(nullptr), m_Stride(0), m_Count(0) { }
+    AttributeView(const std::uint8_t* data, std::size_t stride, int count)
+        : m_Data(data), m_Stride(stride), m_Count(count)
+    {
+    }
+
+    inline bool IsValid() const { return m_Data != nullptr; }
+    inline int  GetCount() const { return m_Count; }
+
+    inline const float* operator[](int index) const
+    {
+        return reinterpret_cast<const float*>(m_Data + index * m_Stride);
+    }
+
+    inline Vector2f GetVector2(int index) const
+    {
+        const float* p = (*this)[index];
+        return Vector2f(p[0], p[1]);
+    }
+
+    inline Vector3f GetVector3(int index) const
+    {
+        const float* p = (*this)[index];
+        return Vector3f(p[0], p[1], p[2]);
+    }
+
+private:
+    const std::uint8_t* m_Data;
+    std::size_t         m_Stride;
+    int                 m_Count;
+};
+
+// Triangle list indices stored as 8, 16 or 32-bit unsigned integers. Without data,
+// the view enumerates 0, 1, 2, ... (non-indexed geometry).
+class IndexView
+{
+public:
+    IndexView() : m_Data(nullptr), m_ComponentSize(0), m_Count(0) { }
+    IndexView(const std::uint8_t* data, int componentSize, int count)
+        : m_Data(data), m_ComponentSize(componentSize), m_Count(count)
+    {
+    }
+
+    inline int GetCount() const { return m_Count; }
+
+    inline int operator[](int index) const
+    {
+        switch (m_ComponentSize)
+        {
+            case 1: return m_Data[index];
+            case 2: return reinterpret_cast<const std::uint16_t*>(m_Data)[index];
+            case 4: return (int)reinterpret_cast<const std::uint32_t*>(m_Data)[index];
+            default: return index;
+        }
+    }
+
+private:
+    const std::uint8_t* m_Data;
+    int                 m_ComponentSize;
+    int                 m_Count;
+};
+
+// Vertex streams of one triangle list, all addressed by the same index
+struct PrimitiveViews
+{
+    IndexView        indices;
+    AttributeView<3> positions;
+    AttributeView<3> normals;
+    AttributeView<2> texCoords;
+    AttributeView<4> tangents;  // xyz + handedness
+};
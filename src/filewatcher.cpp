@@ -0,0 +1,161 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#include "filewatcher.h"
+
+#include <spdlog/spdlog.h>
+
+#include "mappedfile.h"
+
+#if defined(__linux__)
+#define FORKER_HAS_INOTIFY
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+static const int s_SettleMs = 100;  // editors may save in several writes
+static const int s_PollMs = 500;
+
+// Directory part including the trailing slash, empty for the working directory
+static std::string getDirectoryPrefix(const std::string& filename)
+{
+    size_t slashPos = filename.find_last_of("/");
+    return (slashPos == std::string::npos) ? "" : filename.substr(0, slashPos + 1);
+}
+
+FileWatcher::FileWatcher() : m_Fd(-1)
+{
+#ifdef FORKER_HAS_INOTIFY
+    m_Fd = inotify_init1(IN_CLOEXEC);
+    if (m_Fd < 0) spdlog::warn("inotify is not available, polling files");
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+#ifdef FORKER_HAS_INOTIFY
+    if (m_Fd >= 0) close(m_Fd);
+#endif
+}
+
+void FileWatcher::Watch(const std::vector<std::string>& filenames)
+{
+    std::map<std::string, WatchedFile> files;
+    for (const std::string& filename : filenames)
+    {
+        auto iter = m_Files.find(filename);
+        if (iter != m_Files.end())
+        {
+            files.emplace(filename, iter->second);
+            continue;
+        }
+
+        WatchedFile file = { HashFile(filename), 0, 0 };
+        GetFileStat(filename, file.size, file.mtime);
+        files.emplace(filename, file);
+
+#ifdef FORKER_HAS_INOTIFY
+        // Directories stay watched, events of files no longer watched are ignored
+        if (m_Fd < 0) continue;
+        std::string prefix = getDirectoryPrefix(filename);
+        int         wd =
+            inotify_add_watch(m_Fd, prefix.empty() ? "." : prefix.c_str(),
+                              IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE);
+        if (wd < 0)
+            spdlog::warn("Cannot watch the directory of \'{}\'", filename);
+        else
+            m_Directories[wd] = prefix;
+#endif
+    }
+    m_Files = std::move(files);
+}
+
+std::vector<std::string> FileWatcher::WaitForChanges()
+{
+    std::vector<std::string> changed;
+    while (changed.empty())
+    {
+        std::set<std::string> candidates;
+        if (m_Fd >= 0)
+            waitForEvents(candidates);
+        else
+            pollForChanges(candidates);
+
+        for (const std::string& filename : candidates)
+        {
+            WatchedFile&  file = m_Files[filename];
+            std::uint64_t hash = HashFile(filename);
+            GetFileStat(filename, file.size, file.mtime);
+            if (hash == file.hash)
+            {
+                spdlog::info("  [Watch] \'{}\' has the same content, skipped", filename);
+                continue;
+            }
+            file.hash = hash;
+            changed.push_back(filename);
+        }
+    }
+    return changed;
+}
+
+const char* FileWatcher::GetBackendName() const
+{
+    return m_Fd >= 0 ? "inotify" : "polling";
+}
+
+void FileWatcher::waitForEvents(std::set<std::string>& candidates)
+{
+#ifdef FORKER_HAS_INOTIFY
+    alignas(struct inotify_event) char buffer[4096];
+
+    // Blocks for the first event, then collects events until the files settle
+    int timeout = -1;
+    while (true)
+    {
+        struct pollfd pfd = { m_Fd, POLLIN, 0 };
+        int           ready = poll(&pfd, 1, timeout);
+        if (ready == 0) return;
+
+        ssize_t length = ready > 0 ? read(m_Fd, buffer, sizeof(buffer)) : -1;
+        if (length < 0 && errno == EINTR) continue;
+        if (length <= 0)
+        {
+            spdlog::warn("Failed to read file events, polling files");
+            close(m_Fd);
+            m_Fd = -1;
+            return;
+        }
+
+        for (char* p = buffer; p < buffer + length;)
+        {
+            const struct inotify_event* event = (const struct inotify_event*)p;
+            p += sizeof(struct inotify_event) + event->len;
+
+            auto directory = m_Directories.find(event->wd);
+            if (event->len == 0 || directory == m_Directories.end()) continue;
+
+            std::string filename = directory->second + event->name;
+            if (m_Files.count(filename) > 0) candidates.insert(filename);
+        }
+        if (!candidates.empty()) timeout = s_SettleMs;
+    }
+#endif
+}
+
+void FileWatcher::pollForChanges(std::set<std::string>& candidates)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(s_PollMs));
+
+    for (const auto& watched : m_Files)
+    {
+        std::uint64_t size = 0;
+        std::int64_t  mtime = 0;
+        GetFileStat(watched.first, size, mtime);
+        if (size != watched.second.size || mtime != watched.second.mtime)
+        {
+            candidates.insert(watched.first);
+        }
+    }
+}
@@ -0,0 +1,44 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#pragma once
+
+// Reports which of a set of files have new content. A file counts as changed only when
+// its content hash differs from the last one seen, so saving without edits (or touching
+// the file) reports nothing.
+//
+// Backend: inotify on Linux, watching the directories so editors that save by replacing
+// the file are seen too. Elsewhere sizes and modification times are polled.
+class FileWatcher
+{
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Replaces the watched set. Files seen before keep their hash, new ones are hashed.
+    void Watch(const std::vector<std::string>& filenames);
+
+    // Blocks until at least one watched file has new content
+    std::vector<std::string> WaitForChanges();
+
+    const char* GetBackendName() const;
+
+private:
+    struct WatchedFile
+    {
+        std::uint64_t hash;
+        std::uint64_t size;  // polling only
+        std::int64_t  mtime;
+    };
+
+    std::map<std::string, WatchedFile> m_Files;
+    int                                m_Fd;           // inotify instance, -1 if polling
+    std::map<int, std::string>         m_Directories;  // by watch descriptor
+
+    void waitForEvents(std::set<std::string>& candidates);
+    void pollForChanges(std::set<std::string>& candidates);
+};
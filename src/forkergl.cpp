@@ -14,6 +14,15 @@
 // Texture Wrapping & Filtering
 Texture::WrapMode   ForkerGL::TextureWrapping = Texture::WrapMode::NoWrap;
 Texture::FilterMode ForkerGL::TextureFiltering = Texture::FilterMode::Nearest;
+Texture::LoadMode   ForkerGL::TextureLoading = Texture::LoadMode::Deferred;
+bool                ForkerGL::TextureCaching = false;
+bool                ForkerGL::TextureCompression = false;
+
+// Asset Sharing
+bool ForkerGL::SharedAssets = false;
+
+// Texture-Space Shading
+int ForkerGL::TexelShadingDensity = 0;
 
 // Buffers
 Buffer3f ForkerGL::FrameBuffer;  // Lighting Pass & Forward Pass
@@ -27,6 +36,16 @@ Buffer3f ForkerGL::EmissiveGBuffer;
 Buffer3f ForkerGL::ParamGBuffer;
 Buffer1f ForkerGL::ShadingTypeGBuffer;
 Buffer1f ForkerGL::AmbientOcclusionGBuffer;  // SSAO
+Buffer1f ForkerGL::FeedbackBuffer;
+
+ShadingCache ForkerGL::ShadingAtlas;
+LightGrid    ForkerGL::LightClusters;
+
+// Screen Tiles
+const int                       ForkerGL::TileSize;
+int                             ForkerGL::NumTilesX = 0;
+int                             ForkerGL::NumTilesY = 0;
+std::vector<ForkerGL::TileType> ForkerGL::TileTypes;
 
 // Images
 TGAImage ForkerGL::AntiAliasedImage;
@@ -51,6 +70,33 @@ void ForkerGL::TextureFilterMode(Texture::FilterMode filterMode)
     ForkerGL::TextureFiltering = filterMode;
 }
 
+void ForkerGL::TextureLoadMode(Texture::LoadMode loadMode)
+{
+    ForkerGL::TextureLoading = loadMode;
+}
+
+void ForkerGL::TextureCacheMode(bool enabled)
+{
+    ForkerGL::TextureCaching = enabled;
+}
+
+void ForkerGL::TextureCompressMode(bool enabled)
+{
+    ForkerGL::TextureCompression = enabled;
+}
+
+// Asset Sharing
+void ForkerGL::SharedAssetMode(bool enabled)
+{
+    ForkerGL::SharedAssets = enabled;
+}
+
+// Texture-Space Shading
+void ForkerGL::TexelShadingMode(int density)
+{
+    ForkerGL::TexelShadingDensity = Max(density, 0);
+}
+
 // Buffer Initialization
 void ForkerGL::InitFrameBuffer(int width, int height)
 {
@@ -80,6 +126,65 @@ void ForkerGL::InitGeometryBuffers(int width, int height)
     AmbientOcclusionGBuffer = Buffer1f(width, height, Buffer::One);
 }
 
+void ForkerGL::InitFeedbackBuffer(int width, int height)
+{
+    FeedbackBuffer = Buffer1f(width, height, Buffer::Zero);
+}
+
+void ForkerGL::InitShadingAtlas(int density)
+{
+    ShadingAtlas = ShadingCache(density);
+}
+
+void ForkerGL::ClassifyTiles()
+{
+    int width = DepthBuffer.GetWidth();
+    int height = DepthBuffer.GetHeight();
+    NumTilesX = (width + TileSize - 1) / TileSize;
+    NumTilesY = (height + TileSize - 1) / TileSize;
+    TileTypes.assign(NumTilesX * NumTilesY, EmptyTile);
+
+    for (int tileY = 0; tileY < NumTilesY; ++tileY)
+    {
+        for (int tileX = 0; tileX < NumTilesX; ++tileX)
+        {
+            bool hasEmpty = false, hasPhong = false, hasPBR = false;
+            int  xMax = Min(width, (tileX + 1) * TileSize);
+            int  yMax = Min(height, (tileY + 1) * TileSize);
+            for (int y = tileY * TileSize; y < yMax; ++y)
+            {
+                for (int x = tileX * TileSize; x < xMax; ++x)
+                {
+                    if (!IsCovered(x, y))
+                        hasEmpty = true;
+                    else if (ShadingTypeGBuffer.GetValue(x, y) < 0.5f)
+                        hasPhong = true;
+                    else
+                        hasPBR = true;
+                }
+            }
+
+            TileType& type = TileTypes[tileY * NumTilesX + tileX];
+            if (!hasPhong && !hasPBR)
+                type = EmptyTile;
+            else if (hasEmpty || (hasPhong && hasPBR))
+                type = MixedTile;
+            else
+                type = hasPhong ? PhongTile : PBRTile;
+        }
+    }
+}
+
+ForkerGL::TileType ForkerGL::GetTileType(int tileX, int tileY)
+{
+    return TileTypes[tileY * NumTilesX + tileX];
+}
+
+bool ForkerGL::IsCovered(int x, int y)
+{
+    return DepthBuffer.GetValue(x, y) != MaxFloat;
+}
+
 // Status Configuration
 void ForkerGL::ClearColor(const Color3& color)
 {
@@ -198,10 +303,17 @@ void ForkerGL::DrawTriangleSubTask(int xMin, int xMax, int yMin, int yMax,
                 if (currentDepth >= DepthBuffer.GetValue(px, py)) continue;
                 DepthBuffer.SetValue(px, py, currentDepth);
             }
+            else if (passType == FeedbackPass)
+            {
+                if (currentDepth >= DepthBuffer.GetValue(px, py)) continue;
+                DepthBuffer.SetValue(px, py, currentDepth);
+            }
 
-            // Fragment Shader
+            // Fragment Shader (texture-space shading filters the shaded texels)
             Color3 frag;
-            bool   discard = shader.ProcessFragment(bary, frag);
+            bool   discard = (passType == ForwardPass && ShadingAtlas.IsEnabled())
+                                 ? ShadingAtlas.Shade(shader, bary, frag)
+                                 : shader.ProcessFragment(bary, frag);
             if (discard) continue;
 
             if (passType == ForwardPass)
@@ -229,6 +341,10 @@ void ForkerGL::DrawTriangleSubTask(int xMin, int xMax, int yMin, int yMax,
             {
                 ShadowBuffer.SetValue(px, py, frag.z);
             }
+            else if (passType == FeedbackPass)
+            {
+                FeedbackBuffer.SetValue(px, py, frag.x);
+            }
         }
     }
 }
@@ -241,13 +357,31 @@ void ForkerGL::DrawTriangle(const Point4f ndcVerts[3], Shader& shader)
     // Viewport transformation
     Point2i points[3];  // screen coordinates
     Point3f depths;     // from 0 to 1
+    Point2f screen[3];  // not truncated
     for (int i = 0; i < 3; ++i)
     {
         Point3f coord = (viewportMatrix * ndcVerts[i]).xyz;
         points[i] = Point2i(coord.x, coord.y);
         depths[i] = coord.z;
+        screen[i] = Point2f(coord.x, coord.y);
+    }
+
+    // Texture LOD: texture coordinate area over screen area, once per triangle
+    if (Texture::IsMipmapped(TextureFiltering))
+    {
+        const Matrix2x3f& uv = shader.v2fTexCoords;
+        Vector2f          e1 = screen[1] - screen[0], e2 = screen[2] - screen[0];
+        Vector2f t1 = Vector2f(uv[0][1] - uv[0][0], uv[1][1] - uv[1][0]);
+        Vector2f t2 = Vector2f(uv[0][2] - uv[0][0], uv[1][2] - uv[1][0]);
+        Float    screenArea = std::abs(e1.x * e2.y - e1.y * e2.x) * 0.5f;
+        Float    texCoordArea = std::abs(t1.x * t2.y - t1.y * t2.x) * 0.5f;
+        shader.v2fTexLod = Texture::GetTriangleLod(texCoordArea, screenArea);
     }
 
+    // Texture space of the triangle, its texels are shaded on first use
+    if (passType == ForwardPass && ShadingAtlas.IsEnabled())
+        ShadingAtlas.BeginTriangle(shader);
+
     // Bounding Box
     int w = (passType != ShadowPass) ? DepthBuffer.GetWidth() : ShadowBuffer.GetWidth();
     int h = (passType != ShadowPass) ? DepthBuffer.GetHeight() : ShadowBuffer.GetHeight();
@@ -323,58 +457,222 @@ void ForkerGL::DrawTriangle(const Point4f ndcVerts[3], Shader& shader)
     }
 }
 
-void ForkerGL::DrawScreenSpacePixels(const Scene& scene)
+// Local light of the lanes in laneBits (Phong or PBR), one pass over the lights of each
+// distinct light cluster of the lanes (neighboring pixels mostly share one)
+template <typename ShaderType>
+static Vec3x8 calculateLocalLights(const int* clusters, int laneBits,
+                                   const Vec3x8& positionWS, const Vec3x8& viewDir,
+                                   const Vec3x8& normalWS, const Vec3x8& albedo,
+                                   const Vec3x8& param)
 {
+    Vec3x8 localLight(0.f);
+    for (int first = 0; first < Float8::Width; ++first)
+    {
+        if (!(laneBits & (1 << first))) continue;
+
+        int bits = 0;
+        for (int i = first; i < Float8::Width; ++i)
+        {
+            if ((laneBits & (1 << i)) && clusters[i] == clusters[first]) bits |= 1 << i;
+        }
+        laneBits &= ~bits;
+
+        LightGrid::LightList lights = ForkerGL::LightClusters.GetLights(clusters[first]);
+        if (lights.empty()) continue;
+
+        Vec3x8 color = ShaderType::template CalculateLocalLights<Float8>(
+            lights, positionWS, viewDir, normalWS, albedo, param);
+        localLight = Select(Mask8::FromBits(bits), color, localLight);
+    }
+    return localLight;
+}
+
+// Shades the pixels [x0, x0 + numPixels) of row y as one packet. Uniform tiles need no
+// per-pixel coverage or shading model, mixed tiles select them per lane.
+template <ForkerGL::TileType Type>
+static void drawPixelPacket(int x0, int y, int numPixels, const Vec3x8& eyePos,
+                            const Vec3x8& lightPos, const Vec3x8& lightRadiance)
+{
+    const int width = Float8::Width;
+    Point3f   positionsWS[width];
+    Vector3f  normalsWS[width], lightDirs[width], params[width];
+    Color3    albedos[width], emissives[width], colors[width];
+    Float     shadingTypes[width], visibilities[width];
+    int       validBits = (1 << numPixels) - 1;  // the last pixel repeats in the others
+    int       coveredBits = validBits;
+
     // Data Preparation
-    Point3f eyePos = scene.GetCamera().GetPosition();
-    Point3f lightPos = scene.GetPointLight().position;
-    Color3  lightRadiance = scene.GetPointLight().color;
-    int     screenWidth = ForkerGL::FrameBuffer.GetWidth();
-    int     screenHeight = ForkerGL::FrameBuffer.GetHeight();
+    for (int i = 0; i < width; ++i)
+    {
+        int x = x0 + Min(i, numPixels - 1);
+        positionsWS[i] = ForkerGL::WorldPosGBuffer.GetValue(x, y);
+        normalsWS[i] = ForkerGL::NormalGBuffer.GetValue(x, y);
+        albedos[i] = ForkerGL::AlbedoGBuffer.GetValue(x, y);
+        emissives[i] = ForkerGL::EmissiveGBuffer.GetValue(x, y);
+        params[i] = ForkerGL::ParamGBuffer.GetValue(x, y);
+
+        Float ambientOcclusion = ForkerGL::AmbientOcclusionGBuffer.GetValue(x, y);
+        params[i].x *= ambientOcclusion;
+        // params[i].x = ambientOcclusion;
+
+        if (Type == ForkerGL::MixedTile)
+        {
+            shadingTypes[i] = ForkerGL::ShadingTypeGBuffer.GetValue(x, y);
+            if (i < numPixels && !ForkerGL::IsCovered(x, y)) coveredBits &= ~(1 << i);
+        }
+    }
+    if (!coveredBits) return;  // background
 
-    // For Loop Each Pixel
-    for (int y = 0; y < screenHeight; ++y)
+    Vec3x8 positionWS = Vec3x8::Load(positionsWS);
+    Vec3x8 normalWS = Vec3x8::Load(normalsWS);
+    Vec3x8 albedo = Vec3x8::Load(albedos);
+    Vec3x8 emissive = Vec3x8::Load(emissives);
+    Vec3x8 param = Vec3x8::Load(params);
+
+    // Directions
+    Vec3x8 lightDir = Normalize(lightPos - positionWS);
+    Vec3x8 viewDir = Normalize(eyePos - positionWS);
+
+    // Shadow Mapping (per pixel and in pixel order, PCF/PCSS sample randomly).
+    // The light space G-buffer only exists with shadows on.
+    Float8 visibility = 0.f;
+    if (Shadow::GetShadowStatus())
     {
-        for (int x = 0; x < screenWidth; ++x)
+        lightDir.Store(lightDirs);
+        for (int i = 0; i < width; ++i)
         {
-            // Data Preparation
-            Point3f  positionWS = ForkerGL::WorldPosGBuffer.GetValue(x, y);
-            Vector3f normalWS = ForkerGL::NormalGBuffer.GetValue(x, y);
-            Point3f  lightSpaceNDC = ForkerGL::LightSpaceNDCPosGBuffer.GetValue(x, y);
-            Color3   albedo = ForkerGL::AlbedoGBuffer.GetValue(x, y);
-            Color3   emissive = ForkerGL::EmissiveGBuffer.GetValue(x, y);
-            Vector3f param = ForkerGL::ParamGBuffer.GetValue(x, y);
-            Float    shadingType = ForkerGL::ShadingTypeGBuffer.GetValue(x, y);
-
-            Float    ambientOcclusion = ForkerGL::AmbientOcclusionGBuffer.GetValue(x, y);
-            param.x *= ambientOcclusion;
-            // param.x = ambientOcclusion;
-
-
-            // Directions
-            Vector3f lightDir = Normalize(lightPos - positionWS);
-            Vector3f viewDir = Normalize(eyePos - positionWS);
-
-            // Shadow Mapping
-            Float visibility = 0.f;
-            if (Shadow::GetShadowStatus())
-            {
-                visibility = Shadow::CalculateShadowVisibility(
-                    ForkerGL::ShadowBuffer, lightSpaceNDC, normalWS, lightDir);
-            }
+            visibilities[i] = 0.f;
+            if (!(coveredBits & (1 << i))) continue;
+
+            Point3f lightSpaceNDC = ForkerGL::LightSpaceNDCPosGBuffer.GetValue(x0 + i, y);
+            visibilities[i] = Shadow::CalculateShadowVisibility(
+                ForkerGL::ShadowBuffer, lightSpaceNDC, normalsWS[i], lightDirs[i]);
+        }
+        visibility = Float8::Load(visibilities);
+    }
+
+    // Light Clusters (local lights)
+    int  clusters[width];
+    bool hasLocalLights = !ForkerGL::LightClusters.IsEmpty();
+    if (hasLocalLights)
+    {
+        for (int i = 0; i < width; ++i)
+        {
+            clusters[i] = (coveredBits & (1 << i))
+                              ? ForkerGL::LightClusters.GetCluster(positionsWS[i])
+                              : -1;
+        }
+    }
+
+    // Non-PBR (Blinn-Phong Shading) or PBR
+    Vec3x8 color;
+    if (Type == ForkerGL::PhongTile)
+    {
+        Vec3x8 localLight(0.f);
+        if (hasLocalLights)
+        {
+            localLight = calculateLocalLights<BlinnPhongShader>(
+                clusters, coveredBits, positionWS, viewDir, normalWS, albedo, param);
+        }
+        color = BlinnPhongShader::CalculateLight(lightDir, viewDir, normalWS, visibility,
+                                                 albedo, emissive, param, lightRadiance,
+                                                 localLight);
+    }
+    else if (Type == ForkerGL::PBRTile)
+    {
+        Vec3x8 localLight(0.f);
+        if (hasLocalLights)
+        {
+            localLight = calculateLocalLights<PBRShader>(
+                clusters, coveredBits, positionWS, viewDir, normalWS, albedo, param);
+        }
+        Vec3x8 halfwayDir = Normalize(lightDir + viewDir);
+        color = PBRShader::CalculateLight(lightDir, viewDir, halfwayDir, normalWS,
+                                          visibility, albedo, emissive, param,
+                                          lightRadiance, localLight);
+    }
+    else
+    {
+        Mask8 isPhong = Float8::Load(shadingTypes) < 0.5f;
+        int   phongBits = isPhong.Bits() & coveredBits;
+        int   pbrBits = ~isPhong.Bits() & coveredBits;
 
-            Color3 color;
-            if (shadingType < 0.5f)  // Non-PBR (Blinn-Phong Shading)
+        Vec3x8 phongColor, pbrColor;
+        if (phongBits)
+        {
+            Vec3x8 localLight(0.f);
+            if (hasLocalLights)
             {
-                color = BlinnPhongShader::CalculateLight(lightDir, viewDir, normalWS, visibility, albedo, emissive, param, lightRadiance);
+                localLight = calculateLocalLights<BlinnPhongShader>(
+                    clusters, phongBits, positionWS, viewDir, normalWS, albedo, param);
             }
-            else  // PBR
+            phongColor = BlinnPhongShader::CalculateLight(
+                lightDir, viewDir, normalWS, visibility, albedo, emissive, param,
+                lightRadiance, localLight);
+        }
+        if (pbrBits)
+        {
+            Vec3x8 localLight(0.f);
+            if (hasLocalLights)
             {
-                Vector3f halfwayDir = Normalize(lightDir + viewDir);
-                color = PBRShader::CalculateLight(lightDir, viewDir, halfwayDir, normalWS, visibility, albedo, emissive, param, lightRadiance);
+                localLight = calculateLocalLights<PBRShader>(
+                    clusters, pbrBits, positionWS, viewDir, normalWS, albedo, param);
             }
+            Vec3x8 halfwayDir = Normalize(lightDir + viewDir);
+            pbrColor = PBRShader::CalculateLight(lightDir, viewDir, halfwayDir, normalWS,
+                                                 visibility, albedo, emissive, param,
+                                                 lightRadiance, localLight);
+        }
+        color = !pbrBits     ? phongColor
+                : !phongBits ? pbrColor
+                             : Select(isPhong, phongColor, pbrColor);
+    }
+
+    // Uncovered pixels keep the cleared color
+    color.Store(colors);
+    for (int i = 0; i < numPixels; ++i)
+    {
+        if (coveredBits & (1 << i)) ForkerGL::FrameBuffer.SetValue(x0 + i, y, colors[i]);
+    }
+}
+
+void ForkerGL::DrawScreenSpacePixels(const Scene& scene)
+{
+    // Data Preparation
+    Vec3x8 eyePos = Vec3x8(scene.GetCamera().GetPosition());
+    Vec3x8 lightPos = Vec3x8(scene.GetPointLight().position);
+    Vec3x8 lightRadiance = Vec3x8(scene.GetPointLight().color);
+    int    screenWidth = ForkerGL::FrameBuffer.GetWidth();
+    int    screenHeight = ForkerGL::FrameBuffer.GetHeight();
 
-            ForkerGL::FrameBuffer.SetValue(x, y, color);
+    // For Loop Each Row Of Each Tile (rows in screen order), 8 Pixels At A Time
+    for (int y = 0; y < screenHeight; ++y)
+    {
+        for (int tileX = 0; tileX < NumTilesX; ++tileX)
+        {
+            TileType type = GetTileType(tileX, y / TileSize);
+            if (type == EmptyTile) continue;
+
+            int xMax = Min(screenWidth, (tileX + 1) * TileSize);
+            for (int x0 = tileX * TileSize; x0 < xMax; x0 += Float8::Width)
+            {
+                int numPixels = Min(xMax - x0, (int)Float8::Width);
+                if (type == PhongTile)
+                {
+                    drawPixelPacket<PhongTile>(x0, y, numPixels, eyePos, lightPos,
+                                               lightRadiance);
+                }
+                else if (type == PBRTile)
+                {
+                    drawPixelPacket<PBRTile>(x0, y, numPixels, eyePos, lightPos,
+                                             lightRadiance);
+                }
+                else
+                {
+                    drawPixelPacket<MixedTile>(x0, y, numPixels, eyePos, lightPos,
+                                               lightRadiance);
+                }
+            }
         }
     }
-}
\ No newline at end of file
+}
@@ -6,7 +6,9 @@
 
 #include "buffer.h"
 #include "geometry.h"
+#include "lightgrid.h"
 #include "shader.h"
+#include "shadingcache.h"
 #include "texture.h"
 
 class Scene;
@@ -27,15 +29,31 @@ struct ForkerGL
         ForwardPass,
         GeometryPass,
         LightingPass,
-        ShadowPass
+        ShadowPass,
+        FeedbackPass  // virtual texture pages read by visible pixels
     };
 
-    // Texture Wrap Mode & Filter Mode
+    // Texture Wrap Mode & Filter Mode & Load Mode & Cache Files & Block Compression
     static Texture::WrapMode   TextureWrapping;
     static Texture::FilterMode TextureFiltering;
+    static Texture::LoadMode   TextureLoading;
+    static bool                TextureCaching;
+    static bool                TextureCompression;
 
     static void TextureWrapMode(Texture::WrapMode wrapMode);
     static void TextureFilterMode(Texture::FilterMode filterMode);
+    static void TextureLoadMode(Texture::LoadMode loadMode);
+    static void TextureCacheMode(bool enabled);
+    static void TextureCompressMode(bool enabled);
+
+    // Decoded meshes and textures in host-wide shared memory
+    static bool SharedAssets;
+    static void SharedAssetMode(bool enabled);
+
+    // Texture-space shading of the forward pass, texels per texture coordinate unit (0:
+    // every sample is shaded)
+    static int  TexelShadingDensity;
+    static void TexelShadingMode(int density);
 
     // Buffers
     static Buffer3f FrameBuffer;
@@ -49,6 +67,28 @@ struct ForkerGL
     static Buffer3f ParamGBuffer;
     static Buffer1f ShadingTypeGBuffer;
     static Buffer1f AmbientOcclusionGBuffer;  // SSAO
+    static Buffer1f FeedbackBuffer;           // FeedbackShader record of each pixel
+
+    // Shaded texels (forward pass with texture-space shading)
+    static ShadingCache ShadingAtlas;
+
+    // Local lights culled into clusters of the view (forward pass and lighting pass)
+    static LightGrid LightClusters;
+
+    // Screen tiles of the G-buffers by the shading models of their pixels (Geometry
+    // Pass). Mixed tiles have both models or uncovered pixels (background).
+    enum TileType
+    {
+        EmptyTile,
+        PhongTile,
+        PBRTile,
+        MixedTile
+    };
+
+    static const int             TileSize = 16;  // pixels, a multiple of Float8::Width
+    static int                   NumTilesX;
+    static int                   NumTilesY;
+    static std::vector<TileType> TileTypes;  // row-major
 
     // Images
     static TGAImage AntiAliasedImage;
@@ -57,6 +97,13 @@ struct ForkerGL
     static void InitDepthBuffer(int width, int height);
     static void InitShadowBuffer(int width, int height);
     static void InitGeometryBuffers(int width, int height);
+    static void InitFeedbackBuffer(int width, int height);
+    static void InitShadingAtlas(int density);
+
+    // Screen Tiles
+    static void     ClassifyTiles();
+    static TileType GetTileType(int tileX, int tileY);
+    static bool     IsCovered(int x, int y);  // depth written in the geometry pass
 
     // Update Status
     static void       ClearColor(const Color3& color);
@@ -5,17 +5,26 @@
 #pragma once
 
 #include <cassert>
+#include <cerrno>
+#include <cfloat>
+#include <climits>
 #include <cmath>
 #include <cstdlib>
 #include <ctime>
 #include <cstring>
 
+#include <algorithm>
 #include <ostream>
 #include <iostream>
 #include <fstream>
 #include <memory>
 #include <utility>
 #include <thread>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <atomic>
+#include <functional>
 #include <random>
 
 #include <string>
@@ -25,3 +34,4 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <map>
+#include <set>
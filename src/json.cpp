@@ -0,0 +1,281 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#include "json.h"
+
+static const JsonValue s_NullValue;
+
+class JsonParser
+{
+public:
+    JsonParser(const char* begin, const char* end) : m_Cur(begin), m_End(end) { }
+
+    bool ParseDocument(JsonValue& value, std::string& error)
+    {
+        bool success = parseValue(value, 0);
+        skipWhitespace();
+        if (success && m_Cur != m_End) m_Error = "trailing characters";
+        if (!m_Error.empty())
+        {
+            error = m_Error;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static const int s_MaxDepth = 256;
+
+    const char* m_Cur;
+    const char* m_End;
+    std::string m_Error;
+
+    bool fail(const char* message)
+    {
+        if (m_Error.empty()) m_Error = message;
+        return false;
+    }
+
+    void skipWhitespace()
+    {
+        while (m_Cur < m_End &&
+               (*m_Cur == ' ' || *m_Cur == '\t' || *m_Cur == '\n' || *m_Cur == '\r'))
+            ++m_Cur;
+    }
+
+    bool consume(char c)
+    {
+        skipWhitespace();
+        if (m_Cur < m_End && *m_Cur == c)
+        {
+            ++m_Cur;
+            return true;
+        }
+        return false;
+    }
+
+    bool consumeLiteral(const char* literal)
+    {
+        std::size_t length = strlen(literal);
+        if ((std::size_t)(m_End - m_Cur) < length || strncmp(m_Cur, literal, length) != 0)
+            return fail("invalid literal");
+        m_Cur += length;
+        return true;
+    }
+
+    bool parseValue(JsonValue& value, int depth)
+    {
+        if (depth > s_MaxDepth) return fail("nesting is too deep");
+
+        skipWhitespace();
+        if (m_Cur >= m_End) return fail("unexpected end of input");
+
+        switch (*m_Cur)
+        {
+            case '{': return parseObject(value, depth);
+            case '[': return parseArray(value, depth);
+            case '"':
+                value.m_Type = JsonValue::String;
+                return parseString(value.m_String);
+            case 't':
+                value.m_Type = JsonValue::Bool;
+                value.m_Bool = true;
+                return consumeLiteral("true");
+            case 'f':
+                value.m_Type = JsonValue::Bool;
+                value.m_Bool = false;
+                return consumeLiteral("false");
+            case 'n': value.m_Type = JsonValue::Null; return consumeLiteral("null");
+            default: return parseNumber(value);
+        }
+    }
+
+    bool parseObject(JsonValue& value, int depth)
+    {
+        value.m_Type = JsonValue::Object;
+        ++m_Cur;  // '{'
+        if (consume('}')) return true;
+        do
+        {
+            skipWhitespace();
+            std::string key;
+            if (m_Cur >= m_End || *m_Cur != '"') return fail("expected a key");
+            if (!parseString(key)) return false;
+            if (!consume(':')) return fail("expected ':'");
+
+            value.m_Keys.push_back(std::move(key));
+            value.m_Values.emplace_back();
+            if (!parseValue(value.m_Values.back(), depth + 1)) return false;
+        } while (consume(','));
+        return consume('}') || fail("expected '}'");
+    }
+
+    bool parseArray(JsonValue& value, int depth)
+    {
+        value.m_Type = JsonValue::Array;
+        ++m_Cur;  // '['
+        if (consume(']')) return true;
+        do
+        {
+            value.m_Values.emplace_back();
+            if (!parseValue(value.m_Values.back(), depth + 1)) return false;
+        } while (consume(','));
+        return consume(']') || fail("expected ']'");
+    }
+
+    bool parseNumber(JsonValue& value)
+    {
+        const char* start = m_Cur;
+        if (m_Cur < m_End && *m_Cur == '-') ++m_Cur;
+        while (m_Cur < m_End && (isdigit((unsigned char)*m_Cur) || *m_Cur == '.' ||
+                                 *m_Cur == 'e' || *m_Cur == 'E' || *m_Cur == '+' ||
+                                 *m_Cur == '-'))
+            ++m_Cur;
+        if (m_Cur == start) return fail("unexpected character");
+
+        std::string text(start, m_Cur);
+        char*       parsedEnd = nullptr;
+        value.m_Type = JsonValue::Number;
+        value.m_Number = strtod(text.c_str(), &parsedEnd);
+        if (parsedEnd != text.c_str() + text.size()) return fail("invalid number");
+        return true;
+    }
+
+    bool parseHex4(unsigned int& code)
+    {
+        if (m_End - m_Cur < 4) return fail("invalid escape");
+        code = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            char c = *m_Cur++;
+            code <<= 4;
+            if (c >= '0' && c <= '9') code |= c - '0';
+            else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+            else return fail("invalid escape");
+        }
+        return true;
+    }
+
+    static void appendUtf8(std::string& out, unsigned int code)
+    {
+        if (code < 0x80)
+        {
+            out += (char)code;
+        }
+        else if (code < 0x800)
+        {
+            out += (char)(0xC0 | (code >> 6));
+            out += (char)(0x80 | (code & 0x3F));
+        }
+        else if (code < 0x10000)
+        {
+            out += (char)(0xE0 | (code >> 12));
+            out += (char)(0x80 | ((code >> 6) & 0x3F));
+            out += (char)(0x80 | (code & 0x3F));
+        }
+        else
+        {
+            out += (char)(0xF0 | (code >> 18));
+            out += (char)(0x80 | ((code >> 12) & 0x3F));
+            out += (char)(0x80 | ((code >> 6) & 0x3F));
+            out += (char)(0x80 | (code & 0x3F));
+        }
+    }
+
+    bool parseString(std::string& out)
+    {
+        ++m_Cur;  // '"'
+        while (m_Cur < m_End && *m_Cur != '"')
+        {
+            char c = *m_Cur++;
+            if (c != '\\')
+            {
+                out += c;
+                continue;
+            }
+            if (m_Cur >= m_End) break;
+
+            char escape = *m_Cur++;
+            switch (escape)
+            {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u':
+                {
+                    unsigned int code;
+                    if (!parseHex4(code)) return false;
+                    // Surrogate pair
+                    if (code >= 0xD800 && code < 0xDC00 && m_End - m_Cur >= 6 &&
+                        m_Cur[0] == '\\' && m_Cur[1] == 'u')
+                    {
+                        m_Cur += 2;
+                        unsigned int low;
+                        if (!parseHex4(low)) return false;
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, code);
+                    break;
+                }
+                default: return fail("invalid escape");
+            }
+        }
+        if (m_Cur >= m_End) return fail("unterminated string");
+        ++m_Cur;  // '"'
+        return true;
+    }
+};
+
+/////////////////////////////////////////////////////////////////////////////////
+
+bool JsonValue::Parse(const char* begin, const char* end, JsonValue& value,
+                      std::string& error)
+{
+    value = JsonValue();
+    JsonParser parser(begin, end);
+    return parser.ParseDocument(value, error);
+}
+
+bool JsonValue::Has(const std::string& key) const
+{
+    return m_Type == Object &&
+           std::find(m_Keys.begin(), m_Keys.end(), key) != m_Keys.end();
+}
+
+const JsonValue& JsonValue::operator[](const std::string& key) const
+{
+    if (m_Type != Object) return s_NullValue;
+    for (std::size_t i = 0; i < m_Keys.size(); ++i)
+    {
+        if (m_Keys[i] == key) return m_Values[i];
+    }
+    return s_NullValue;
+}
+
+const JsonValue& JsonValue::operator[](int index) const
+{
+    if (m_Type != Array || index < 0 || index >= (int)m_Values.size()) return s_NullValue;
+    return m_Values[index];
+}
+
+bool JsonValue::AsBool(bool defaultValue) const
+{
+    return m_Type == Bool ? m_Bool : defaultValue;
+}
+
+double JsonValue::AsNumber(double defaultValue) const
+{
+    return m_Type == Number ? m_Number : defaultValue;
+}
+
+int JsonValue::AsInt(int defaultValue) const
+{
+    return m_Type == Number ? (int)m_Number : defaultValue;
+}
@@ -0,0 +1,58 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#pragma once
+
+// Minimal JSON document (RFC 8259) for reading asset metadata such as glTF.
+// Lookups never fail: a missing key or index returns a null value.
+class JsonValue
+{
+public:
+    enum Type
+    {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object
+    };
+
+    JsonValue() : m_Type(Null), m_Bool(false), m_Number(0.0) { }
+
+    // Returns false and fills error on malformed input
+    static bool Parse(const char* begin, const char* end, JsonValue& value,
+                      std::string& error);
+
+    inline Type GetType() const { return m_Type; }
+    inline bool IsNull() const { return m_Type == Null; }
+    inline bool IsNumber() const { return m_Type == Number; }
+    inline bool IsString() const { return m_Type == String; }
+    inline bool IsArray() const { return m_Type == Array; }
+    inline bool IsObject() const { return m_Type == Object; }
+
+    // Number of array elements or object members
+    inline int Size() const { return (int)m_Values.size(); }
+
+    bool             Has(const std::string& key) const;
+    const JsonValue& operator[](const std::string& key) const;
+    const JsonValue& operator[](int index) const;
+
+    bool               AsBool(bool defaultValue = false) const;
+    double             AsNumber(double defaultValue = 0.0) const;
+    int                AsInt(int defaultValue = 0) const;
+    const std::string& AsString() const { return m_String; }
+
+private:
+    Type        m_Type;
+    bool        m_Bool;
+    double      m_Number;
+    std::string m_String;
+
+    // Arrays use m_Values, objects use m_Keys and m_Values in document order
+    std::vector<std::string> m_Keys;
+    std::vector<JsonValue>   m_Values;
+
+    friend class JsonParser;
+};
@@ -4,8 +4,10 @@
 
 #pragma once
 
+#include "color.h"
 #include "geometry.h"
 #include "tgaimage.h"
+#include "utility.h"
 
 class Light
 {
@@ -46,16 +48,28 @@ class PointLight : public Light
 {
 public:
     Vector3f position;
+    Float    radius;  // local lights: no light beyond it (0: unbounded)
 
-    explicit PointLight() : Light(Vector3f(1.f)), position(0.f) { }
+    explicit PointLight() : Light(Vector3f(1.f)), position(0.f), radius(0.f) { }
 
     explicit PointLight(Float x, Float y, Float z, const Vector3f& c = Vector3f(1.f))
-        : Light(c), position(x, y, z)
+        : Light(c), position(x, y, z), radius(0.f)
     {
     }
 
-    explicit PointLight(const Vector3f& pos, const Vector3f& c = Vector3f(1.f))
-        : Light(c), position(pos)
+    explicit PointLight(const Vector3f& pos, const Vector3f& c = Vector3f(1.f),
+                        Float r = 0.f)
+        : Light(c), position(pos), radius(r)
     {
     }
 };
+
+// Falloff of a local light at a squared distance (Float or Float8): inverse square,
+// windowed to reach zero at the radius
+template <typename T>
+inline T LocalLightFalloff(const T& distance2, Float radius)
+{
+    T ratio2 = distance2 * (1.f / (radius * radius));
+    T window = Clamp01(1.f - ratio2 * ratio2);
+    return window * window / (distance2 + 1.f);
+}
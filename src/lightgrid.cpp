@@ -0,0 +1,133 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#include "lightgrid.h"
+
+#include "utility.h"
+
+LightGrid::LightGrid()
+    : m_ViewMatrix(Matrix4x4f::Identity()),
+      m_ScreenMatrix(Matrix4x4f::Identity()),
+      m_NearPlane(1.f),
+      m_SliceScale(1.f),
+      m_TilesX(0),
+      m_TilesY(0),
+      m_Offsets(1, 0)
+{
+}
+
+void LightGrid::Build(const std::vector<PointLight>& lights, const Matrix4x4f& viewMatrix,
+                      const Matrix4x4f& projectionMatrix,
+                      const Matrix4x4f& viewportMatrix, Float nearPlane, Float farPlane,
+                      int width, int height)
+{
+    m_Lights = lights;
+    m_ViewMatrix = viewMatrix;
+    m_ScreenMatrix = viewportMatrix * projectionMatrix;
+    m_NearPlane = nearPlane;
+    m_SliceScale = s_NumSlices / std::log(farPlane / nearPlane);
+    m_TilesX = (width + s_TileSize - 1) / s_TileSize;
+    m_TilesY = (height + s_TileSize - 1) / s_TileSize;
+
+    // Tiles and slices that the sphere of each light may reach (empty if none)
+    struct Bounds
+    {
+        int x0, x1, y0, y1, s0, s1;
+    };
+    std::vector<Bounds> bounds(m_Lights.size(), Bounds{ 0, -1, 0, -1, 0, -1 });
+    std::vector<int>    counts(m_TilesX * m_TilesY * s_NumSlices, 0);
+
+    for (std::size_t i = 0; i < m_Lights.size(); ++i)
+    {
+        const PointLight& light = m_Lights[i];
+        Point3f           center = (viewMatrix * Point4f(light.position, 1.f)).xyz;
+        Float             depth = -center.z;
+        Float             r = light.radius;
+        if (r <= 0.f || depth + r < nearPlane || depth - r > farPlane) continue;
+
+        // Screen bounds of its bounding box (whole screen if it crosses the near plane)
+        Bounds b = { 0, m_TilesX - 1, 0, m_TilesY - 1, getSlice(depth - r),
+                     getSlice(depth + r) };
+        if (depth - r > nearPlane)
+        {
+            Float minX = MaxFloat, maxX = -MaxFloat, minY = MaxFloat, maxY = -MaxFloat;
+            for (int c = 0; c < 8; ++c)
+            {
+                Point4f corner(center.x + ((c & 1) ? r : -r),
+                               center.y + ((c & 2) ? r : -r),
+                               center.z + ((c & 4) ? r : -r), 1.f);
+                Point4f p = m_ScreenMatrix * corner;
+                minX = Min(minX, p.x / p.w);
+                maxX = Max(maxX, p.x / p.w);
+                minY = Min(minY, p.y / p.w);
+                maxY = Max(maxY, p.y / p.w);
+            }
+            if (maxX < 0.f || maxY < 0.f || minX >= width || minY >= height) continue;
+
+            b.x0 = (int)Max(minX, 0.f) / s_TileSize;
+            b.x1 = (int)Min(maxX, width - 1.f) / s_TileSize;
+            b.y0 = (int)Max(minY, 0.f) / s_TileSize;
+            b.y1 = (int)Min(maxY, height - 1.f) / s_TileSize;
+        }
+
+        bounds[i] = b;
+        for (int s = b.s0; s <= b.s1; ++s)
+            for (int y = b.y0; y <= b.y1; ++y)
+                for (int x = b.x0; x <= b.x1; ++x)
+                    ++counts[(s * m_TilesY + y) * m_TilesX + x];
+    }
+
+    // Flat lists, in the order of the lights
+    m_Offsets.assign(counts.size() + 1, 0);
+    for (std::size_t c = 0; c < counts.size(); ++c)
+        m_Offsets[c + 1] = m_Offsets[c] + counts[c];
+
+    m_ClusterLights.resize(m_Offsets.back());
+    std::copy(m_Offsets.begin(), m_Offsets.end() - 1, counts.begin());  // cursors
+    for (std::size_t i = 0; i < m_Lights.size(); ++i)
+    {
+        const Bounds& b = bounds[i];
+        for (int s = b.s0; s <= b.s1; ++s)
+            for (int y = b.y0; y <= b.y1; ++y)
+                for (int x = b.x0; x <= b.x1; ++x)
+                    m_ClusterLights[counts[(s * m_TilesY + y) * m_TilesX + x]++] =
+                        &m_Lights[i];
+    }
+}
+
+int LightGrid::GetCluster(const Point3f& positionWS) const
+{
+    if (m_ClusterLights.empty()) return -1;
+
+    Point4f positionVS = m_ViewMatrix * Point4f(positionWS, 1.f);
+    Point4f p = m_ScreenMatrix * positionVS;
+    if (p.w <= 0.f) return -1;
+
+    int x = Clamp((int)std::floor(p.x / p.w) / s_TileSize, 0, m_TilesX - 1);
+    int y = Clamp((int)std::floor(p.y / p.w) / s_TileSize, 0, m_TilesY - 1);
+    int s = getSlice(-positionVS.z);
+    return (s * m_TilesY + y) * m_TilesX + x;
+}
+
+LightGrid::LightList LightGrid::GetLights(int cluster) const
+{
+    if (cluster < 0) return LightList{ nullptr, nullptr };
+
+    const PointLight* const* lights = m_ClusterLights.data();
+    return LightList{ lights + m_Offsets[cluster], lights + m_Offsets[cluster + 1] };
+}
+
+int LightGrid::GetMaxClusterLights() const
+{
+    int maxLights = 0;
+    for (std::size_t c = 0; c + 1 < m_Offsets.size(); ++c)
+        maxLights = Max(maxLights, m_Offsets[c + 1] - m_Offsets[c]);
+    return maxLights;
+}
+
+int LightGrid::getSlice(Float depth) const
+{
+    if (depth <= m_NearPlane) return 0;
+    return Min(s_NumSlices - 1, (int)(std::log(depth / m_NearPlane) * m_SliceScale));
+}
@@ -0,0 +1,72 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#pragma once
+
+#include "geometry.h"
+#include "light.h"
+
+// Local lights ('light local', 'light scatter') culled into clusters of the view frustum
+// each frame: screen tiles of 16x16 pixels, each split into depth slices growing
+// exponentially from the near plane to the far plane. A cluster lists the lights whose
+// sphere (position, radius) may reach it, so a shaded point only loops over the lights of
+// its own cluster.
+class LightGrid
+{
+public:
+    // Lights of a cluster (for range-based for loops)
+    struct LightList
+    {
+        const PointLight* const* first;
+        const PointLight* const* last;
+
+        const PointLight* const* begin() const { return first; }
+        const PointLight* const* end() const { return last; }
+        bool                     empty() const { return first == last; }
+    };
+
+    LightGrid();
+
+    // Lists point into the grid's copy of the lights
+    LightGrid(const LightGrid&) = delete;
+    LightGrid& operator=(const LightGrid&) = delete;
+
+    // Culls the lights for a view (the matrices and screen size of the rasterizer)
+    void Build(const std::vector<PointLight>& lights, const Matrix4x4f& viewMatrix,
+               const Matrix4x4f& projectionMatrix, const Matrix4x4f& viewportMatrix,
+               Float nearPlane, Float farPlane, int width, int height);
+
+    inline bool IsEmpty() const { return m_Lights.empty(); }
+
+    // Cluster of a world space point, -1 if outside of the view frustum
+    int       GetCluster(const Point3f& positionWS) const;
+    LightList GetLights(int cluster) const;
+    LightList GetLights(const Point3f& positionWS) const
+    {
+        return GetLights(GetCluster(positionWS));
+    }
+
+    // Culling Statistics
+    inline int         GetNumLights() const { return (int)m_Lights.size(); }
+    inline int         GetNumClusters() const { return (int)m_Offsets.size() - 1; }
+    inline std::size_t GetNumEntries() const { return m_ClusterLights.size(); }
+    int                GetMaxClusterLights() const;
+
+private:
+    static const int s_TileSize = 16;  // pixels
+    static const int s_NumSlices = 16;
+
+    std::vector<PointLight> m_Lights;
+    Matrix4x4f              m_ViewMatrix;
+    Matrix4x4f              m_ScreenMatrix;  // view space -> screen space (homogeneous)
+    Float                   m_NearPlane;
+    Float                   m_SliceScale;  // slices per log(depth / near)
+    int                     m_TilesX, m_TilesY;
+
+    // Lights of cluster i: m_ClusterLights[m_Offsets[i], m_Offsets[i + 1])
+    std::vector<int>               m_Offsets;
+    std::vector<const PointLight*> m_ClusterLights;
+
+    int getSlice(Float depth) const;
+};
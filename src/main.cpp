@@ -1,7 +1,9 @@
 #include <spdlog/spdlog.h>
 #include <spdlog/stopwatch.h>
 
+#include "filewatcher.h"
 #include "output.h"
+#include "packarchive.h"
 #include "render.h"
 #include "utility.h"
 
@@ -15,24 +17,9 @@ static void InitSpdLog()
     spdlog::set_level(spdlog::level::debug);
 }
 
-int main(int argc, const char* argv[])
+// Render one frame and write the buffers
+static void RenderScene(const Scene& scene)
 {
-    // Input
-    if (argc != 2)
-    {
-        std::cerr << "Required: 1 argument, but given " << argc - 1 << std::endl;
-        std::cerr << "Usage: ./ForkerRenderer <scene file>" << std::endl;
-        return 1;
-    }
-    std::string sceneFileName = argv[1];
-
-    // Spdlog
-    InitSpdLog();
-
-    // Scene
-    Scene scene(sceneFileName);
-    TimeElapsed(stepStopwatch, "Scene Loaded");
-
     // Preconfiguration
     Render::Preconfigure(scene);
 
@@ -50,6 +37,81 @@ int main(int argc, const char* argv[])
     Output::OutputParamGBuffer();
     Output::OutputShadingTypeGBuffer();
     Output::OutputAmbientOcclusionGBuffer();
+}
+
+// Watch: keep the scene resident, reload what changed and render again (until killed)
+static void WatchScene(const std::string& sceneFileName)
+{
+    std::unique_ptr<Scene> scene = std::make_unique<Scene>(sceneFileName);
+    TimeElapsed(stepStopwatch, "Scene Loaded");
+
+    FileWatcher watcher;
+    while (true)
+    {
+        RenderScene(*scene);
+
+        std::vector<std::string> files;
+        scene->GetSourceFiles(files);
+        watcher.Watch(files);
+        spdlog::info("Watching {} files ({})", files.size(), watcher.GetBackendName());
+
+        std::vector<std::string> changed = watcher.WaitForChanges();
+        stepStopwatch.reset();
+
+        // The scene file may add or remove anything, it is loaded again as a whole
+        if (std::find(changed.begin(), changed.end(), sceneFileName) != changed.end())
+        {
+            spdlog::info("Scene file changed, loading the scene again");
+            scene.reset();
+            scene = std::make_unique<Scene>(sceneFileName);
+        }
+        else
+        {
+            spdlog::info("Reloading {} changed files:", changed.size());
+            scene->Reload(changed);
+        }
+        TimeElapsed(stepStopwatch, "Scene Reloaded");
+    }
+}
+
+int main(int argc, const char* argv[])
+{
+    // Input
+    bool packing = argc == 4 && std::string(argv[1]) == "--pack";
+    bool watching = argc == 3 && std::string(argv[1]) == "--watch";
+    if (argc != 2 && !packing && !watching)
+    {
+        std::cerr << "Required: 1 argument, but given " << argc - 1 << std::endl;
+        std::cerr << "Usage: ./ForkerRenderer <scene file | pack archive>" << std::endl;
+        std::cerr << "       ./ForkerRenderer --watch <scene file>" << std::endl;
+        std::cerr << "       ./ForkerRenderer --pack <scene file> <pack archive>"
+                  << std::endl;
+        return 1;
+    }
+    std::string sceneFileName = argc == 2 ? argv[1] : argv[2];
+
+    // Spdlog
+    InitSpdLog();
+
+    // Pack: load the scene once, recording what it reads
+    if (packing)
+    {
+        PackArchive::BeginRecording();
+        Scene scene(sceneFileName);
+        return PackArchive::WriteRecorded(argv[3], sceneFileName) ? 0 : 1;
+    }
+
+    if (watching)
+    {
+        WatchScene(sceneFileName);
+        return 0;
+    }
+
+    // Scene
+    Scene scene(sceneFileName);
+    TimeElapsed(stepStopwatch, "Scene Loaded");
+
+    RenderScene(scene);
 
     return 0;
 }
@@ -0,0 +1,141 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#include "mappedfile.h"
+
+#include <spdlog/spdlog.h>
+
+#include <sys/stat.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define FORKER_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+bool GetFileStat(const std::string& filename, std::uint64_t& size, std::int64_t& mtime)
+{
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0) return false;
+    size = (std::uint64_t)st.st_size;
+    mtime = (std::int64_t)st.st_mtime;
+    return true;
+}
+
+std::uint64_t HashFile(const std::string& filename)
+{
+    MappedFile file;
+    if (!file.Open(filename)) return 0;
+
+    std::uint64_t       hash = 14695981039346656037ull;
+    const std::uint8_t* data = file.GetData();
+    for (std::size_t i = 0; i < file.GetSize(); ++i)
+    {
+        hash = (hash ^ data[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const std::string& filename, AccessMode mode)
+{
+    Close();
+
+#ifdef FORKER_HAS_MMAP
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    int   prot = (mode == CopyOnWrite) ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    void* addr = mmap(nullptr, (std::size_t)st.st_size, prot, MAP_PRIVATE, fd, 0);
+    close(fd);  // the mapping keeps its own reference
+
+    if (addr != MAP_FAILED)
+    {
+        m_Data = static_cast<std::uint8_t*>(addr);
+        m_Size = (std::size_t)st.st_size;
+        m_Mapped = true;
+        return true;
+    }
+    spdlog::warn("mmap failed for \'{}\', reading it instead", filename);
+#endif
+
+    std::ifstream in(filename, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) return false;
+
+    std::streamoff size = in.tellg();
+    if (size <= 0) return false;
+
+    m_Buffer.resize((std::size_t)size);
+    in.seekg(0, std::ios::beg);
+    if (!in.read(reinterpret_cast<char*>(m_Buffer.data()), size))
+    {
+        m_Buffer.clear();
+        return false;
+    }
+    m_Data = m_Buffer.data();
+    m_Size = m_Buffer.size();
+    return true;
+}
+
+bool MappedFile::OpenSharedMemory(const std::string& name)
+{
+    Close();
+
+#ifdef FORKER_HAS_MMAP
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* addr = mmap(nullptr, (std::size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) return false;
+
+    m_Data = static_cast<std::uint8_t*>(addr);
+    m_Size = (std::size_t)st.st_size;
+    m_Mapped = true;
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool MappedFile::OpenBuffer(std::vector<std::uint8_t> buffer)
+{
+    Close();
+    if (buffer.empty()) return false;
+
+    m_Buffer = std::move(buffer);
+    m_Data = m_Buffer.data();
+    m_Size = m_Buffer.size();
+    return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef FORKER_HAS_MMAP
+    if (m_Mapped) munmap(m_Data, m_Size);
+#endif
+    m_Buffer = std::vector<std::uint8_t>();
+    m_Data = nullptr;
+    m_Size = 0;
+    m_Mapped = false;
+}
@@ -0,0 +1,49 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#pragma once
+
+// Size and modification time, used to detect stale derived files
+bool GetFileStat(const std::string& filename, std::uint64_t& size, std::int64_t& mtime);
+
+// FNV-1a hash of the file content, 0 if unreadable
+std::uint64_t HashFile(const std::string& filename);
+
+// Whole-file memory mapping. Pages are loaded by the OS on first access, so typed
+// views into the mapping cost nothing until they are read. Without mmap support the
+// file is read into an owned buffer instead.
+class MappedFile
+{
+public:
+    enum AccessMode
+    {
+        ReadOnly,
+        CopyOnWrite  // writable, changes stay private to this process
+    };
+
+    MappedFile() : m_Data(nullptr), m_Size(0), m_Mapped(false) { }
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& filename, AccessMode mode = ReadOnly);
+    // Read-only mapping of a POSIX shared memory object (name starts with '/')
+    bool OpenSharedMemory(const std::string& name);
+    // Takes over data that is already in memory (e.g. an archive entry)
+    bool OpenBuffer(std::vector<std::uint8_t> buffer);
+    void Close();
+
+    inline bool                IsOpen() const { return m_Data != nullptr; }
+    inline bool                IsMapped() const { return m_Mapped; }
+    inline const std::uint8_t* GetData() const { return m_Data; }
+    inline std::uint8_t*       GetMutableData() { return m_Data; }  // CopyOnWrite only
+    inline std::size_t         GetSize() const { return m_Size; }
+
+private:
+    std::uint8_t*             m_Data;
+    std::size_t               m_Size;
+    bool                      m_Mapped;
+    std::vector<std::uint8_t> m_Buffer;  // fallback storage
+};
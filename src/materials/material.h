@@ -10,6 +10,17 @@
 #include "stringprint.h"
 #include "texture.h"
 
+// Material resolved for a draw (Shader::Use): plain values and raw texture pointers, read
+// by the shaders without reference counting. Valid while the material lives.
+struct MaterialRecord
+{
+    Vector3f       ka, kd, ks, ke;
+    const Texture* diffuseMap;
+    const Texture* specularMap;
+    const Texture* normalMap;
+    const Texture* emissiveMap;
+};
+
 class Material
 {
 public:
@@ -38,6 +49,18 @@ public:
     inline bool HasSpecularMap() const { return specularMap != nullptr; }
     inline bool HasNormalMap() const { return normalMap != nullptr; }
     inline bool HasEmissiveMap() const { return emissiveMap != nullptr; }
+
+    MaterialRecord GetRecord() const
+    {
+        return MaterialRecord{ ka,
+                               kd,
+                               ks,
+                               ke,
+                               diffuseMap.get(),
+                               specularMap.get(),
+                               normalMap.get(),
+                               emissiveMap.get() };
+    }
 };
 
 inline std::ostream& operator<<(std::ostream& out, const Material& m)
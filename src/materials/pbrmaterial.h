@@ -10,6 +10,22 @@
 #include "stringprint.h"
 #include "texture.h"
 
+// PBRMaterial resolved for a draw (see MaterialRecord)
+struct PBRMaterialRecord
+{
+    Vector3f       ke;
+    Vector3f       albedo;
+    Float          roughness;
+    Float          metalness;
+    const Texture* baseColorMap;
+    const Texture* ormMap;  // AO, roughness and metalness (GetOrmMap)
+    const Texture* normalMap;
+    const Texture* emissiveMap;
+    int            roughnessChannel;
+    int            metalnessChannel;
+    int            aoChannel;
+};
+
 class PBRMaterial
 {
 public:
@@ -21,7 +37,8 @@ public:
     explicit PBRMaterial(std::string name)
         : name(std::move(name)), ka(0.f), ke(0.f), albedo(1.f), roughness(0.f), metalness(0.f),
           baseColorMap(nullptr), roughnessMap(nullptr), metalnessMap(nullptr),
-          ambientOcclusionMap(nullptr), emissiveMap(nullptr)
+          ambientOcclusionMap(nullptr), emissiveMap(nullptr),
+          roughnessChannel(2), metalnessChannel(2), aoChannel(2)
     { }
     // clang-format on
     Vector3f ka;
@@ -37,12 +54,40 @@ public:
     std::shared_ptr<Texture> normalMap;
     std::shared_ptr<Texture> emissiveMap;
 
+    // Channel read from the scalar maps (packed glTF maps: AO R, roughness G, metal B)
+    int roughnessChannel;
+    int metalnessChannel;
+    int aoChannel;
+
     inline bool HasBaseColorMap() const { return baseColorMap != nullptr; }
     inline bool HasRoughnessMap() const { return roughnessMap != nullptr; }
     inline bool HasMetalnessMap() const { return metalnessMap != nullptr; }
     inline bool HasAmbientOcclusionMap() const { return ambientOcclusionMap != nullptr; }
     inline bool HasNormalMap() const { return normalMap != nullptr; }
     inline bool HasEmssiveMap() const { return emissiveMap != nullptr; }
+
+    // AO, roughness and metalness maps share one texture (packed by the file, or by the
+    // model at load), so one fetch returns all three. nullptr if none is mapped.
+    inline const std::shared_ptr<Texture>& GetOrmMap() const
+    {
+        if (ambientOcclusionMap) return ambientOcclusionMap;
+        return roughnessMap ? roughnessMap : metalnessMap;
+    }
+
+    PBRMaterialRecord GetRecord() const
+    {
+        return PBRMaterialRecord{ ke,
+                                  albedo,
+                                  roughness,
+                                  metalness,
+                                  baseColorMap.get(),
+                                  GetOrmMap().get(),
+                                  normalMap.get(),
+                                  emissiveMap.get(),
+                                  roughnessChannel,
+                                  metalnessChannel,
+                                  aoChannel };
+    }
 };
 
 inline std::ostream& operator<<(std::ostream& out, const PBRMaterial& m)
@@ -9,12 +9,9 @@
 
 void Mesh::Draw(Shader& shader) const
 {
-    // For each face
+    // For each face (the shader uses this mesh, see Model::Render)
     for (int f = 0; f < NumFaces(); ++f)
     {
-        // Use Shader To Set Mesh Pointer
-        shader.Use(shared_from_this());
-
         Point4f ndcCoords[3];
         for (int v = 0; v < 3; ++v)  // for each vertex
         {
@@ -28,38 +25,145 @@ void Mesh::Draw(Shader& shader) const
 
 int Mesh::NumFaces() const
 {
+    if (HasViews()) return m_Views.indices.GetCount() / 3;
     return (int)m_FaceVertIndices.size() / 3;
 }
 
 Vector3f Mesh::Vert(int faceIdx, int vertIdx) const
 {
+    if (HasViews()) return m_Views.positions.GetVector3(GetVertIndex(faceIdx, vertIdx));
     int index = m_FaceVertIndices[faceIdx * 3 + vertIdx];
     return GetModel().GetVert(index);
 }
 
 Vector2f Mesh::TexCoord(int faceIdx, int vertIdx) const
 {
+    if (m_Views.texCoords.IsValid())
+        return m_Views.texCoords.GetVector2(GetVertIndex(faceIdx, vertIdx));
     int index = m_FaceTexCoordIndices[faceIdx * 3 + vertIdx];
     return GetModel().GetTexCoord(index);
 }
 
 Vector3f Mesh::Normal(int faceIdx, int vertIdx) const
 {
+    if (m_Views.normals.IsValid())
+        return Normalize(m_Views.normals.GetVector3(GetVertIndex(faceIdx, vertIdx)));
     int index = m_FaceNormalIndices[faceIdx * 3 + vertIdx];
     return Normalize(GetModel().GetNormal(index));
 }
 
 Vector3f Mesh::Tangent(int faceIdx, int vertIdx) const
 {
+    if (m_Views.tangents.IsValid())
+        return Normalize(m_Views.tangents.GetVector3(GetVertIndex(faceIdx, vertIdx)));
     int index = m_FaceTangentIndices[faceIdx * 3 + vertIdx];
     return Normalize(GetModel().GetTangent(index));
 }
 
 int Mesh::GetVertIndex(int faceIdx, int vertIdx) const
 {
+    if (HasViews()) return m_Views.indices[faceIdx * 3 + vertIdx];
     return m_FaceVertIndices[faceIdx * 3 + vertIdx];
 }
 
+int Mesh::GetTexCoordIndex(int faceIdx, int vertIdx) const
+{
+    return m_FaceTexCoordIndices[faceIdx * 3 + vertIdx];
+}
+
+int Mesh::GetNormalIndex(int faceIdx, int vertIdx) const
+{
+    return m_FaceNormalIndices[faceIdx * 3 + vertIdx];
+}
+
+int Mesh::GetTangentIndex(int faceIdx, int vertIdx) const
+{
+    return m_FaceTangentIndices[faceIdx * 3 + vertIdx];
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+void Mesh::ComputeBounds()
+{
+    m_BoundsMin = Point3f(MaxFloat);
+    m_BoundsMax = Point3f(-MaxFloat);
+    for (int f = 0; f < NumFaces(); ++f)
+    {
+        for (int v = 0; v < 3; ++v)
+        {
+            Vector3f p = Vert(f, v);
+            for (int i = 0; i < 3; ++i)
+            {
+                m_BoundsMin[i] = Min(m_BoundsMin[i], p[i]);
+                m_BoundsMax[i] = Max(m_BoundsMax[i], p[i]);
+            }
+        }
+    }
+}
+
+bool Mesh::IsVisible(const Matrix4x4f& mvp) const
+{
+    if (NumFaces() == 0) return false;
+    return IsBoxVisible(mvp, m_BoundsMin, m_BoundsMax);
+}
+
+bool Mesh::IsBoxVisible(const Matrix4x4f& mvp, const Point3f& boundsMin,
+                        const Point3f& boundsMax)
+{
+    // Culled only if all 8 corners are outside of the same clip plane
+    int outside[6] = { 0, 0, 0, 0, 0, 0 };
+    for (int c = 0; c < 8; ++c)
+    {
+        Point4f corner((c & 1) ? boundsMax.x : boundsMin.x,
+                       (c & 2) ? boundsMax.y : boundsMin.y,
+                       (c & 4) ? boundsMax.z : boundsMin.z, 1.f);
+        Point4f clip = mvp * corner;
+        outside[0] += clip.x < -clip.w;
+        outside[1] += clip.x > clip.w;
+        outside[2] += clip.y < -clip.w;
+        outside[3] += clip.y > clip.w;
+        outside[4] += clip.z < -clip.w;
+        outside[5] += clip.z > clip.w;
+    }
+    for (int p = 0; p < 6; ++p)
+    {
+        if (outside[p] == 8) return false;
+    }
+    return true;
+}
+
+void Mesh::CollectTextures(bool pbr, std::unordered_set<const Texture*>& textures) const
+{
+    CollectMaterialTextures(*GetMaterial(), *GetPBRMaterial(), pbr,
+                            GetModel().HasTangents(), textures);
+}
+
+void Mesh::CollectMaterialTextures(const Material& material, const PBRMaterial& pbrMaterial,
+                                   bool pbr, bool hasTangents,
+                                   std::unordered_set<const Texture*>& textures)
+{
+    // Keep in sync with the texture usage in the fragment shaders
+    std::vector<const Texture*> used;
+    if (pbr)
+    {
+        const PBRMaterial& m = pbrMaterial;
+        used = { m.baseColorMap.get(), m.roughnessMap.get(), m.metalnessMap.get(),
+                 m.ambientOcclusionMap.get(), m.emissiveMap.get() };
+        if (hasTangents) used.push_back(m.normalMap.get());
+    }
+    else
+    {
+        const Material& m = material;
+        used = { m.diffuseMap.get(), m.specularMap.get(), m.emissiveMap.get() };
+        if (hasTangents) used.push_back(m.normalMap.get());
+    }
+
+    for (const Texture* texture : used)
+    {
+        if (texture) textures.insert(texture);
+    }
+}
+
 /////////////////////////////////////////////////////////////////////////////////
 
 void Mesh::AddVertIndex(int index)
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "bufferview.h"
 #include "color.h"
 #include "geometry.h"
 #include "material.h"
@@ -21,7 +22,7 @@ public:
     // Copy Constructor
     explicit Mesh(const Mesh& m) = delete;
 
-    // Model will call it in its Render()
+    // Model will call it in its Render(), after Shader::Use(mesh)
     void Draw(Shader& shader) const;
 
     // Vertex Properties
@@ -31,6 +32,22 @@ public:
     Vector3f Normal(int faceIdx, int vertIdx) const;
     Vector3f Tangent(int faceIdx, int vertIdx) const;
     int      GetVertIndex(int faceIdx, int vertIdx) const;
+    int      GetTexCoordIndex(int faceIdx, int vertIdx) const;  // without views only
+    int      GetNormalIndex(int faceIdx, int vertIdx) const;
+    int      GetTangentIndex(int faceIdx, int vertIdx) const;
+
+    // Bounding Box (object space) & Visibility
+    void        ComputeBounds();
+    bool        IsVisible(const Matrix4x4f& mvp) const;
+    static bool IsBoxVisible(const Matrix4x4f& mvp, const Point3f& boundsMin,
+                             const Point3f& boundsMax);
+
+    // Textures sampled by the PBR or Blinn-Phong path
+    void        CollectTextures(bool pbr, std::unordered_set<const Texture*>& textures) const;
+    static void CollectMaterialTextures(const Material& material,
+                                        const PBRMaterial& pbrMaterial, bool pbr,
+                                        bool                                hasTangents,
+                                        std::unordered_set<const Texture*>& textures);
 
     // Helper
     const Model&                       GetModel() const { return m_Model; }
@@ -48,6 +65,12 @@ public:
     void AddNormalIndex(int index);
     void AddTangentIndex(int index);
 
+    // Attributes read in place from an external buffer (.glb). Missing normals,
+    // texture coordinates or tangents fall back to the index lists above.
+    void                  SetViews(const PrimitiveViews& views) { m_Views = views; }
+    const PrimitiveViews& GetViews() const { return m_Views; }
+    inline bool           HasViews() const { return m_Views.positions.IsValid(); }
+
 private:
     // Model and material are set right after Mesh creation
     const Model&                     m_Model;
@@ -59,4 +82,8 @@ private:
     std::vector<int> m_FaceTexCoordIndices;
     std::vector<int> m_FaceNormalIndices;  // 3 vertices form a triangle
     std::vector<int> m_FaceTangentIndices;
+    PrimitiveViews   m_Views;
+
+    Point3f m_BoundsMin;
+    Point3f m_BoundsMax;
 };
@@ -0,0 +1,402 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#include "meshstream.h"
+
+#include <spdlog/spdlog.h>
+
+#include "mappedfile.h"
+
+static const char          s_ChunkFileMagic[4] = { 'F', 'K', 'M', 'S' };
+static const std::uint32_t s_ChunkFileVersion = 1;
+static const std::uint32_t s_FlagTangents = 0x1;
+
+#pragma pack(push, 1)
+struct ChunkFileHeader
+{
+    char          magic[4];
+    std::uint32_t version;
+    std::uint32_t flags;
+    std::uint32_t facesPerChunk;
+    std::uint32_t numChunks;
+    std::uint32_t numGroups;
+    std::uint64_t sourceSize;
+    std::int64_t  sourceMtime;
+};
+
+struct ChunkHeader
+{
+    std::uint32_t groupIndex;
+    std::uint32_t numFaces;
+};
+#pragma pack(pop)
+
+/////////////////////////////////////////////////////////////////////////////////
+
+static void writeString(std::ofstream& out, const std::string& str)
+{
+    std::uint32_t length = (std::uint32_t)str.size();
+    out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.write(str.data(), length);
+}
+
+static bool readString(std::ifstream& in, std::string& str)
+{
+    std::uint32_t length = 0;
+    in.read(reinterpret_cast<char*>(&length), sizeof(length));
+    if (!in.good()) return false;
+    str.resize(length);
+    in.read(&str[0], length);
+    return in.good();
+}
+
+// Parse "f v/t/n v/t/n v/t/n ..." into zero-based indices
+static void parseFace(const std::string& line, std::vector<Vector3i>& vertices)
+{
+    std::istringstream iss(line.c_str());
+    char               chTrash;
+    unsigned int       v, t, n;
+    vertices.clear();
+    iss >> chTrash;  // skip 'f' and ' '
+    while (iss >> v >> chTrash >> t >> chTrash >> n)  // f 24/1/24 25/2/25 26/3/26
+    {
+        vertices.push_back(Vector3i(--v, --t, --n));
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+bool MeshStream::Cook(const std::string& objFilename, const std::string& chunkFilename,
+                      bool generateTangent, std::uint32_t facesPerChunk)
+{
+    std::ifstream in;
+    in.open(objFilename, std::ifstream::in);
+
+    if (in.fail())
+    {
+        spdlog::error("Failed to open the .obj file");
+        return false;
+    }
+
+    std::vector<Vector3f> verts;
+    std::vector<Vector2f> texCoords;
+    std::vector<Vector3f> normals;
+    std::vector<Vector3f> tangents;
+
+    std::string                          mtlFilename;
+    std::vector<StreamGroup>             groups;
+    std::unordered_map<std::string, int> groupIndices;
+    std::vector<Vector3i>                faceVertices;
+
+    auto findGroup = [&](const std::string& meshName) {
+        auto iter = groupIndices.find(meshName);
+        if (iter != groupIndices.end()) return iter->second;
+
+        StreamGroup group;
+        group.meshName = meshName;
+        group.numFaces = 0;
+        group.boundsMin = Point3f(MaxFloat);
+        group.boundsMax = Point3f(-MaxFloat);
+        groups.push_back(group);
+        groupIndices[meshName] = (int)groups.size() - 1;
+        return (int)groups.size() - 1;
+    };
+
+    // Pass 1: vertex attributes, groups, bounds and tangent accumulation
+    std::string line;
+    int         currentGroup = -1;
+    while (!in.eof())
+    {
+        std::getline(in, line);
+        line = Ltrim(line);
+        std::istringstream iss(line.c_str());
+
+        // Trash
+        char        chTrash;
+        std::string strTrash;
+
+        if (line.compare(0, 7, "mtllib ") == 0)  // mtllib
+        {
+            iss >> strTrash >> mtlFilename;
+        }
+        else if (line.compare(0, 2, "v ") == 0)  // v
+        {
+            iss >> strTrash;
+            Vector3f vertex;
+            iss >> vertex.x >> vertex.y >> vertex.z;
+            verts.push_back(vertex);
+        }
+        else if (line.compare(0, 3, "vt ") == 0)  // vt
+        {
+            iss >> strTrash;
+            Vector2f texCoord;
+            iss >> texCoord.x >> texCoord.y;
+            texCoords.push_back(texCoord);
+        }
+        else if (line.compare(0, 3, "vn ") == 0)  // vn
+        {
+            iss >> strTrash;
+            Vector3f normal;
+            iss >> normal.x >> normal.y >> normal.z;
+            normals.push_back(normal);
+        }
+        else if (line.compare(0, 2, "g ") == 0)  // g
+        {
+            std::string meshName;
+            iss >> chTrash >> meshName;
+            currentGroup = findGroup(meshName);
+        }
+        else if (line.compare(0, 7, "usemtl ") == 0)  // usemtl
+        {
+            if (currentGroup < 0) currentGroup = findGroup("default");
+            iss >> strTrash >> groups[currentGroup].materialName;
+        }
+        else if (line.compare(0, 2, "f ") == 0)  // f
+        {
+            if (currentGroup < 0) currentGroup = findGroup("default");
+            parseFace(line, faceVertices);
+
+            StreamGroup& group = groups[currentGroup];
+            for (const Vector3i& vertex : faceVertices)
+            {
+                const Vector3f& p = verts[vertex.x];
+                for (int i = 0; i < 3; ++i)
+                {
+                    group.boundsMin[i] = Min(group.boundsMin[i], p[i]);
+                    group.boundsMax[i] = Max(group.boundsMax[i], p[i]);
+                }
+            }
+
+            for (int i = 1; i < (int)faceVertices.size() - 1; ++i)
+            {
+                ++group.numFaces;
+                if (!generateTangent) continue;
+
+                // Same as Model::generateTangents(), accumulated per position index
+                const Vector3i& v0 = faceVertices[0];
+                const Vector3i& v1 = faceVertices[i];
+                const Vector3i& v2 = faceVertices[i + 1];
+                Vector3f        edge1 = verts[v1.x] - verts[v0.x];
+                Vector3f        edge2 = verts[v2.x] - verts[v0.x];
+                Vector2f        deltaUv1 = texCoords[v1.y] - texCoords[v0.y];
+                Vector2f        deltaUv2 = texCoords[v2.y] - texCoords[v0.y];
+                Float           det = deltaUv1.s * deltaUv2.t - deltaUv2.s * deltaUv1.t;
+                if (det == 0.f) continue;
+
+                Float    inv = 1.f / det;
+                Vector3f T = Normalize(
+                    inv * Vector3f(deltaUv2.t * edge1.x - deltaUv1.t * edge2.x,
+                                   deltaUv2.t * edge1.y - deltaUv1.t * edge2.y,
+                                   deltaUv2.t * edge1.z - deltaUv1.t * edge2.z));
+                if (tangents.size() < verts.size()) tangents.resize(verts.size());
+                tangents[v0.x] += T;
+                tangents[v1.x] += T;
+                tangents[v2.x] += T;
+            }
+        }
+    }
+    in.close();
+
+    // Average Tangents
+    if (generateTangent)
+    {
+        tangents.resize(verts.size());
+        for (auto& v : tangents)
+        {
+            if (v.Length() == 0.f)
+                v = Vector3f(1, 0, 0);  // random (to be improved)
+            else
+                v = Normalize(v);
+        }
+    }
+
+    // Header & Group Table
+    std::ofstream out;
+    out.open(chunkFilename, std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+    {
+        spdlog::error("Cannot write the chunk file: \'{}\'", chunkFilename);
+        return false;
+    }
+
+    ChunkFileHeader header;
+    memcpy(header.magic, s_ChunkFileMagic, sizeof(header.magic));
+    header.version = s_ChunkFileVersion;
+    header.flags = generateTangent ? s_FlagTangents : 0;
+    header.facesPerChunk = facesPerChunk;
+    header.numChunks = 0;
+    header.numGroups = (std::uint32_t)groups.size();
+    GetFileStat(objFilename, header.sourceSize, header.sourceMtime);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    writeString(out, mtlFilename);
+    for (const StreamGroup& group : groups)
+    {
+        writeString(out, group.meshName);
+        writeString(out, group.materialName);
+        out.write(reinterpret_cast<const char*>(&group.numFaces), sizeof(group.numFaces));
+        float bounds[6] = { group.boundsMin.x, group.boundsMin.y, group.boundsMin.z,
+                            group.boundsMax.x, group.boundsMax.y, group.boundsMax.z };
+        out.write(reinterpret_cast<const char*>(bounds), sizeof(bounds));
+    }
+
+    // Pass 2: emit de-indexed triangles in batches
+    std::vector<StreamVertex> pending;
+    pending.reserve((size_t)facesPerChunk * 3);
+    int pendingGroup = -1;
+
+    auto flush = [&]() {
+        if (pending.empty()) return;
+        ChunkHeader chunk;
+        chunk.groupIndex = (std::uint32_t)pendingGroup;
+        chunk.numFaces = (std::uint32_t)(pending.size() / 3);
+        out.write(reinterpret_cast<const char*>(&chunk), sizeof(chunk));
+        out.write(reinterpret_cast<const char*>(pending.data()),
+                  pending.size() * sizeof(StreamVertex));
+        pending.clear();
+        ++header.numChunks;
+    };
+
+    auto makeVertex = [&](const Vector3i& index) {
+        StreamVertex vertex;
+        const Vector3f& p = verts[index.x];
+        const Vector2f& t = texCoords[index.y];
+        const Vector3f& n = normals[index.z];
+        Vector3f        tg = generateTangent ? tangents[index.x] : Vector3f(0.f);
+        for (int i = 0; i < 3; ++i)
+        {
+            vertex.position[i] = p[i];
+            vertex.normal[i] = n[i];
+            vertex.tangent[i] = tg[i];
+        }
+        vertex.texCoord[0] = t.x;
+        vertex.texCoord[1] = t.y;
+        return vertex;
+    };
+
+    in.open(objFilename, std::ifstream::in);
+    currentGroup = -1;
+    while (!in.eof())
+    {
+        std::getline(in, line);
+        line = Ltrim(line);
+
+        if (line.compare(0, 2, "g ") == 0)  // g
+        {
+            std::istringstream iss(line.c_str());
+            char               chTrash;
+            std::string        meshName;
+            iss >> chTrash >> meshName;
+            currentGroup = groupIndices[meshName];
+        }
+        else if (line.compare(0, 2, "f ") == 0)  // f
+        {
+            if (currentGroup < 0) currentGroup = groupIndices["default"];
+            if (currentGroup != pendingGroup) flush();
+            pendingGroup = currentGroup;
+
+            parseFace(line, faceVertices);
+            for (int i = 1; i < (int)faceVertices.size() - 1; ++i)
+            {
+                pending.push_back(makeVertex(faceVertices[0]));
+                pending.push_back(makeVertex(faceVertices[i]));
+                pending.push_back(makeVertex(faceVertices[i + 1]));
+                if (pending.size() / 3 >= facesPerChunk) flush();
+            }
+        }
+    }
+    flush();
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    if (!out.good())
+    {
+        spdlog::error("Cannot write the chunk file: \'{}\'", chunkFilename);
+        return false;
+    }
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+bool MeshStream::Open(const std::string& chunkFilename, const std::string& objFilename,
+                      bool generateTangent)
+{
+    m_In.open(chunkFilename, std::ios::binary);
+    if (!m_In.is_open()) return false;
+
+    ChunkFileHeader header;
+    m_In.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!m_In.good() || memcmp(header.magic, s_ChunkFileMagic, sizeof(header.magic)) != 0 ||
+        header.version != s_ChunkFileVersion)
+    {
+        return false;
+    }
+
+    // Stale if the source has changed (or is not available to compare with)
+    std::uint64_t sourceSize;
+    std::int64_t  sourceMtime;
+    if (!objFilename.empty())
+    {
+        if (!GetFileStat(objFilename, sourceSize, sourceMtime)) return false;
+        if (sourceSize != header.sourceSize || sourceMtime != header.sourceMtime)
+            return false;
+    }
+    if (generateTangent && !(header.flags & s_FlagTangents)) return false;
+
+    m_FacesPerChunk = header.facesPerChunk;
+    m_NumChunks = header.numChunks;
+
+    if (!readString(m_In, m_MtlFilename)) return false;
+
+    m_Groups.resize(header.numGroups);
+    for (StreamGroup& group : m_Groups)
+    {
+        float bounds[6];
+        readString(m_In, group.meshName);
+        readString(m_In, group.materialName);
+        m_In.read(reinterpret_cast<char*>(&group.numFaces), sizeof(group.numFaces));
+        m_In.read(reinterpret_cast<char*>(bounds), sizeof(bounds));
+        group.boundsMin = Point3f(bounds[0], bounds[1], bounds[2]);
+        group.boundsMax = Point3f(bounds[3], bounds[4], bounds[5]);
+    }
+    return m_In.good();
+}
+
+bool MeshStream::ReadChunk(int& groupIndex, std::vector<StreamVertex>& vertices)
+{
+    ChunkHeader chunk;
+    m_In.read(reinterpret_cast<char*>(&chunk), sizeof(chunk));
+    if (!m_In.good() || chunk.groupIndex >= m_Groups.size()) return false;
+
+    groupIndex = (int)chunk.groupIndex;
+    vertices.resize((size_t)chunk.numFaces * 3);
+    m_In.read(reinterpret_cast<char*>(vertices.data()),
+              vertices.size() * sizeof(StreamVertex));
+    return m_In.good();
+}
+
+std::uint64_t MeshStream::GetNumFaces() const
+{
+    std::uint64_t total = 0;
+    for (const StreamGroup& group : m_Groups)
+        total += group.numFaces;
+    return total;
+}
+
+void MeshStream::GetBounds(Point3f& boundsMin, Point3f& boundsMax) const
+{
+    boundsMin = Point3f(MaxFloat);
+    boundsMax = Point3f(-MaxFloat);
+    for (const StreamGroup& group : m_Groups)
+    {
+        if (group.numFaces == 0) continue;
+        for (int i = 0; i < 3; ++i)
+        {
+            boundsMin[i] = Min(boundsMin[i], group.boundsMin[i]);
+            boundsMax[i] = Max(boundsMax[i], group.boundsMax[i]);
+        }
+    }
+}
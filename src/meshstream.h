@@ -0,0 +1,61 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#pragma once
+
+#include "geometry.h"
+
+// Cooked, chunked mesh file for out-of-core rendering. Each chunk holds a batch of
+// de-indexed triangles of one mesh group, so it can be drawn and released without
+// random access to the rest of the model.
+//
+// Layout: [FileHeader] [mtllib] [groups...] [ChunkHeader vertices...]...
+
+struct StreamVertex
+{
+    float position[3];
+    float texCoord[2];
+    float normal[3];
+    float tangent[3];
+};
+
+struct StreamGroup
+{
+    std::string   meshName;
+    std::string   materialName;
+    std::uint64_t numFaces;
+    Point3f       boundsMin;  // object space, before normalization
+    Point3f       boundsMax;
+};
+
+class MeshStream
+{
+public:
+    // Converts .obj faces into chunks of at most facesPerChunk triangles. The vertex
+    // attribute arrays (not the faces) have to fit in memory while cooking.
+    static bool Cook(const std::string& objFilename, const std::string& chunkFilename,
+                     bool generateTangent, std::uint32_t facesPerChunk);
+
+    MeshStream() = default;
+
+    // Reads header and group table, false if missing or not made from this source
+    bool Open(const std::string& chunkFilename, const std::string& objFilename,
+              bool generateTangent);
+    // Reads the next chunk, false at the end of the file
+    bool ReadChunk(int& groupIndex, std::vector<StreamVertex>& vertices);
+
+    const std::vector<StreamGroup>& GetGroups() const { return m_Groups; }
+    const std::string&              GetMtlFilename() const { return m_MtlFilename; }
+    std::uint32_t                   GetFacesPerChunk() const { return m_FacesPerChunk; }
+    std::uint32_t                   GetNumChunks() const { return m_NumChunks; }
+    std::uint64_t                   GetNumFaces() const;
+    void GetBounds(Point3f& boundsMin, Point3f& boundsMax) const;
+
+private:
+    std::ifstream            m_In;
+    std::string              m_MtlFilename;
+    std::vector<StreamGroup> m_Groups;
+    std::uint32_t            m_FacesPerChunk = 0;
+    std::uint32_t            m_NumChunks = 0;
+};
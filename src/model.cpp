@@ -7,14 +7,23 @@
 #include <spdlog/spdlog.h>
 #include <spdlog/stopwatch.h>
 
+#include "assetio.h"
 #include "forkergl.h"
+#include "json.h"
+#include "mappedfile.h"
+#include "packarchive.h"
 #include "shader.h"
+#include "sharedstore.h"
+#include "texturecache.h"
+#include "threadpool.h"
 #include "utility.h"
+#include "virtualtexture.h"
 
 /////////////////////////////////////////////////////////////////////////////////
 
 std::unique_ptr<Model> Model::Load(const std::string& filename, bool normalized,
-                                   bool generateTangent, bool flipTexCoordY)
+                                   bool generateTangent, bool flipTexCoordY,
+                                   ThreadPool* pool)
 {
     // Init Model
     std::unique_ptr<Model> model = std::make_unique<Model>();
@@ -26,30 +35,206 @@ std::unique_ptr<Model> Model::Load(const std::string& filename, bool normalized,
     model->m_TexCoords.clear();
     model->m_Normals.clear();
 
-    spdlog::info("  [Model] \'{}\'", filename);
-
+    model->m_Filename = filename;
+    model->m_ThreadPool = pool;
+    model->m_SourceFiles.insert(filename);
     model->m_HasTangents = generateTangent;
+    model->m_Normalized = normalized;
+    model->m_FlipTexCoordY = flipTexCoordY;
 
     // Load Object, Material, Texture Files
-    bool success = model->loadObjectFile(filename, flipTexCoordY);
+    bool        isGlb = GetExtension(filename) == ".glb";
+    bool        recording = PackArchive::IsRecording();
+    std::string options =
+        fmt::format("model normalized={} tangents={}", normalized, generateTangent);
+
+    // Cooked meshes of the mounted pack archive
+    std::shared_ptr<const MappedFile> entry;
+    if (!isGlb) entry = PackArchive::Find(PackArchive::GetCookedName(filename, options));
+    if (entry && model->attachSharedObject(entry, entry->GetData(), entry->GetSize(),
+                                           filename, flipTexCoordY))
+    {
+        model->m_Packed = true;
+        if (pool == nullptr) model->FinishLoading();
+        return std::move(model);
+    }
+
+    // Reuse the meshes another process has published
+    std::string sharedName;
+    if (ForkerGL::SharedAssets && !isGlb && !recording)
+    {
+        sharedName = SharedAssetStore::MakeName(filename, options);
+        std::shared_ptr<const MappedFile> object = SharedAssetStore::Attach(sharedName);
+        if (object &&
+            model->attachSharedObject(object, SharedAssetStore::GetPayload(*object),
+                                      SharedAssetStore::GetPayloadSize(*object), filename,
+                                      flipTexCoordY))
+        {
+            if (pool == nullptr) model->FinishLoading();
+            return std::move(model);
+        }
+    }
+
+    bool success = isGlb ? model->loadGlbFile(filename, normalized)
+                         : model->loadObjectFile(filename, flipTexCoordY);
 
     if (!success)
     {
-        spdlog::error("Failed to load model");
+        spdlog::error("Failed to load model: \'{}\'", filename);
         return nullptr;
     }
 
-    // Post-Processing
+    // Post-Processing (overlaps with texture decoding on the pool)
     if (generateTangent) model->generateTangents();
-    if (normalized) model->normalizePositionVertices();
+    if (normalized && !isGlb) model->normalizePositionVertices();
+    if (!sharedName.empty()) model->publishSharedObject(sharedName);  // else private
+
+    // A .glb is packed as is (its meshes are views into the file anyway)
+    if (recording)
+    {
+        std::vector<std::uint8_t> bytes;
+        if (isGlb ? AssetIO::Read(filename, bytes) : model->cookSharedObject(bytes))
+        {
+            PackArchive::Record(isGlb ? filename
+                                      : PackArchive::GetCookedName(filename, options),
+                                std::move(bytes));
+        }
+    }
+
+    if (pool == nullptr) model->FinishLoading();
+
+    /* Actually std::move() is not needed because of copy elision */
+    return std::move(model);
+}
+
+// Memory used per streamed triangle: chunk read buffer, unpacked attributes, indices
+static const std::size_t s_StreamBytesPerFace =
+    3 * (sizeof(StreamVertex) + 3 * sizeof(Vector3f) + sizeof(Vector2f) + 4 * sizeof(int));
+
+std::unique_ptr<Model> Model::LoadStreaming(const std::string& filename, bool normalized,
+                                            bool generateTangent, bool flipTexCoordY,
+                                            std::size_t budgetBytes, ThreadPool* pool)
+{
+    if (GetExtension(filename) != ".obj")
+    {
+        spdlog::warn("Streaming supports .obj files only, loading \'{}\' in memory",
+                     filename);
+        return Load(filename, normalized, generateTangent, flipTexCoordY, pool);
+    }
+
+    std::unique_ptr<Model> model = std::make_unique<Model>();
+
+    model->m_Filename = filename;
+    model->m_ThreadPool = pool;
+    model->m_SourceFiles.insert(filename);
+    model->m_HasTangents = generateTangent;
+    model->m_Normalized = normalized;
+    model->m_FlipTexCoordY = flipTexCoordY;
+    model->m_StreamBudget = budgetBytes;
+
+    std::string   chunkFilename = filename + ".chunks";
+    std::uint32_t facesPerChunk =
+        (std::uint32_t)Max<std::size_t>(1, budgetBytes / s_StreamBytesPerFace);
+
+    // Reuse the cooked file unless it is stale or was cooked with larger batches
+    std::unique_ptr<MeshStream> stream = std::make_unique<MeshStream>();
+    if (!stream->Open(chunkFilename, filename, generateTangent) ||
+        stream->GetFacesPerChunk() > facesPerChunk)
+    {
+        spdlog::info("  [Model] Cooking \'{}\' ({} faces per chunk)", chunkFilename,
+                     facesPerChunk);
+        stream = std::make_unique<MeshStream>();
+        if (!MeshStream::Cook(filename, chunkFilename, generateTangent, facesPerChunk) ||
+            !stream->Open(chunkFilename, filename, generateTangent))
+        {
+            spdlog::error("Failed to load model: \'{}\'", filename);
+            return nullptr;
+        }
+    }
+
+    model->m_StreamFilename = chunkFilename;
+    model->m_StreamNumChunks = stream->GetNumChunks();
+    model->m_StreamGroups = stream->GetGroups();
+
+    // Materials are small and stay resident
+    if (!stream->GetMtlFilename().empty())
+    {
+        size_t      slashPos = filename.find_last_of("/");
+        std::string directory =
+            (slashPos == std::string::npos) ? "" : filename.substr(0, slashPos + 1);
+        model->loadMaterials(directory, stream->GetMtlFilename(), flipTexCoordY);
+    }
+
+    if (normalized)
+    {
+        Point3f boundsMin, boundsMax;
+        stream->GetBounds(boundsMin, boundsMax);
+        model->m_StreamTransform = makeNormalizationMatrix(boundsMin, boundsMax);
+    }
+
+    if (pool == nullptr) model->FinishLoading();
+
+    return std::move(model);
+}
+
+void Model::FinishLoading()
+{
+    finishTextures();
+
+    for (auto iter = m_Meshes.begin(); iter != m_Meshes.end(); ++iter)
+    {
+        iter->second->ComputeBounds();
+    }
+
+    spdlog::info("  [Model] \'{}\'", m_Filename);
+
+    if (IsStreaming())
+    {
+        std::uint64_t numFaces = 0;
+        for (const StreamGroup& group : m_StreamGroups)
+            numFaces += group.numFaces;
+
+        // clang-format off
+        spdlog::info(
+            "     [Streaming] f# {}, chunk# {}, mesh# {}, mtl# {}, budget {:.2f} MB | normalized[{}] generateTangent[{}], flipTexCoordY[{}]",
+            numFaces, m_StreamNumChunks, m_StreamGroups.size(), m_Materials.size(), m_StreamBudget / (1024.0 * 1024.0),
+            m_Normalized ? "o" : "x", m_HasTangents ? "o" : "x", m_FlipTexCoordY ? "o" : "x");
+        // clang-format on
+
+        for (const StreamGroup& group : m_StreamGroups)
+        {
+            auto iter = m_PBRMaterials.find(group.materialName);
+            if (iter == m_PBRMaterials.end()) continue;
+
+            const PBRMaterial& pbrMaterial = *(iter->second);
+            m_SupportPBR = pbrMaterial.HasMetalnessMap() || pbrMaterial.HasRoughnessMap();
+            spdlog::info("     [{:}] f# {:} | PBR[{}]", group.meshName, group.numFaces,
+                         m_SupportPBR ? "o" : "x");
+        }
+        return;
+    }
+
+    // Vertices read in place from a .glb are counted too
+    int numVerts = GetNumVerts();
+    for (auto iter = m_Meshes.begin(); iter != m_Meshes.end(); ++iter)
+    {
+        numVerts += iter->second->GetViews().positions.GetCount();
+    }
+
+    if (m_SharedObject)
+    {
+        spdlog::info("     [{}] {:.2f} MB {}", m_Packed ? "Packed" : "Shared",
+                     m_SharedObject->GetSize() / (1024.0 * 1024.0),
+                     m_Packed ? "from the pack archive" : "mapped from shared memory");
+    }
 
     // clang-format off
     spdlog::info(
         "     v# {}, f# {}, vt# {}, vn# {}, tg# {}, mesh# {}, mtl# {} | normalized[{}] generateTangent[{}], flipTexCoordY[{}]",
-        model->GetNumVerts(), model->GetNumFaces(), model->m_TexCoords.size(), model->m_Normals.size(), model->m_Tangents.size(), model->m_Meshes.size(),
-        model->m_Materials.size(), normalized ? "o" : "x", generateTangent ? "o" : "x", flipTexCoordY ? "o" : "x");
+        numVerts, GetNumFaces(), m_TexCoords.size(), m_Normals.size(), m_Tangents.size(), m_Meshes.size(),
+        m_Materials.size(), m_Normalized ? "o" : "x", m_HasTangents ? "o" : "x", m_FlipTexCoordY ? "o" : "x");
 
-    for (auto iter = model->m_Meshes.begin(); iter != model->m_Meshes.end(); ++iter)
+    for (auto iter = m_Meshes.begin(); iter != m_Meshes.end(); ++iter)
     {
         const Mesh& mesh = *(iter->second);
 
@@ -57,31 +242,36 @@ std::unique_ptr<Model> Model::Load(const std::string& filename, bool normalized,
 
         if (pbrMaterial->HasMetalnessMap() || pbrMaterial->HasRoughnessMap())
         {
-            model->m_SupportPBR = true;
+            m_SupportPBR = true;
             spdlog::info("     [{:}] f# {:} | PBR[o] {}", iter->first, mesh.NumFaces(), *pbrMaterial);
         }
         else
         {
-            model->m_SupportPBR = false;
+            m_SupportPBR = false;
             spdlog::info("     [{:}] f# {:} | PBR[x] {}", iter->first, mesh.NumFaces(), *(mesh.GetMaterial()));
         }
     }
     // clang-format on
-
-    /* Actually std::move() is not needed because of copy elision */
-    return std::move(model);
 }
 
 /////////////////////////////////////////////////////////////////////////////////
 
 void Model::Render(Shader& shader) const
 {
+    if (IsStreaming())
+    {
+        renderStreamed(shader);
+        return;
+    }
+
     spdlog::stopwatch stopwatch;
     // For each mesh
     for (auto iter = m_Meshes.begin(); iter != m_Meshes.end(); ++iter)
     {
         const Mesh& mesh = *(iter->second);
 
+        shader.Use(mesh);
+        shader.SelectVariant();  // once per mesh, for its material features
         mesh.Draw(shader);
 
         spdlog::info("  [{}] Time Used: {:.6} Seconds", iter->first, stopwatch);
@@ -89,6 +279,90 @@ void Model::Render(Shader& shader) const
     }
 }
 
+void Model::renderStreamed(Shader& shader) const
+{
+    spdlog::stopwatch stopwatch;
+
+    MeshStream stream;
+    if (!stream.Open(m_StreamFilename, "", m_HasTangents))
+    {
+        spdlog::error("Failed to open the chunk file: \'{}\'", m_StreamFilename);
+        return;
+    }
+
+    // Transient vertex storage for one chunk, the buffers are reused between chunks
+    Model batch;
+    batch.m_HasTangents = m_HasTangents;
+    batch.m_SupportPBR = m_SupportPBR;
+
+    std::vector<StreamVertex> vertices;
+    int                       groupIndex;
+    std::uint64_t             numFaces = 0;
+    while (stream.ReadChunk(groupIndex, vertices))
+    {
+        int numVerts = (int)vertices.size();
+        batch.m_Verts.resize(numVerts);
+        batch.m_TexCoords.resize(numVerts);
+        batch.m_Normals.resize(numVerts);
+        batch.m_Tangents.resize(m_HasTangents ? numVerts : 0);
+
+        std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>(batch);
+        for (int i = 0; i < numVerts; ++i)
+        {
+            const StreamVertex& v = vertices[i];
+            Vector3f position(v.position[0], v.position[1], v.position[2]);
+            batch.m_Verts[i] = (m_StreamTransform * Vector4f(position, 1.f)).xyz;
+            batch.m_TexCoords[i] = Vector2f(v.texCoord[0], v.texCoord[1]);
+            batch.m_Normals[i] = Vector3f(v.normal[0], v.normal[1], v.normal[2]);
+            if (m_HasTangents)
+            {
+                batch.m_Tangents[i] = Vector3f(v.tangent[0], v.tangent[1], v.tangent[2]);
+                mesh->AddTangentIndex(i);
+            }
+            mesh->AddVertIndex(i);
+            mesh->AddTexCoordIndex(i);
+            mesh->AddNormalIndex(i);
+        }
+
+        const std::string& materialName = m_StreamGroups[groupIndex].materialName;
+        auto               material = m_Materials.find(materialName);
+        auto               pbrMaterial = m_PBRMaterials.find(materialName);
+        if (material != m_Materials.end()) mesh->SetMaterial(material->second);
+        if (pbrMaterial != m_PBRMaterials.end()) mesh->SetPBRMaterial(pbrMaterial->second);
+
+        shader.Use(*mesh);
+        shader.SelectVariant();
+        mesh->Draw(shader);
+        numFaces += mesh->NumFaces();
+    }
+
+    spdlog::info("  [Streamed] f# {} in {} chunks | Time Used: {:.6} Seconds", numFaces,
+                 m_StreamNumChunks, stopwatch);
+}
+
+void Model::CollectVisibleTextures(const Matrix4x4f&                    mvp,
+                                   std::unordered_set<const Texture*>& textures) const
+{
+    for (const StreamGroup& group : m_StreamGroups)
+    {
+        auto material = m_Materials.find(group.materialName);
+        auto pbrMaterial = m_PBRMaterials.find(group.materialName);
+        if (material == m_Materials.end() || pbrMaterial == m_PBRMaterials.end()) continue;
+
+        if (Mesh::IsBoxVisible(mvp * m_StreamTransform, group.boundsMin, group.boundsMax))
+        {
+            Mesh::CollectMaterialTextures(*(material->second), *(pbrMaterial->second),
+                                          m_SupportPBR, m_HasTangents, textures);
+        }
+    }
+
+    for (auto iter = m_Meshes.begin(); iter != m_Meshes.end(); ++iter)
+    {
+        const Mesh& mesh = *(iter->second);
+        if (mesh.IsVisible(mvp)) mesh.CollectTextures(m_SupportPBR, textures);
+    }
+}
+
 /////////////////////////////////////////////////////////////////////////////////
 
 int Model::GetNumFaces() const
@@ -106,17 +380,31 @@ int Model::GetNumFaces() const
 
 void Model::normalizePositionVertices()
 {
-    Float xmin = MaxFloat, xmax = MinFloat;
-    Float ymin = MaxFloat, ymax = MinFloat;
-    Float zmin = MaxFloat, zmax = MinFloat;
+    Point3f boundsMin(MaxFloat), boundsMax(MinFloat);
 
     for (size_t i = 0; i < GetNumVerts(); ++i)
     {
         Vector3f v = m_Verts[i];
-        xmin = Min(xmin, v.x), xmax = Max(xmax, v.x);
-        ymin = Min(ymin, v.y), ymax = Max(ymax, v.y);
-        zmin = Min(zmin, v.z), zmax = Max(zmax, v.z);
+        for (int k = 0; k < 3; ++k)
+        {
+            boundsMin[k] = Min(boundsMin[k], v[k]);
+            boundsMax[k] = Max(boundsMax[k], v[k]);
+        }
+    }
+
+    Matrix4f m = makeNormalizationMatrix(boundsMin, boundsMax);
+
+    for (size_t i = 0; i < GetNumVerts(); ++i)
+    {
+        m_Verts[i] = (m * Vector4f(m_Verts[i], 1.f)).xyz;
     }
+}
+
+Matrix4x4f Model::makeNormalizationMatrix(const Point3f& boundsMin, const Point3f& boundsMax)
+{
+    Float xmin = boundsMin.x, xmax = boundsMax.x;
+    Float ymin = boundsMin.y, ymax = boundsMax.y;
+    Float zmin = boundsMin.z, zmax = boundsMax.z;
 
     CHECK_NE(xmax - xmin, 0);
     CHECK_NE(ymax - ymin, 0);
@@ -130,11 +418,7 @@ void Model::normalizePositionVertices()
     m[0][3] = -(xmax + xmin) / (xmax - xmin);
     m[1][3] = -(ymax + ymin) / (ymax - ymin);
     m[2][3] = -(zmax + zmin) / (zmax - zmin);
-
-    for (size_t i = 0; i < GetNumVerts(); ++i)
-    {
-        m_Verts[i] = (m * Vector4f(m_Verts[i], 1.f)).xyz;
-    }
+    return m;
 }
 
 /////////////////////////////////////////////////////////////////////////////////
@@ -142,15 +426,14 @@ void Model::normalizePositionVertices()
 // Load .obj File
 bool Model::loadObjectFile(const std::string& filename, bool flipVertically)
 {
-    // Load Object File
-    std::ifstream in;
-    in.open(filename, std::ifstream::in);
-
-    if (in.fail())
+    // Load Object File (its read was queued by the scene)
+    std::string text;
+    if (!AssetIO::ReadText(filename, text))
     {
         spdlog::error("Failed to open the .obj file");
         return false;
     }
+    std::istringstream in(text);
 
     std::string line;
     std::string meshName;
@@ -170,6 +453,7 @@ bool Model::loadObjectFile(const std::string& filename, bool flipVertically)
         {
             std::string mtlFilename;
             iss >> strTrash >> mtlFilename;
+            m_MtlFilename = mtlFilename;
 
             std::string directory;
             size_t      slashPos = filename.find_last_of("/");
@@ -259,15 +543,45 @@ void Model::loadMaterials(const std::string& directory, const std::string& filen
                           bool flipVertically)
 {
     std::string mtlFilename = directory + filename;
+    m_SourceFiles.insert(mtlFilename);
 
-    std::ifstream in;
-    in.open(mtlFilename, std::ifstream::in);
-
-    if (in.fail())
+    std::string text;
+    if (!AssetIO::ReadText(mtlFilename, text))
     {
         spdlog::error("Cannot open the .mtl file: \'{}\'", mtlFilename);
         return;
     }
+    if (PackArchive::IsRecording())
+    {
+        PackArchive::Record(mtlFilename,
+                            std::vector<std::uint8_t>(text.begin(), text.end()));
+    }
+    std::istringstream in(text);
+
+    // Textures decoded while loading are all read at once, decoding each one overlaps
+    // with the reads of the others. Deferred or mapped textures may never be read.
+    if (ForkerGL::TextureLoading == Texture::Eager && !ForkerGL::TextureCaching &&
+        !ForkerGL::SharedAssets && !PackArchive::IsMounted())
+    {
+        std::string line;
+        while (std::getline(in, line))
+        {
+            std::istringstream iss(Ltrim(line));
+            std::string        keyword, textureFilename;
+            iss >> keyword >> textureFilename;
+            if (textureFilename.empty()) continue;
+
+            // Keep in sync with the texture keywords below, every queued read is taken
+            if (keyword == "map_Kd" || keyword == "map_Ks" || keyword == "map_Ke" ||
+                keyword == "map_Bump" || keyword == "norm" || keyword == "map_Ao" ||
+                keyword == "map_Pr" || keyword == "map_Pm")
+            {
+                AssetIO::Prefetch(directory + textureFilename);
+            }
+        }
+        in.clear();
+        in.seekg(0);
+    }
 
     std::string line;
     std::string materialName;  // current name
@@ -300,6 +614,7 @@ void Model::loadMaterials(const std::string& directory, const std::string& filen
             iss >> strTrash;
             Vector3f floats;
             iss >> floats.x >> floats.y >> floats.z;
+            floats = Pow(floats, Gamma);  // sRGB -> linear, once
             m_Materials[materialName]->kd = floats;
             m_PBRMaterials[materialName]->albedo = floats;
         }
@@ -315,6 +630,7 @@ void Model::loadMaterials(const std::string& directory, const std::string& filen
             iss >> strTrash;
             Vector3f floats;
             iss >> floats.x >> floats.y >> floats.z;
+            floats = Pow(floats, Gamma);
             m_Materials[materialName]->ke = floats;
             m_PBRMaterials[materialName]->ke = floats;
         }
@@ -407,23 +723,1131 @@ void Model::loadMaterials(const std::string& directory, const std::string& filen
     }
 }
 
-// Load Texture File
-void Model::loadTexture(const std::string&        textureFilename,
-                        std::shared_ptr<Texture>& texture, bool flipVertically)
+bool Model::ReloadTexture(const std::string& textureFilename)
+{
+    if (m_OrmSourceFiles.count(textureFilename) > 0) return false;  // packed
+
+    bool found = false;
+    for (const TextureSlot& slot : m_TextureSlots)
+    {
+        if (slot.filename != textureFilename) continue;
+        requestTexture(slot.filename, *slot.texture, slot.flipVertically);
+        found = true;
+    }
+    finishTextures();
+    return found;
+}
+
+void Model::finishTextures()
+{
+    // Join Point: textures are assigned only after their decoding has finished
+    for (auto& pending : m_PendingTextures)
+    {
+        *(pending.second) = pending.first.get();
+    }
+    m_PendingTextures.clear();
+    m_TextureRequests.clear();
+    m_DeferredTextures.clear();
+    m_ThreadPool = nullptr;
+
+    packOrmTextures();
+    compressTextures();
+}
+
+// AO, roughness and metalness maps from separate files are packed into one RGB texture
+// (R AO, G roughness, B metalness). Shading fetches the three at once, and the separate
+// textures are released once packed (deferred: on first use).
+void Model::packOrmTextures()
+{
+    for (auto iter = m_PBRMaterials.begin(); iter != m_PBRMaterials.end(); ++iter)
+    {
+        PBRMaterial& material = *(iter->second);
+        if (!material.HasRoughnessMap() && !material.HasMetalnessMap()) continue;
+
+        std::array<std::shared_ptr<Texture>*, 3> slots = {
+            &material.ambientOcclusionMap, &material.roughnessMap, &material.metalnessMap
+        };
+        std::array<int*, 3> channels = { &material.aoChannel, &material.roughnessChannel,
+                                         &material.metalnessChannel };
+
+        // Already one texture (e.g. glTF occlusion and metallicRoughness)
+        const std::shared_ptr<Texture>& ormMap = material.GetOrmMap();
+        if ((!*slots[0] || *slots[0] == ormMap) && (!*slots[1] || *slots[1] == ormMap) &&
+            (!*slots[2] || *slots[2] == ormMap))
+            continue;
+
+        std::array<std::shared_ptr<const Texture>, 3> sources;
+        std::array<int, 3>                            sourceChannels;
+        int                                           width = 1, height = 1;
+        for (int i = 0; i < 3; ++i)
+        {
+            sources[i] = *slots[i];
+            sourceChannels[i] = *channels[i];
+            if (!sources[i]) continue;
+            width = Max(width, sources[i]->GetWidth());
+            height = Max(height, sources[i]->GetHeight());
+        }
+
+        Texture::WrapMode        wrap = ForkerGL::TextureWrapping;
+        Texture::FilterMode      filter = ForkerGL::TextureFiltering;
+        std::shared_ptr<Texture> packed;
+        if (ForkerGL::TextureLoading == Texture::Virtual)
+        {
+            // Packed from the backings of the sources. It has no cache file, so the
+            // packed texels stay resident as the backing of its pages.
+            std::shared_ptr<Texture> texels =
+                Texture::PackChannels(sources, sourceChannels, wrap, filter);
+            packed = VirtualTexture::Create(std::move(texels), wrap, filter);
+        }
+        else if (ForkerGL::TextureLoading == Texture::Deferred)
+        {
+            auto load = [sources, sourceChannels, wrap,
+                         filter]() -> std::shared_ptr<const Texture> {
+                return Texture::PackChannels(sources, sourceChannels, wrap, filter);
+            };
+            packed = std::make_shared<Texture>(width, height, load, wrap, filter);
+        }
+        else
+        {
+            packed = Texture::PackChannels(sources, sourceChannels, wrap, filter);
+        }
+
+        for (int i = 0; i < 3; ++i)
+        {
+            if (!*slots[i]) continue;
+            *slots[i] = packed;
+            *channels[i] = i;
+        }
+
+        // A changed source file reloads the model, its slot no longer holds the file
+        for (const TextureSlot& slot : m_TextureSlots)
+        {
+            if (std::find(slots.begin(), slots.end(), slot.texture) != slots.end())
+                m_OrmSourceFiles.insert(slot.filename);
+        }
+    }
+}
+
+// Block compression ('compress on'): color maps become BC1, specular maps BC4 and normal
+// maps BC5, each texture encoded once however many slots share it (deferred: on first
+// use). Packed ORM maps stay uncompressed, BC1 endpoints would mix their channels, and
+// so do virtual textures, which page from their cache files.
+void Model::compressTextures()
+{
+    if (!ForkerGL::TextureCompression || ForkerGL::TextureLoading == Texture::Virtual)
+        return;
+
+    using Key = std::pair<const Texture*, Texture::Format>;
+    std::map<Key, std::shared_ptr<Texture>> encoded;
+
+    auto compress = [&encoded](std::shared_ptr<Texture>& slot, Texture::Format format) {
+        if (!slot || slot->GetFormat() != Texture::Uncompressed) return;  // done before
+
+        std::shared_ptr<Texture>& texture = encoded[Key(slot.get(), format)];
+        if (!texture && ForkerGL::TextureLoading == Texture::Deferred)
+        {
+            std::shared_ptr<const Texture> source = slot;
+            auto load = [source, format]() -> std::shared_ptr<const Texture> {
+                return Texture::Compress(*source, format);
+            };
+            texture = std::make_shared<Texture>(
+                source->GetWidth(), source->GetHeight(), load, ForkerGL::TextureWrapping,
+                ForkerGL::TextureFiltering, format);
+        }
+        else if (!texture)
+        {
+            texture = Texture::Compress(*slot, format);
+        }
+        if (texture) slot = texture;  // no texels: keep the missing texture
+    };
+
+    for (auto iter = m_Materials.begin(); iter != m_Materials.end(); ++iter)
+    {
+        Material& material = *(iter->second);
+        compress(material.diffuseMap, Texture::BC1);
+        compress(material.emissiveMap, Texture::BC1);
+        compress(material.specularMap, Texture::BC4);  // sampled from B
+        compress(material.normalMap, Texture::BC5);
+    }
+    for (auto iter = m_PBRMaterials.begin(); iter != m_PBRMaterials.end(); ++iter)
+    {
+        PBRMaterial& material = *(iter->second);
+        compress(material.baseColorMap, Texture::BC1);
+        compress(material.emissiveMap, Texture::BC1);
+        compress(material.normalMap, Texture::BC5);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+// Texels decoded before: packed, published by another process or cached on disk
+static std::shared_ptr<Texture> findDecodedTexture(const std::string& textureFilename,
+                                                   bool flipVertically, bool sharing,
+                                                   bool caching)
+{
+    std::shared_ptr<Texture> texture = TextureCache::LoadPacked(
+        textureFilename, flipVertically, ForkerGL::TextureWrapping,
+        ForkerGL::TextureFiltering);
+    if (!texture && sharing)
+    {
+        texture = TextureCache::AttachShared(textureFilename, flipVertically,
+                                             ForkerGL::TextureWrapping,
+                                             ForkerGL::TextureFiltering);
+    }
+    if (!texture && caching)
+    {
+        texture =
+            TextureCache::Load(textureFilename, flipVertically, ForkerGL::TextureWrapping,
+                               ForkerGL::TextureFiltering);
+    }
+    return texture;
+}
+
+// Decodes the file and hands the texels over to the cache file, the shared store and the
+// pack archive being recorded
+static std::shared_ptr<Texture> decodeTexture(const std::string& textureFilename,
+                                              bool flipVertically, bool sharing,
+                                              bool caching)
 {
     TGAImage image;
-    bool     success = image.ReadTgaFile(textureFilename.c_str());
+    // flip v coordinate while decoding
+    bool success = image.ReadTgaFile(textureFilename.c_str(), flipVertically);
 
     if (!success)
     {
         spdlog::warn("Failed to load texture: {}", textureFilename);
+        return nullptr;
+    }
+    if (caching) TextureCache::Store(textureFilename, flipVertically, image);
+    if (PackArchive::IsRecording())
+    {
+        TextureCache::RecordPacked(textureFilename, flipVertically, image);
+    }
+
+    // The published copy replaces the private one
+    if (sharing)
+    {
+        std::shared_ptr<Texture> shared = TextureCache::PublishShared(
+            textureFilename, flipVertically, image, ForkerGL::TextureWrapping,
+            ForkerGL::TextureFiltering);
+        if (shared) return shared;
+    }
+
+    return std::make_shared<Texture>(image, ForkerGL::TextureWrapping,
+                                     ForkerGL::TextureFiltering);
+}
+
+// Pages of the mapped texels, the cache file is written by decodeTexture() if needed. A
+// texture that cannot be mapped stays resident.
+static std::shared_ptr<Texture> makeVirtualTexture(
+    const std::string& textureFilename, bool flipVertically,
+    std::shared_ptr<Texture> decoded, bool mapped)
+{
+    if (!mapped)
+    {
+        std::shared_ptr<Texture> cached =
+            TextureCache::Load(textureFilename, flipVertically, ForkerGL::TextureWrapping,
+                               ForkerGL::TextureFiltering);
+        if (!cached)
+        {
+            spdlog::warn("No texture cache to page from, kept resident: {}",
+                         textureFilename);
+            return decoded;
+        }
+        decoded = std::move(cached);
+    }
+    return VirtualTexture::Create(std::move(decoded), ForkerGL::TextureWrapping,
+                                  ForkerGL::TextureFiltering);
+}
+
+// Load Texture File
+void Model::loadTexture(const std::string&        textureFilename,
+                        std::shared_ptr<Texture>& texture, bool flipVertically)
+{
+    m_SourceFiles.insert(textureFilename);
+    m_TextureSlots.push_back(TextureSlot{ textureFilename, &texture, flipVertically });
+    requestTexture(textureFilename, texture, flipVertically);
+}
+
+void Model::requestTexture(const std::string&        textureFilename,
+                           std::shared_ptr<Texture>& texture, bool flipVertically)
+{
+    // Packing decodes every texture, nothing is taken from elsewhere
+    bool recording = PackArchive::IsRecording();
+    bool sharing = ForkerGL::SharedAssets && !recording;
+    bool caching = ForkerGL::TextureCaching && !recording;
+
+    if (ForkerGL::TextureLoading == Texture::Deferred && !recording)
+    {
+        auto iter = m_DeferredTextures.find(textureFilename);
+        if (iter != m_DeferredTextures.end())
+        {
+            texture = iter->second;
+            return;
+        }
+
+        // Mapped texels need no decoding, nothing left to defer
+        texture = findDecodedTexture(textureFilename, flipVertically, sharing, caching);
+        if (texture)
+        {
+            m_DeferredTextures.emplace(textureFilename, texture);
+            return;
+        }
+
+        // Only the header is read here, texels are decoded on first use
+        int width, height, bytespp;
+        if (!TGAImage::ReadTgaInfo(textureFilename, width, height, bytespp))
+        {
+            spdlog::warn("Failed to load texture: {}", textureFilename);
+            return;
+        }
+
+        auto load = [textureFilename, flipVertically, sharing,
+                     caching]() -> std::shared_ptr<const Texture> {
+            // Another process may have published it in the meantime
+            std::shared_ptr<Texture> shared =
+                findDecodedTexture(textureFilename, flipVertically, sharing, false);
+            if (shared) return shared;
+            return decodeTexture(textureFilename, flipVertically, sharing, caching);
+        };
+
+        texture = std::make_shared<Texture>(width, height, load,
+                                            ForkerGL::TextureWrapping,
+                                            ForkerGL::TextureFiltering);
+        m_DeferredTextures.emplace(textureFilename, texture);
         return;
     }
 
-    if (flipVertically) image.FlipVertically();  // flip v coordinate
+    auto iter = m_TextureRequests.find(textureFilename);
+    if (iter == m_TextureRequests.end())
+    {
+        bool paging = (ForkerGL::TextureLoading == Texture::Virtual) && !recording;
+        auto load = [textureFilename, flipVertically, sharing, caching,
+                     paging]() -> std::shared_ptr<Texture> {
+            std::shared_ptr<Texture> decoded =
+                findDecodedTexture(textureFilename, flipVertically, sharing, caching);
+            bool mapped = (decoded != nullptr);
+            if (!decoded)
+            {
+                decoded =
+                    decodeTexture(textureFilename, flipVertically, sharing, caching);
+            }
+            if (!decoded || !paging) return decoded;
+            return makeVirtualTexture(textureFilename, flipVertically, decoded, mapped);
+        };
 
-    texture = std::make_shared<Texture>(image, ForkerGL::TextureWrapping,
-                                        ForkerGL::TextureFiltering);
+        TextureFuture future;
+        if (m_ThreadPool)
+        {
+            future = m_ThreadPool->Enqueue(load).share();
+        }
+        else
+        {
+            std::promise<std::shared_ptr<Texture>> promise;
+            promise.set_value(load());
+            future = promise.get_future().share();
+        }
+        iter = m_TextureRequests.emplace(textureFilename, future).first;
+    }
+
+    m_PendingTextures.emplace_back(iter->second, &texture);
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+// Shared .obj Model Object
+// Layout: [Header] [MeshRecord x numMeshes] [strings] [positions] [normals]
+//         [texCoords] [tangents (optional)] [indices], arrays are 16-byte aligned
+struct SharedModelHeader
+{
+    char          magic[4];
+    std::uint32_t numMeshes;
+    std::uint32_t numVerts;
+    std::uint32_t numIndices;
+    std::uint32_t hasTangents;
+    std::uint32_t mtlLength;    // .mtl filename starts the strings
+    std::uint32_t stringsSize;  // followed by mesh and material names
+    std::uint32_t reserved;
+};
+
+struct SharedMeshRecord
+{
+    std::uint32_t nameOffset, nameLength;
+    std::uint32_t materialOffset, materialLength;
+    std::uint32_t firstVert, numVerts;  // vertices of this mesh only
+    std::uint32_t firstIndex, numIndices;
+};
+
+struct SharedModelLayout
+{
+    std::size_t records, strings, positions, normals, texCoords, tangents, indices;
+    std::size_t size;
+
+    explicit SharedModelLayout(const SharedModelHeader& header)
+    {
+        auto align = [](std::size_t offset) { return (offset + 15) & ~(std::size_t)15; };
+        std::size_t numVerts = header.numVerts;
+        records = sizeof(SharedModelHeader);
+        strings = records + header.numMeshes * sizeof(SharedMeshRecord);
+        positions = align(strings + header.stringsSize);
+        normals = align(positions + numVerts * 3 * sizeof(float));
+        texCoords = align(normals + numVerts * 3 * sizeof(float));
+        tangents = align(texCoords + numVerts * 2 * sizeof(float));
+        std::size_t tangentsSize = header.hasTangents ? numVerts * 4 * sizeof(float) : 0;
+        indices = align(tangents + tangentsSize);
+        size = indices + header.numIndices * sizeof(std::uint32_t);
+    }
+};
+
+static const char s_SharedModelMagic[4] = { 'F', 'K', 'S', 'M' };
+
+bool Model::cookSharedObject(std::vector<std::uint8_t>& bytes) const
+{
+    // Weld (v, vt, vn, tangent) index tuples per mesh
+    using Corner = std::array<int, 4>;
+    std::vector<Corner>           corners;  // unique per mesh, in vertex order
+    std::vector<std::uint32_t>    indices;
+    std::vector<SharedMeshRecord> records;
+    std::string                   strings = m_MtlFilename;
+
+    for (auto iter = m_Meshes.begin(); iter != m_Meshes.end(); ++iter)
+    {
+        const Mesh& mesh = *(iter->second);
+        if (mesh.HasViews()) return false;
+
+        // Materials are looked up by name when the object is attached
+        std::string materialName;
+        for (auto mtl = m_Materials.begin(); mtl != m_Materials.end(); ++mtl)
+        {
+            if (mtl->second == mesh.GetMaterial()) materialName = mtl->first;
+        }
+
+        SharedMeshRecord record;
+        record.nameOffset = (std::uint32_t)strings.size();
+        record.nameLength = (std::uint32_t)iter->first.size();
+        strings += iter->first;
+        record.materialOffset = (std::uint32_t)strings.size();
+        record.materialLength = (std::uint32_t)materialName.size();
+        strings += materialName;
+        record.firstVert = (std::uint32_t)corners.size();
+        record.firstIndex = (std::uint32_t)indices.size();
+
+        std::map<Corner, std::uint32_t> vertIds;
+        for (int f = 0; f < mesh.NumFaces(); ++f)
+        {
+            for (int v = 0; v < 3; ++v)
+            {
+                Corner corner = { mesh.GetVertIndex(f, v), mesh.GetTexCoordIndex(f, v),
+                                  mesh.GetNormalIndex(f, v),
+                                  m_HasTangents ? mesh.GetTangentIndex(f, v) : -1 };
+                auto inserted = vertIds.emplace(
+                    corner, (std::uint32_t)(corners.size() - record.firstVert));
+                if (inserted.second) corners.push_back(corner);
+                indices.push_back(inserted.first->second);
+            }
+        }
+        record.numVerts = (std::uint32_t)corners.size() - record.firstVert;
+        record.numIndices = (std::uint32_t)indices.size() - record.firstIndex;
+        records.push_back(record);
+    }
+
+    SharedModelHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, s_SharedModelMagic, 4);
+    header.numMeshes = (std::uint32_t)records.size();
+    header.numVerts = (std::uint32_t)corners.size();
+    header.numIndices = (std::uint32_t)indices.size();
+    header.hasTangents = m_HasTangents ? 1 : 0;
+    header.mtlLength = (std::uint32_t)m_MtlFilename.size();
+    header.stringsSize = (std::uint32_t)strings.size();
+    SharedModelLayout layout(header);
+
+    bytes.assign(layout.size, 0);
+    std::uint8_t* payload = bytes.data();
+    memcpy(payload, &header, sizeof(header));
+    memcpy(payload + layout.records, records.data(),
+           records.size() * sizeof(SharedMeshRecord));
+    memcpy(payload + layout.strings, strings.data(), strings.size());
+
+    auto* positions = reinterpret_cast<float*>(payload + layout.positions);
+    auto* normals = reinterpret_cast<float*>(payload + layout.normals);
+    auto* texCoords = reinterpret_cast<float*>(payload + layout.texCoords);
+    auto* tangents = reinterpret_cast<float*>(payload + layout.tangents);
+    for (std::size_t i = 0; i < corners.size(); ++i)
+    {
+        const Corner& corner = corners[i];
+        for (int k = 0; k < 3; ++k)
+        {
+            positions[i * 3 + k] = m_Verts[corner[0]][k];
+            normals[i * 3 + k] = m_Normals[corner[2]][k];
+        }
+        texCoords[i * 2 + 0] = m_TexCoords[corner[1]].s;
+        texCoords[i * 2 + 1] = m_TexCoords[corner[1]].t;
+        if (!m_HasTangents) continue;
+        for (int k = 0; k < 3; ++k)
+            tangents[i * 4 + k] = m_Tangents[corner[3]][k];
+        tangents[i * 4 + 3] = 1.f;
+    }
+    memcpy(payload + layout.indices, indices.data(),
+           indices.size() * sizeof(std::uint32_t));
+    return true;
+}
+
+bool Model::publishSharedObject(const std::string& name)
+{
+    std::vector<std::uint8_t> bytes;
+    if (!cookSharedObject(bytes)) return false;
+
+    std::shared_ptr<const MappedFile> object = SharedAssetStore::Publish(
+        name, bytes.size(), [&bytes](std::uint8_t* payload, std::size_t size) {
+            memcpy(payload, bytes.data(), size);
+            return true;
+        });
+    if (!object) return false;
+
+    bindSharedMeshes(object, SharedAssetStore::GetPayload(*object));
+    return true;
+}
+
+bool Model::attachSharedObject(std::shared_ptr<const MappedFile> owner,
+                               const std::uint8_t* payload, std::size_t size,
+                               const std::string& filename, bool flipVertically)
+{
+    SharedModelHeader header;
+    if (size < sizeof(header)) return false;
+    memcpy(&header, payload, sizeof(header));
+    if (memcmp(header.magic, s_SharedModelMagic, 4) != 0 ||
+        SharedModelLayout(header).size > size || header.mtlLength > header.stringsSize)
+    {
+        spdlog::warn("Invalid shared model object for '{}'", filename);
+        return false;
+    }
+
+    // Materials are small and parsed per process, textures are shared separately
+    m_MtlFilename.assign(reinterpret_cast<const char*>(payload) +
+                             SharedModelLayout(header).strings,
+                         header.mtlLength);
+    if (!m_MtlFilename.empty())
+    {
+        size_t      slashPos = filename.find_last_of("/");
+        std::string directory =
+            (slashPos == std::string::npos) ? "" : filename.substr(0, slashPos + 1);
+        loadMaterials(directory, m_MtlFilename, flipVertically);
+    }
+
+    bindSharedMeshes(owner, payload);
+    return true;
+}
+
+void Model::bindSharedMeshes(std::shared_ptr<const MappedFile> owner,
+                             const std::uint8_t*               payload)
+{
+    SharedModelHeader header;
+    memcpy(&header, payload, sizeof(header));
+    SharedModelLayout layout(header);
+
+    const char* strings = reinterpret_cast<const char*>(payload + layout.strings);
+    m_Meshes.clear();
+    for (std::uint32_t m = 0; m < header.numMeshes; ++m)
+    {
+        SharedMeshRecord record;
+        memcpy(&record, payload + layout.records + m * sizeof(record), sizeof(record));
+
+        std::string meshName(strings + record.nameOffset, record.nameLength);
+        std::string materialName(strings + record.materialOffset, record.materialLength);
+
+        // Tightly packed floats, the first vertex of this mesh at index 0
+        int  count = (int)record.numVerts;
+        auto attribute = [&](std::size_t offset, std::size_t numFloats) {
+            return payload + offset + record.firstVert * numFloats * sizeof(float);
+        };
+
+        PrimitiveViews views;
+        views.indices = IndexView(payload + layout.indices +
+                                      record.firstIndex * sizeof(std::uint32_t),
+                                  sizeof(std::uint32_t), (int)record.numIndices);
+        views.positions =
+            AttributeView<3>(attribute(layout.positions, 3), 3 * sizeof(float), count);
+        views.normals =
+            AttributeView<3>(attribute(layout.normals, 3), 3 * sizeof(float), count);
+        views.texCoords =
+            AttributeView<2>(attribute(layout.texCoords, 2), 2 * sizeof(float), count);
+        if (header.hasTangents)
+        {
+            views.tangents =
+                AttributeView<4>(attribute(layout.tangents, 4), 4 * sizeof(float), count);
+        }
+
+        std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>(*this);
+        mesh->SetViews(views);
+        mesh->SetMaterial(m_Materials[materialName]);
+        mesh->SetPBRMaterial(m_PBRMaterials[materialName]);
+        m_Meshes[meshName] = mesh;
+    }
+
+    // The private vertex arrays are no longer referenced
+    std::vector<Vector3f>().swap(m_Verts);
+    std::vector<Vector2f>().swap(m_TexCoords);
+    std::vector<Vector3f>().swap(m_Normals);
+    std::vector<Vector3f>().swap(m_Tangents);
+    m_SharedObject = std::move(owner);
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+// glTF 2.0 Binary Container
+static const std::uint32_t s_GlbMagic = 0x46546C67;      // "glTF"
+static const std::uint32_t s_GlbChunkJson = 0x4E4F534A;  // "JSON"
+static const std::uint32_t s_GlbChunkBin = 0x004E4942;   // "BIN\0"
+
+// glTF Accessor Component Types
+static const int s_GltfUnsignedByte = 5121;
+static const int s_GltfUnsignedShort = 5123;
+static const int s_GltfUnsignedInt = 5125;
+static const int s_GltfFloat = 5126;
+
+// Accessor resolved to a location inside the binary chunk
+struct GlbAccessor
+{
+    std::uint8_t* data = nullptr;
+    std::size_t   stride = 0;
+    int           count = 0;
+    int           componentType = 0;
+    int           numComponents = 0;
+};
+
+static int gltfComponentSize(int componentType)
+{
+    switch (componentType)
+    {
+        case 5120:  // byte
+        case 5121: return 1;
+        case 5122:  // short
+        case 5123: return 2;
+        case 5125:
+        case 5126: return 4;
+        default: return 0;
+    }
+}
+
+static int gltfNumComponents(const std::string& type)
+{
+    if (type == "SCALAR") return 1;
+    if (type == "VEC2") return 2;
+    if (type == "VEC3") return 3;
+    if (type == "VEC4") return 4;
+    return 0;  // matrices are not used for geometry
+}
+
+static bool resolveGlbAccessor(const JsonValue& gltf, int index, std::uint8_t* bin,
+                               std::size_t binSize, GlbAccessor& out)
+{
+    const JsonValue& accessor = gltf["accessors"][index];
+    if (!accessor.IsObject() || accessor.Has("sparse")) return false;
+
+    const JsonValue& view = gltf["bufferViews"][accessor["bufferView"].AsInt(-1)];
+    if (!view.IsObject() || view["buffer"].AsInt() != 0) return false;
+
+    int componentSize = gltfComponentSize(accessor["componentType"].AsInt());
+    out.count = accessor["count"].AsInt();
+    out.componentType = accessor["componentType"].AsInt();
+    out.numComponents = gltfNumComponents(accessor["type"].AsString());
+    if (out.count <= 0 || componentSize == 0 || out.numComponents == 0) return false;
+
+    std::size_t elementSize = (std::size_t)componentSize * out.numComponents;
+    std::size_t viewOffset = (std::size_t)view["byteOffset"].AsNumber(0);
+    std::size_t viewLength = (std::size_t)view["byteLength"].AsNumber(0);
+    std::size_t offset = (std::size_t)accessor["byteOffset"].AsNumber(0);
+    out.stride = (std::size_t)view["byteStride"].AsNumber(0);
+    if (out.stride == 0) out.stride = elementSize;
+
+    // The last element must end inside the view, and the view inside the chunk
+    if (viewOffset > binSize || viewLength > binSize - viewOffset ||
+        offset + out.stride * (out.count - 1) + elementSize > viewLength ||
+        (viewOffset + offset) % componentSize != 0 || out.stride % componentSize != 0)
+        return false;
+
+    out.data = bin + viewOffset + offset;
+    return true;
+}
+
+// Optional float attribute with the same vertex count as the positions
+static bool resolveGlbAttribute(const JsonValue& gltf, const JsonValue& attributes,
+                                const char* name, int numComponents, int numVerts,
+                                std::uint8_t* bin, std::size_t binSize, GlbAccessor& out)
+{
+    if (!attributes.Has(name)) return false;
+    if (!resolveGlbAccessor(gltf, attributes[name].AsInt(-1), bin, binSize, out) ||
+        out.componentType != s_GltfFloat || out.numComponents != numComponents ||
+        out.count != numVerts)
+    {
+        spdlog::warn("  [GLB] unsupported {} accessor, attribute is ignored", name);
+        return false;
+    }
+    return true;
+}
+
+static Matrix4x4f gltfNodeMatrix(const JsonValue& node)
+{
+    Matrix4x4f m(1.f);
+    const JsonValue& matrix = node["matrix"];
+    if (matrix.Size() == 16)
+    {
+        for (int c = 0; c < 4; ++c)  // column-major
+        {
+            for (int r = 0; r < 4; ++r)
+                m[r][c] = (Float)matrix[c * 4 + r].AsNumber();
+        }
+        return m;
+    }
+
+    // T * R * S
+    const JsonValue& t = node["translation"];
+    const JsonValue& q = node["rotation"];
+    const JsonValue& s = node["scale"];
+    Float x = q[0].AsNumber(0), y = q[1].AsNumber(0), z = q[2].AsNumber(0);
+    Float w = q[3].AsNumber(1);
+    Float rotation[3][3] = { { 1 - 2 * (y * y + z * z), 2 * (x * y - z * w),
+                               2 * (x * z + y * w) },
+                             { 2 * (x * y + z * w), 1 - 2 * (x * x + z * z),
+                               2 * (y * z - x * w) },
+                             { 2 * (x * z - y * w), 2 * (y * z + x * w),
+                               1 - 2 * (x * x + y * y) } };
+    for (int r = 0; r < 3; ++r)
+    {
+        for (int c = 0; c < 3; ++c)
+            m[r][c] = rotation[r][c] * (Float)s[c].AsNumber(1);
+        m[r][3] = (Float)t[r].AsNumber(0);
+    }
+    return m;
+}
+
+static void collectGltfMeshInstances(const JsonValue& nodes, int nodeIndex,
+                                     const Matrix4x4f& parent, int depth,
+                                     std::vector<std::pair<int, Matrix4x4f>>& instances)
+{
+    const JsonValue& node = nodes[nodeIndex];
+    if (!node.IsObject() || depth > 64) return;  // depth guards against cycles
+
+    Matrix4x4f world = parent * gltfNodeMatrix(node);
+    if (node.Has("mesh")) instances.emplace_back(node["mesh"].AsInt(), world);
+
+    const JsonValue& children = node["children"];
+    for (int i = 0; i < children.Size(); ++i)
+    {
+        int child = children[i].AsInt(-1);
+        collectGltfMeshInstances(nodes, child, world, depth + 1, instances);
+    }
+}
+
+static bool isIdentity(const Matrix4x4f& m)
+{
+    for (int r = 0; r < 4; ++r)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            if (m[r][c] != (r == c ? 1.f : 0.f)) return false;
+        }
+    }
+    return true;
+}
+
+// Load .glb File
+bool Model::loadGlbFile(const std::string& filename, bool normalized)
+{
+    // Copy-on-write mapping: only pages touched by transform baking are copied. A packed
+    // .glb is copied out of the archive entry, which stays read-only.
+    m_MappedFile = std::make_shared<MappedFile>();
+    std::shared_ptr<const MappedFile> entry = PackArchive::Find(filename);
+    bool                              opened = false;
+    if (entry)
+    {
+        const std::uint8_t* data = entry->GetData();
+        opened = m_MappedFile->OpenBuffer(
+            std::vector<std::uint8_t>(data, data + entry->GetSize()));
+    }
+    else
+    {
+        opened = m_MappedFile->Open(filename, MappedFile::CopyOnWrite);
+    }
+    if (!opened)
+    {
+        spdlog::error("Failed to open the .glb file");
+        return false;
+    }
+
+    std::uint8_t* file = m_MappedFile->GetMutableData();
+    std::size_t   size = m_MappedFile->GetSize();
+
+    std::uint32_t header[3];  // magic, version, length
+    if (size < sizeof(header)) return false;
+    memcpy(header, file, sizeof(header));
+    if (header[0] != s_GlbMagic || header[1] != 2 || header[2] > size)
+    {
+        spdlog::error("Invalid .glb header");
+        return false;
+    }
+
+    const char*   json = nullptr;
+    std::size_t   jsonSize = 0;
+    std::uint8_t* bin = nullptr;
+    std::size_t   binSize = 0;
+    for (std::size_t offset = sizeof(header); offset + 8 <= header[2];)
+    {
+        std::uint32_t chunk[2];  // length, type
+        memcpy(chunk, file + offset, sizeof(chunk));
+        offset += sizeof(chunk);
+        if (chunk[0] > header[2] - offset) break;
+
+        if (chunk[1] == s_GlbChunkJson && !json)
+        {
+            json = reinterpret_cast<const char*>(file + offset);
+            jsonSize = chunk[0];
+        }
+        else if (chunk[1] == s_GlbChunkBin && !bin)
+        {
+            bin = file + offset;
+            binSize = chunk[0];
+        }
+        offset += (chunk[0] + 3) & ~3u;  // chunks are 4-byte aligned
+    }
+
+    JsonValue   gltf;
+    std::string error;
+    if (!json || !JsonValue::Parse(json, json + jsonSize, gltf, error))
+    {
+        spdlog::error("Invalid glTF JSON chunk: {}", error);
+        return false;
+    }
+
+    const JsonValue& buffers = gltf["buffers"];
+    if (buffers.Size() > 1 || buffers[0].Has("uri"))
+    {
+        spdlog::error("External glTF buffers are not supported");
+        return false;
+    }
+
+    std::string directory;
+    size_t      slashPos = filename.find_last_of("/");
+    directory = (slashPos == std::string::npos) ? "" : filename.substr(0, slashPos + 1);
+
+    std::vector<std::string> materialNames;
+    loadGltfMaterials(gltf, directory, materialNames);
+
+    // Mesh instances of the default scene (or every root node if there is none)
+    const JsonValue& nodes = gltf["nodes"];
+    std::vector<std::pair<int, Matrix4x4f>> instances;
+    const JsonValue& scene = gltf["scenes"][gltf["scene"].AsInt(0)];
+    if (scene.IsObject())
+    {
+        for (int i = 0; i < scene["nodes"].Size(); ++i)
+        {
+            collectGltfMeshInstances(nodes, scene["nodes"][i].AsInt(-1), Matrix4x4f(1.f),
+                                     0, instances);
+        }
+    }
+    else
+    {
+        std::vector<bool> isChild(nodes.Size(), false);
+        for (int i = 0; i < nodes.Size(); ++i)
+        {
+            const JsonValue& children = nodes[i]["children"];
+            for (int c = 0; c < children.Size(); ++c)
+            {
+                int child = children[c].AsInt(-1);
+                if (child >= 0 && child < nodes.Size()) isChild[child] = true;
+            }
+        }
+        for (int i = 0; i < nodes.Size(); ++i)
+        {
+            if (!isChild[i])
+                collectGltfMeshInstances(nodes, i, Matrix4x4f(1.f), 0, instances);
+        }
+    }
+
+    std::unordered_set<int>  loadedMeshes;
+    std::unordered_set<int>  bakedAccessors;  // shared accessors are transformed once
+    std::unordered_set<int>  usedAccessors;
+    std::vector<GlbAccessor> positionAccessors;
+    for (const auto& instance : instances)
+    {
+        int               meshIndex = instance.first;
+        const Matrix4x4f& matrix = instance.second;
+        const JsonValue&  gltfMesh = gltf["meshes"][meshIndex];
+        if (!gltfMesh.IsObject()) continue;
+        if (!loadedMeshes.insert(meshIndex).second)
+        {
+            spdlog::warn("  [GLB] mesh {} is instanced more than once, only the first "
+                         "instance is loaded", meshIndex);
+            continue;
+        }
+
+        std::string meshName = gltfMesh["name"].AsString();
+        if (meshName.empty()) meshName = "mesh" + std::to_string(meshIndex);
+
+        const JsonValue& primitives = gltfMesh["primitives"];
+        for (int p = 0; p < primitives.Size(); ++p)
+        {
+            const JsonValue& primitive = primitives[p];
+            const JsonValue& attributes = primitive["attributes"];
+            if (primitive["mode"].AsInt(4) != 4)  // TRIANGLES
+            {
+                spdlog::warn("  [GLB] {} #{}: only triangle lists are supported",
+                             meshName, p);
+                continue;
+            }
+
+            int         positionIndex = attributes["POSITION"].AsInt(-1);
+            GlbAccessor position;
+            if (!resolveGlbAccessor(gltf, positionIndex, bin, binSize, position) ||
+                position.componentType != s_GltfFloat || position.numComponents != 3)
+            {
+                spdlog::warn("  [GLB] {} #{}: invalid POSITION accessor", meshName, p);
+                continue;
+            }
+            int numVerts = position.count;
+
+            PrimitiveViews views;
+            views.positions = AttributeView<3>(position.data, position.stride, numVerts);
+
+            GlbAccessor normal, texCoord, tangent;
+            bool        hasNormals = resolveGlbAttribute(gltf, attributes, "NORMAL", 3,
+                                                         numVerts, bin, binSize, normal);
+            bool        hasTangents = resolveGlbAttribute(gltf, attributes, "TANGENT", 4,
+                                                          numVerts, bin, binSize, tangent);
+            bool        hasTexCoords = resolveGlbAttribute(gltf, attributes, "TEXCOORD_0", 2,
+                                                           numVerts, bin, binSize, texCoord);
+            if (hasNormals)
+                views.normals = AttributeView<3>(normal.data, normal.stride, numVerts);
+            if (hasTangents)
+                views.tangents = AttributeView<4>(tangent.data, tangent.stride, numVerts);
+            if (hasTexCoords)
+                views.texCoords = AttributeView<2>(texCoord.data, texCoord.stride, numVerts);
+
+            if (primitive.Has("indices"))
+            {
+                GlbAccessor indices;
+                int         indicesIndex = primitive["indices"].AsInt(-1);
+                bool valid = resolveGlbAccessor(gltf, indicesIndex, bin, binSize, indices);
+                int  indexSize = gltfComponentSize(indices.componentType);
+                if (!valid || indices.numComponents != 1 ||
+                    (indices.componentType != s_GltfUnsignedByte &&
+                     indices.componentType != s_GltfUnsignedShort &&
+                     indices.componentType != s_GltfUnsignedInt) ||
+                    indices.stride != (std::size_t)indexSize)
+                {
+                    spdlog::warn("  [GLB] {} #{}: invalid index accessor", meshName, p);
+                    continue;
+                }
+                views.indices = IndexView(indices.data, indexSize, indices.count / 3 * 3);
+            }
+            else
+            {
+                views.indices = IndexView(nullptr, 0, numVerts / 3 * 3);
+            }
+
+            bool validIndices = true;
+            for (int i = 0; i < views.indices.GetCount() && validIndices; ++i)
+                validIndices = views.indices[i] < numVerts;
+            if (!validIndices)
+            {
+                spdlog::warn("  [GLB] {} #{}: index out of range", meshName, p);
+                continue;
+            }
+
+            // Bake the node transform into the private mapping
+            if (!isIdentity(matrix) && bakedAccessors.insert(positionIndex).second)
+            {
+                Matrix3x3f normalMatrix = MakeNormalMatrix(matrix);
+                for (int i = 0; i < numVerts; ++i)
+                {
+                    auto*    v = (float*)(position.data + i * position.stride);
+                    Vector3f world = (matrix * Vector4f(v[0], v[1], v[2], 1.f)).xyz;
+                    v[0] = world.x, v[1] = world.y, v[2] = world.z;
+                    if (hasNormals)
+                    {
+                        auto*    n = (float*)(normal.data + i * normal.stride);
+                        Vector3f nw = normalMatrix * Vector3f(n[0], n[1], n[2]);
+                        n[0] = nw.x, n[1] = nw.y, n[2] = nw.z;
+                    }
+                    if (hasTangents)
+                    {
+                        auto*    t = (float*)(tangent.data + i * tangent.stride);
+                        Vector3f tw = (matrix * Vector4f(t[0], t[1], t[2], 0.f)).xyz;
+                        t[0] = tw.x, t[1] = tw.y, t[2] = tw.z;
+                    }
+                }
+            }
+            if (usedAccessors.insert(positionIndex).second)  // for normalization
+                positionAccessors.push_back(position);
+
+            std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>(*this);
+            mesh->SetViews(views);
+
+            // Flat normals and zero texture coordinates if the file has none
+            for (int f = 0; f < views.indices.GetCount() / 3; ++f)
+            {
+                if (!hasNormals)
+                {
+                    Vector3f edge1 = mesh->Vert(f, 1) - mesh->Vert(f, 0);
+                    Vector3f edge2 = mesh->Vert(f, 2) - mesh->Vert(f, 0);
+                    m_Normals.push_back(Normalize(Cross(edge1, edge2)));
+                    for (int v = 0; v < 3; ++v)
+                        mesh->AddNormalIndex((int)m_Normals.size() - 1);
+                }
+                if (!views.texCoords.IsValid())
+                {
+                    if (m_TexCoords.empty()) m_TexCoords.push_back(Vector2f(0.f));
+                    for (int v = 0; v < 3; ++v)
+                        mesh->AddTexCoordIndex(0);
+                }
+            }
+
+            // Materials
+            int materialIndex = primitive["material"].AsInt(-1);
+            if (materialIndex < 0 || materialIndex >= (int)materialNames.size())
+            {
+                // glTF default material: white, fully metallic and rough
+                if (m_Materials.find("default") == m_Materials.end())
+                {
+                    m_Materials["default"] = std::make_shared<Material>("default");
+                    m_Materials["default"]->kd = Vector3f(1.f);
+                    m_PBRMaterials["default"] = std::make_shared<PBRMaterial>("default");
+                    m_PBRMaterials["default"]->roughness = 1.f;
+                    m_PBRMaterials["default"]->metalness = 1.f;
+                }
+                mesh->SetMaterial(m_Materials["default"]);
+                mesh->SetPBRMaterial(m_PBRMaterials["default"]);
+            }
+            else
+            {
+                mesh->SetMaterial(m_Materials[materialNames[materialIndex]]);
+                mesh->SetPBRMaterial(m_PBRMaterials[materialNames[materialIndex]]);
+            }
+
+            std::string name = primitives.Size() > 1 ? meshName + "_" + std::to_string(p)
+                                                     : meshName;
+            while (m_Meshes.find(name) != m_Meshes.end())
+                name += "_" + std::to_string(meshIndex);
+            m_Meshes[name] = mesh;
+        }
+    }
+
+    if (m_Meshes.empty())
+    {
+        spdlog::error("No triangle meshes in the .glb file");
+        return false;
+    }
+
+    if (normalized)
+    {
+        Point3f boundsMin(MaxFloat), boundsMax(MinFloat);
+        for (const GlbAccessor& position : positionAccessors)
+        {
+            for (int i = 0; i < position.count; ++i)
+            {
+                auto* v = (const float*)(position.data + i * position.stride);
+                for (int k = 0; k < 3; ++k)
+                {
+                    boundsMin[k] = Min(boundsMin[k], (Float)v[k]);
+                    boundsMax[k] = Max(boundsMax[k], (Float)v[k]);
+                }
+            }
+        }
+
+        Matrix4f m = makeNormalizationMatrix(boundsMin, boundsMax);
+        for (const GlbAccessor& position : positionAccessors)
+        {
+            for (int i = 0; i < position.count; ++i)
+            {
+                auto*    v = (float*)(position.data + i * position.stride);
+                Vector3f p = (m * Vector4f(v[0], v[1], v[2], 1.f)).xyz;
+                v[0] = p.x, v[1] = p.y, v[2] = p.z;
+            }
+        }
+    }
+
+    // glTF texture coordinates already have a top-left origin
+    m_FlipTexCoordY = false;
+
+    return true;
+}
+
+// Map glTF metallic-roughness materials to Material (Blinn-Phong) and PBRMaterial
+void Model::loadGltfMaterials(const JsonValue& gltf, const std::string& directory,
+                              std::vector<std::string>& materialNames)
+{
+    const JsonValue& materials = gltf["materials"];
+    for (int i = 0; i < materials.Size(); ++i)
+    {
+        const JsonValue& m = materials[i];
+
+        std::string name = m["name"].AsString();
+        if (name.empty()) name = "material" + std::to_string(i);
+        if (m_Materials.find(name) != m_Materials.end()) name += "_" + std::to_string(i);
+
+        auto material = std::make_shared<Material>(name);
+        auto pbrMaterial = std::make_shared<PBRMaterial>(name);
+
+        const JsonValue& pbr = m["pbrMetallicRoughness"];
+        const JsonValue& baseColor = pbr["baseColorFactor"];
+        const JsonValue& emissive = m["emissiveFactor"];  // factors are linear
+        material->kd = Vector3f(baseColor[0].AsNumber(1), baseColor[1].AsNumber(1),
+                                baseColor[2].AsNumber(1));
+        material->ke = Vector3f(emissive[0].AsNumber(0), emissive[1].AsNumber(0),
+                                emissive[2].AsNumber(0));
+        pbrMaterial->albedo = material->kd;
+        pbrMaterial->ke = material->ke;
+        pbrMaterial->metalness = pbr["metallicFactor"].AsNumber(1);
+        pbrMaterial->roughness = pbr["roughnessFactor"].AsNumber(1);
+
+        const JsonValue& baseColorTexture = pbr["baseColorTexture"];
+        loadGltfTexture(gltf, directory, baseColorTexture, material->diffuseMap);
+        loadGltfTexture(gltf, directory, baseColorTexture, pbrMaterial->baseColorMap);
+        loadGltfTexture(gltf, directory, m["normalTexture"], material->normalMap);
+        loadGltfTexture(gltf, directory, m["normalTexture"], pbrMaterial->normalMap);
+        loadGltfTexture(gltf, directory, m["emissiveTexture"], material->emissiveMap);
+        loadGltfTexture(gltf, directory, m["emissiveTexture"], pbrMaterial->emissiveMap);
+
+        // Packed channels: occlusion R, roughness G, metalness B
+        const JsonValue& metallicRoughness = pbr["metallicRoughnessTexture"];
+        loadGltfTexture(gltf, directory, metallicRoughness, pbrMaterial->roughnessMap);
+        loadGltfTexture(gltf, directory, metallicRoughness, pbrMaterial->metalnessMap);
+        loadGltfTexture(gltf, directory, m["occlusionTexture"],
+                        pbrMaterial->ambientOcclusionMap);
+        pbrMaterial->roughnessChannel = 1;
+        pbrMaterial->metalnessChannel = 2;
+        pbrMaterial->aoChannel = 0;
+
+        m_Materials[name] = material;
+        m_PBRMaterials[name] = pbrMaterial;
+        materialNames.push_back(name);
+    }
+}
+
+void Model::loadGltfTexture(const JsonValue& gltf, const std::string& directory,
+                            const JsonValue&          textureInfo,
+                            std::shared_ptr<Texture>& texture)
+{
+    if (!textureInfo.IsObject()) return;
+    if (textureInfo["texCoord"].AsInt(0) != 0)
+    {
+        spdlog::warn("  [GLB] only TEXCOORD_0 is supported, texture is ignored");
+        return;
+    }
+
+    const JsonValue&   gltfTexture = gltf["textures"][textureInfo["index"].AsInt(-1)];
+    const JsonValue&   image = gltf["images"][gltfTexture["source"].AsInt(-1)];
+    const std::string& uri = image["uri"].AsString();
+
+    // Only external .tga images can be decoded (no PNG/JPEG decoder)
+    if (uri.empty() || uri.compare(0, 5, "data:") == 0 || GetExtension(uri) != ".tga")
+    {
+        spdlog::warn("  [GLB] unsupported image \'{}\', texture is ignored",
+                     uri.empty() ? image["mimeType"].AsString() : uri);
+        return;
+    }
+    loadTexture(directory + uri, texture, false);
 }
 
 // Generate Tangents
@@ -433,11 +1857,22 @@ void Model::generateTangents()
     for (auto iter = m_Meshes.begin(); iter != m_Meshes.end(); ++iter)
     {
         Mesh& mesh = *(iter->second);
+
+        // Meshes with views index their own vertices, tangents go to a separate range
+        const PrimitiveViews& views = mesh.GetViews();
+        if (views.tangents.IsValid()) continue;  // provided by the file
+        int base = 0;
+        if (mesh.HasViews())
+        {
+            base = (int)m_Tangents.size();
+            m_Tangents.resize(base + views.positions.GetCount(), Vector3f(0.f));
+        }
+
         for (int f = 0; f < mesh.NumFaces(); ++f)
         {
-            int      indexP0 = mesh.GetVertIndex(f, 0);
-            int      indexP1 = mesh.GetVertIndex(f, 1);
-            int      indexP2 = mesh.GetVertIndex(f, 2);
+            int      indexP0 = base + mesh.GetVertIndex(f, 0);
+            int      indexP1 = base + mesh.GetVertIndex(f, 1);
+            int      indexP2 = base + mesh.GetVertIndex(f, 2);
             Vector3f edge1 = mesh.Vert(f, 1) - mesh.Vert(f, 0);
             Vector3f edge2 = mesh.Vert(f, 2) - mesh.Vert(f, 0);
             Vector2f deltaUv1 = mesh.TexCoord(f, 1) - mesh.TexCoord(f, 0);
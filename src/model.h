@@ -7,27 +7,66 @@
 #include "geometry.h"
 #include "material.h"
 #include "mesh.h"
+#include "meshstream.h"
 #include "pbrmaterial.h"
 #include "texture.h"
 
+class JsonValue;
+class MappedFile;
 class Shader;
+class ThreadPool;
 
 class Model
 {
 public:
     // Public Static Methods
+    // Supported formats: .obj (+ .mtl) and .glb (glTF 2.0 binary, read in place)
+    // With a thread pool, texture decoding is queued on the pool and the model is
+    // not usable before FinishLoading() is called (from outside the pool)
     static std::unique_ptr<Model> Load(const std::string& filename,
                                        bool               normalized = false,
                                        bool               generateTangent = false,
-                                       bool               flipTexCoordY = true);
+                                       bool               flipTexCoordY = true,
+                                       ThreadPool*        pool = nullptr);
+
+    // Out-of-core Model: faces stay on disk in a cooked chunk file ('<obj>.chunks') and
+    // are streamed through the shaders in batches that fit in budgetBytes
+    static std::unique_ptr<Model> LoadStreaming(const std::string& filename,
+                                                bool               normalized,
+                                                bool               generateTangent,
+                                                bool               flipTexCoordY,
+                                                std::size_t        budgetBytes,
+                                                ThreadPool*        pool = nullptr);
+
+    // Wait For Pending Textures And Print Model Info
+    void FinishLoading();
 
     // Constructors
-    Model() : m_Meshes(), m_Verts(), m_TexCoords(), m_Normals(), m_HasTangents() { }
+    Model()
+        : m_Meshes(),
+          m_Verts(),
+          m_TexCoords(),
+          m_Normals(),
+          m_HasTangents(),
+          m_SupportPBR(),
+          m_Normalized(),
+          m_FlipTexCoordY(),
+          m_Packed(false),
+          m_StreamBudget(0),
+          m_StreamNumChunks(0),
+          m_StreamTransform(1.f),
+          m_ThreadPool(nullptr)
+    {
+    }
     explicit Model(const Model& m) = delete;
 
     // Starts Rendering This Fun Stuff!
     void Render(Shader& shader) const;
 
+    // Textures sampled by the active shading path of meshes inside the view volume
+    void CollectVisibleTextures(const Matrix4x4f&                    mvp,
+                                std::unordered_set<const Texture*>& textures) const;
+
     // Get Vertex Data
     Vector3f GetVert(int index) const { return m_Verts[index]; }
     Vector2f GetTexCoord(int index) const { return m_TexCoords[index]; }
@@ -39,6 +78,14 @@ public:
 
     inline bool HasTangents() const { return m_HasTangents; }
     inline bool SupportPBR() const { return m_SupportPBR; }
+    inline bool IsStreaming() const { return !m_StreamFilename.empty(); }
+
+    // Files read while loading: model, material and texture files
+    const std::set<std::string>& GetSourceFiles() const { return m_SourceFiles; }
+
+    // Decodes the texture file again for every material slot using it, false if the
+    // model does not use it
+    bool ReloadTexture(const std::string& textureFilename);
 
 private:
     std::map<std::string, std::shared_ptr<Mesh>>        m_Meshes;
@@ -51,6 +98,42 @@ private:
     std::vector<Vector3f> m_Tangents;
     bool                  m_HasTangents;
     bool                  m_SupportPBR;
+    bool                  m_Normalized;
+    bool                  m_FlipTexCoordY;
+
+    // .glb Mapping (meshes hold views into it)
+    std::shared_ptr<MappedFile> m_MappedFile;
+
+    // Shared Asset Store and Pack Archive (.obj meshes hold views into the object)
+    std::string                       m_MtlFilename;
+    std::shared_ptr<const MappedFile> m_SharedObject;
+    bool                              m_Packed;  // object is a pack archive entry
+
+    // Streaming Mode
+    std::string              m_StreamFilename;
+    std::size_t              m_StreamBudget;
+    std::uint32_t            m_StreamNumChunks;
+    std::vector<StreamGroup> m_StreamGroups;
+    Matrix4x4f               m_StreamTransform;  // normalization
+
+    // Texture Loading (one decode per file, possibly shared by several slots)
+    using TextureFuture = std::shared_future<std::shared_ptr<Texture>>;
+    std::string                                    m_Filename;
+    ThreadPool*                                    m_ThreadPool;
+    std::unordered_map<std::string, TextureFuture> m_TextureRequests;
+    std::unordered_map<std::string, std::shared_ptr<Texture>> m_DeferredTextures;
+    std::vector<std::pair<TextureFuture, std::shared_ptr<Texture>*>> m_PendingTextures;
+
+    // Source Files (slots point into materials, which the model owns)
+    struct TextureSlot
+    {
+        std::string               filename;
+        std::shared_ptr<Texture>* texture;
+        bool                      flipVertically;
+    };
+    std::set<std::string>    m_SourceFiles;
+    std::vector<TextureSlot> m_TextureSlots;
+    std::set<std::string>    m_OrmSourceFiles;  // packed by packOrmTextures()
 
     // .obj and .mtl Parsers
     // Supported Format: 'g ' is followed by 'usemtl ', which is followed by 'f ...'
@@ -59,9 +142,39 @@ private:
                        bool flipVertically);
     void loadTexture(const std::string&        textureFilename,
                      std::shared_ptr<Texture>& texture, bool flipVertically);
+    void requestTexture(const std::string&        textureFilename,
+                        std::shared_ptr<Texture>& texture, bool flipVertically);
+    void finishTextures();
+    void packOrmTextures();
+    void compressTextures();
+
+    // .glb Parser
+    // Triangle primitives of the default scene; node transforms are applied
+    bool loadGlbFile(const std::string& filename, bool normalized);
+    void loadGltfMaterials(const JsonValue& gltf, const std::string& directory,
+                           std::vector<std::string>& materialNames);
+    void loadGltfTexture(const JsonValue& gltf, const std::string& directory,
+                         const JsonValue& textureInfo, std::shared_ptr<Texture>& texture);
+
+    // Shared Asset Store and Pack Archive
+    // Each mesh is welded into one indexed vertex array, which is published to (or
+    // attached from) shared memory or a pack archive entry and read in place. The
+    // payload lives in the owner object.
+    bool cookSharedObject(std::vector<std::uint8_t>& bytes) const;
+    bool publishSharedObject(const std::string& name);
+    bool attachSharedObject(std::shared_ptr<const MappedFile> owner,
+                            const std::uint8_t* payload, std::size_t size,
+                            const std::string& filename, bool flipVertically);
+    void bindSharedMeshes(std::shared_ptr<const MappedFile> owner,
+                          const std::uint8_t*               payload);
+
+    // Draw chunks of a streaming model one at a time
+    void renderStreamed(Shader& shader) const;
 
     // Make Position Coordinates Between [-1, 1]
-    void normalizePositionVertices();
+    void              normalizePositionVertices();
+    static Matrix4x4f makeNormalizationMatrix(const Point3f& boundsMin,
+                                              const Point3f& boundsMax);
     // Generate Tangents For TBN Matrix Transformation
     void generateTangents();
 };
@@ -56,7 +56,7 @@ void OutputAlbedoGBuffer()
 {
     if (ForkerGL::AlbedoGBuffer.GetWidth() != 0)
     {
-        ForkerGL::AlbedoGBuffer.GenerateImage().WriteTgaFile(
+        ForkerGL::AlbedoGBuffer.GenerateImage(true).WriteTgaFile(  // stored linear
             "output/gbuffer_albedo.tga");
     }
 }
@@ -0,0 +1,312 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#include "packarchive.h"
+
+#include <spdlog/spdlog.h>
+
+#include "assetio.h"
+#include "blockcodec.h"
+#include "mappedfile.h"
+#include "threadpool.h"
+#include "utility.h"
+
+static const char          s_Magic[4] = { 'F', 'K', 'P', 'K' };
+static const std::uint32_t s_Version = 1;
+static const std::uint32_t s_BlockSize = 256 * 1024;
+
+struct PackHeader
+{
+    char          magic[4];
+    std::uint32_t version;
+    std::uint32_t numEntries;
+    std::uint32_t numBlocks;
+    std::uint32_t blockSize;
+    std::uint32_t sceneEntry;
+    std::uint32_t namesSize;
+    std::uint32_t reserved;
+};
+
+struct PackEntry
+{
+    std::uint32_t nameOffset;  // into the name table
+    std::uint32_t nameLength;
+    std::uint64_t size;  // uncompressed
+    std::uint32_t firstBlock;
+    std::uint32_t numBlocks;
+};
+
+// A block is stored as is when compression does not make it smaller
+struct PackBlock
+{
+    std::uint64_t offset;  // from the start of the archive
+    std::uint32_t storedSize;
+    std::uint32_t size;
+};
+
+static_assert(sizeof(PackHeader) == 32, "Unexpected pack header size");
+static_assert(sizeof(PackEntry) == 24, "Unexpected pack entry size");
+static_assert(sizeof(PackBlock) == 16, "Unexpected pack block size");
+
+// Mounted archive, read-only while loaders run
+using EntryMap = std::unordered_map<std::string, std::shared_ptr<const MappedFile>>;
+static EntryMap    s_Entries;
+static std::string s_SceneFilename;
+static bool        s_Mounted = false;
+
+// Recorded entries, sorted by name
+static std::mutex                                       s_RecordMutex;
+static std::map<std::string, std::vector<std::uint8_t>> s_Recorded;
+static bool                                             s_Recording = false;
+
+/////////////////////////////////////////////////////////////////////////////////
+
+// Validates the tables, then decompresses every block on the pool straight into its
+// entry buffer
+static bool mountEntries(const std::vector<std::uint8_t>& archive, ThreadPool& pool,
+                         PackHeader& header)
+{
+    if (archive.size() < sizeof(PackHeader)) return false;
+    memcpy(&header, archive.data(), sizeof(PackHeader));
+    if (memcmp(header.magic, s_Magic, sizeof(s_Magic)) != 0 ||
+        header.version != s_Version || header.sceneEntry >= header.numEntries)
+        return false;
+
+    std::size_t entriesOffset = sizeof(PackHeader);
+    std::size_t namesOffset = entriesOffset + header.numEntries * sizeof(PackEntry);
+    std::size_t blocksOffset = namesOffset + header.namesSize;
+    std::size_t dataOffset = blocksOffset + header.numBlocks * sizeof(PackBlock);
+    if (dataOffset > archive.size()) return false;
+
+    std::vector<PackEntry> entries(header.numEntries);
+    std::vector<PackBlock> blocks(header.numBlocks);
+    memcpy(entries.data(), archive.data() + entriesOffset,
+           entries.size() * sizeof(PackEntry));
+    memcpy(blocks.data(), archive.data() + blocksOffset,
+           blocks.size() * sizeof(PackBlock));
+    const char* names = (const char*)archive.data() + namesOffset;
+
+    std::vector<std::vector<std::uint8_t>> buffers(entries.size());
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        const PackEntry& entry = entries[i];
+        if ((std::uint64_t)entry.nameOffset + entry.nameLength > header.namesSize ||
+            (std::uint64_t)entry.firstBlock + entry.numBlocks > blocks.size())
+            return false;
+
+        std::uint64_t covered = 0;
+        for (std::uint32_t b = 0; b < entry.numBlocks; ++b)
+        {
+            const PackBlock& block = blocks[entry.firstBlock + b];
+            if (block.offset < dataOffset || block.storedSize > block.size ||
+                block.offset + block.storedSize > archive.size())
+                return false;
+            covered += block.size;
+        }
+        if (covered != entry.size) return false;
+        buffers[i].resize((std::size_t)entry.size);
+    }
+
+    std::vector<std::future<bool>> results;
+    results.reserve(blocks.size());
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        std::uint8_t* dst = buffers[i].data();
+        for (std::uint32_t b = 0; b < entries[i].numBlocks; ++b)
+        {
+            const PackBlock&    block = blocks[entries[i].firstBlock + b];
+            const std::uint8_t* src = archive.data() + block.offset;
+            results.push_back(pool.Enqueue([src, dst, &block]() {
+                if (block.storedSize == block.size)
+                {
+                    memcpy(dst, src, block.size);
+                    return true;
+                }
+                return BlockCodec::Decompress(src, block.storedSize, dst, block.size);
+            }));
+            dst += block.size;
+        }
+    }
+
+    bool success = true;
+    for (std::future<bool>& result : results)
+        success = result.get() && success;
+    if (!success) return false;
+
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        std::string name(names + entries[i].nameOffset, entries[i].nameLength);
+        auto        file = std::make_shared<MappedFile>();
+        file->OpenBuffer(std::move(buffers[i]));  // empty entries stay closed
+        if (i == header.sceneEntry) s_SceneFilename = name;
+        s_Entries[name] = std::move(file);
+    }
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+bool PackArchive::Mount(const std::string& filename, ThreadPool& pool)
+{
+    Unmount();
+
+    std::vector<std::uint8_t> archive;
+    if (!AssetIO::Read(filename, archive))
+    {
+        spdlog::error("Failed to open pack archive: {}", filename);
+        return false;
+    }
+
+    PackHeader header;
+    if (!mountEntries(archive, pool, header))
+    {
+        spdlog::error("Invalid pack archive: {}", filename);
+        Unmount();
+        return false;
+    }
+
+    s_Mounted = true;
+    spdlog::info("[Pack] {} entries, {} blocks ({:.2f} MB) from {}", header.numEntries,
+                 header.numBlocks, archive.size() / (1024.0 * 1024.0), filename);
+    return true;
+}
+
+void PackArchive::Unmount()
+{
+    s_Mounted = false;
+    s_Entries.clear();
+    s_SceneFilename.clear();
+}
+
+bool PackArchive::IsMounted()
+{
+    return s_Mounted;
+}
+
+const std::string& PackArchive::GetSceneFilename()
+{
+    return s_SceneFilename;
+}
+
+std::shared_ptr<const MappedFile> PackArchive::Find(const std::string& name)
+{
+    if (!s_Mounted) return nullptr;
+    auto iter = s_Entries.find(name);
+    return iter != s_Entries.end() ? iter->second : nullptr;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+void PackArchive::BeginRecording()
+{
+    std::lock_guard<std::mutex> lock(s_RecordMutex);
+    s_Recorded.clear();
+    s_Recording = true;
+}
+
+bool PackArchive::IsRecording()
+{
+    return s_Recording;
+}
+
+void PackArchive::Record(const std::string& name, std::vector<std::uint8_t> bytes)
+{
+    std::lock_guard<std::mutex> lock(s_RecordMutex);
+    s_Recorded[name] = std::move(bytes);
+}
+
+bool PackArchive::WriteRecorded(const std::string& filename,
+                                const std::string& sceneFilename)
+{
+    std::lock_guard<std::mutex> lock(s_RecordMutex);
+    s_Recording = false;
+
+    auto sceneIter = s_Recorded.find(sceneFilename);
+    if (sceneIter == s_Recorded.end())
+    {
+        spdlog::error("Scene file was not recorded: {}", sceneFilename);
+        return false;
+    }
+
+    PackHeader header;
+    memcpy(header.magic, s_Magic, sizeof(s_Magic));
+    header.version = s_Version;
+    header.numEntries = (std::uint32_t)s_Recorded.size();
+    header.numBlocks = 0;
+    header.blockSize = s_BlockSize;
+    header.sceneEntry = (std::uint32_t)std::distance(s_Recorded.begin(), sceneIter);
+    header.namesSize = 0;
+    header.reserved = 0;
+
+    std::vector<PackEntry> entries;
+    std::string            names;
+    for (const auto& recorded : s_Recorded)
+    {
+        PackEntry entry;
+        entry.nameOffset = (std::uint32_t)names.size();
+        entry.nameLength = (std::uint32_t)recorded.first.size();
+        entry.size = recorded.second.size();
+        entry.firstBlock = header.numBlocks;
+        entry.numBlocks = (std::uint32_t)((entry.size + s_BlockSize - 1) / s_BlockSize);
+        header.numBlocks += entry.numBlocks;
+        entries.push_back(entry);
+        names += recorded.first;
+    }
+    header.namesSize = (std::uint32_t)names.size();
+
+    std::uint64_t dataOffset = sizeof(PackHeader) + entries.size() * sizeof(PackEntry) +
+                               names.size() + header.numBlocks * sizeof(PackBlock);
+
+    std::vector<PackBlock>    blocks;
+    std::vector<std::uint8_t> data;
+    for (const auto& recorded : s_Recorded)
+    {
+        const std::vector<std::uint8_t>& bytes = recorded.second;
+        for (std::size_t start = 0; start < bytes.size(); start += s_BlockSize)
+        {
+            PackBlock block;
+            block.offset = dataOffset + data.size();
+            std::size_t size = Min<std::size_t>(s_BlockSize, bytes.size() - start);
+            block.size = (std::uint32_t)size;
+
+            const std::uint8_t* src = bytes.data() + start;
+            std::size_t         compressed = BlockCodec::Compress(src, block.size, data);
+            if (compressed >= block.size)
+            {
+                data.resize(data.size() - compressed);
+                data.insert(data.end(), src, src + block.size);
+                compressed = block.size;
+            }
+            block.storedSize = (std::uint32_t)compressed;
+            blocks.push_back(block);
+        }
+    }
+
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    out.write((const char*)&header, sizeof(PackHeader));
+    out.write((const char*)entries.data(), entries.size() * sizeof(PackEntry));
+    out.write(names.data(), names.size());
+    out.write((const char*)blocks.data(), blocks.size() * sizeof(PackBlock));
+    out.write((const char*)data.data(), data.size());
+    if (!out.good())
+    {
+        spdlog::error("Failed to write pack archive: {}", filename);
+        return false;
+    }
+
+    std::uint64_t total = dataOffset + data.size();
+    std::uint64_t raw = 0;
+    for (const PackEntry& entry : entries)
+        raw += entry.size;
+    spdlog::info("[Pack] {} entries, {:.2f} MB -> {:.2f} MB: {}", entries.size(),
+                 raw / (1024.0 * 1024.0), total / (1024.0 * 1024.0), filename);
+    s_Recorded.clear();
+    return true;
+}
+
+std::string PackArchive::GetCookedName(const std::string& filename,
+                                       const std::string& options)
+{
+    return filename + "|" + options;
+}
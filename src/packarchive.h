@@ -0,0 +1,42 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#pragma once
+
+class MappedFile;
+class ThreadPool;
+
+// Scene pack archive (.fpk): a scene file and everything it loads in one file. Meshes
+// and textures are stored cooked (welded vertex arrays, decoded texels with mip levels)
+// and are used in place. Every entry is split into independently compressed blocks,
+// which are decompressed in parallel straight into the entry buffers after one
+// sequential read of the archive.
+//
+// Packing records the files and cooked assets while the scene is loaded as usual
+// ('ForkerRenderer --pack <scene file> <archive>').
+//
+// Layout: [Header] [Entry x numEntries] [names] [Block x numBlocks] [block data]
+class PackArchive
+{
+public:
+    // Loading (entries stay alive while meshes or textures use them after Unmount())
+    static bool               Mount(const std::string& filename, ThreadPool& pool);
+    static void               Unmount();
+    static bool               IsMounted();
+    static const std::string& GetSceneFilename();
+
+    // nullptr if the archive has no such entry
+    static std::shared_ptr<const MappedFile> Find(const std::string& name);
+
+    // Packing (Record() may be called from any thread)
+    static void BeginRecording();
+    static bool IsRecording();
+    static void Record(const std::string& name, std::vector<std::uint8_t> bytes);
+    static bool WriteRecorded(const std::string& filename,
+                              const std::string& sceneFilename);
+
+    // Entry name of a cooked asset, e.g. "obj/head.obj|model normalized=1 tangents=0"
+    static std::string GetCookedName(const std::string& filename,
+                                     const std::string& options);
+};
@@ -0,0 +1,328 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#pragma once
+
+#include "geometry.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define FORKER_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+// Two SSE registers per packet when Float is float, plain lanes otherwise
+#if defined(FORKER_HAS_SSE2) && !defined(FLOAT_AS_DOUBLE)
+#define FORKER_PACKET_SSE2
+#endif
+
+// Packets of 8 Floats (e.g. 8 contiguous pixels of a row) for the deferred lighting
+// pass. Every operation is the scalar one per lane (IEEE operations, Max/Min/Clamp01
+// select as std::max/std::min do), so a packet computes the same values as the scalar
+// code written with the same operations in the same order. Pow is std::pow per lane.
+struct Float8
+{
+    static const int Width = 8;
+
+    Float8() = default;
+
+#ifdef FORKER_PACKET_SSE2
+    Float8(Float v) : lo(_mm_set1_ps(v)), hi(_mm_set1_ps(v)) { }
+    Float8(__m128 l, __m128 h) : lo(l), hi(h) { }
+
+    static Float8 Load(const Float* values)  // 8 values
+    {
+        return Float8(_mm_loadu_ps(values), _mm_loadu_ps(values + 4));
+    }
+
+    void Store(Float* values) const
+    {
+        _mm_storeu_ps(values, lo);
+        _mm_storeu_ps(values + 4, hi);
+    }
+
+    __m128 lo, hi;  // lanes 0-3, 4-7
+#else
+    Float8(Float v)
+    {
+        for (int i = 0; i < Width; ++i)
+            lanes[i] = v;
+    }
+
+    static Float8 Load(const Float* values)  // 8 values
+    {
+        Float8 ret;
+        for (int i = 0; i < Width; ++i)
+            ret.lanes[i] = values[i];
+        return ret;
+    }
+
+    void Store(Float* values) const
+    {
+        for (int i = 0; i < Width; ++i)
+            values[i] = lanes[i];
+    }
+
+    Float lanes[Width];
+#endif
+};
+
+// Lane mask (result of a comparison)
+struct Mask8
+{
+#ifdef FORKER_PACKET_SSE2
+    __m128 lo, hi;  // all bits set in true lanes
+
+    static Mask8 FromBits(int bits)  // lane i is set if bit i is
+    {
+        __m128i lanes = _mm_setr_epi32(1, 2, 4, 8);
+        __m128i lo = _mm_and_si128(_mm_set1_epi32(bits), lanes);
+        __m128i hi = _mm_and_si128(_mm_set1_epi32(bits >> 4), lanes);
+        return Mask8{ _mm_castsi128_ps(_mm_cmpeq_epi32(lo, lanes)),
+                      _mm_castsi128_ps(_mm_cmpeq_epi32(hi, lanes)) };
+    }
+
+    int Bits() const { return _mm_movemask_ps(lo) | (_mm_movemask_ps(hi) << 4); }
+#else
+    bool lanes[Float8::Width];
+
+    static Mask8 FromBits(int bits)  // lane i is set if bit i is
+    {
+        Mask8 ret;
+        for (int i = 0; i < Float8::Width; ++i)
+            ret.lanes[i] = (bits >> i) & 1;
+        return ret;
+    }
+
+    int Bits() const
+    {
+        int bits = 0;
+        for (int i = 0; i < Float8::Width; ++i)
+            bits |= (int)lanes[i] << i;
+        return bits;
+    }
+#endif
+};
+
+/////////////////////////////////////////////////////////////////////////////////
+
+// Float8 Inline Functions
+#ifdef FORKER_PACKET_SSE2
+
+#define FORKER_PACKET_OP(name, intrinsic)                            \
+    inline Float8 name(const Float8& a, const Float8& b)             \
+    {                                                                \
+        return Float8(intrinsic(a.lo, b.lo), intrinsic(a.hi, b.hi)); \
+    }
+
+FORKER_PACKET_OP(operator+, _mm_add_ps)
+FORKER_PACKET_OP(operator-, _mm_sub_ps)
+FORKER_PACKET_OP(operator*, _mm_mul_ps)
+FORKER_PACKET_OP(operator/, _mm_div_ps)
+
+#undef FORKER_PACKET_OP
+
+// std::max(a, b) is (a < b) ? b : a, maxps(b, a) is (b > a) ? b : a
+inline Float8 Max(const Float8& a, const Float8& b)
+{
+    return Float8(_mm_max_ps(b.lo, a.lo), _mm_max_ps(b.hi, a.hi));
+}
+
+// std::min(a, b) is (b < a) ? b : a, minps(b, a) as well
+inline Float8 Min(const Float8& a, const Float8& b)
+{
+    return Float8(_mm_min_ps(b.lo, a.lo), _mm_min_ps(b.hi, a.hi));
+}
+
+inline Float8 Sqrt(const Float8& a)
+{
+    return Float8(_mm_sqrt_ps(a.lo), _mm_sqrt_ps(a.hi));
+}
+
+inline Mask8 operator<(const Float8& a, const Float8& b)
+{
+    return Mask8{ _mm_cmplt_ps(a.lo, b.lo), _mm_cmplt_ps(a.hi, b.hi) };
+}
+
+inline Float8 Select(const Mask8& mask, const Float8& a, const Float8& b)
+{
+    return Float8(_mm_or_ps(_mm_and_ps(mask.lo, a.lo), _mm_andnot_ps(mask.lo, b.lo)),
+                  _mm_or_ps(_mm_and_ps(mask.hi, a.hi), _mm_andnot_ps(mask.hi, b.hi)));
+}
+
+#else
+
+#define FORKER_PACKET_OP(name, op)                       \
+    inline Float8 name(const Float8& a, const Float8& b) \
+    {                                                    \
+        Float8 ret;                                      \
+        for (int i = 0; i < Float8::Width; ++i)          \
+            ret.lanes[i] = a.lanes[i] op b.lanes[i];     \
+        return ret;                                      \
+    }
+
+FORKER_PACKET_OP(operator+, +)
+FORKER_PACKET_OP(operator-, -)
+FORKER_PACKET_OP(operator*, *)
+FORKER_PACKET_OP(operator/, /)
+
+#undef FORKER_PACKET_OP
+
+inline Float8 Max(const Float8& a, const Float8& b)
+{
+    Float8 ret;
+    for (int i = 0; i < Float8::Width; ++i)
+        ret.lanes[i] = std::max(a.lanes[i], b.lanes[i]);
+    return ret;
+}
+
+inline Float8 Min(const Float8& a, const Float8& b)
+{
+    Float8 ret;
+    for (int i = 0; i < Float8::Width; ++i)
+        ret.lanes[i] = std::min(a.lanes[i], b.lanes[i]);
+    return ret;
+}
+
+inline Float8 Sqrt(const Float8& a)
+{
+    Float8 ret;
+    for (int i = 0; i < Float8::Width; ++i)
+        ret.lanes[i] = std::sqrt(a.lanes[i]);
+    return ret;
+}
+
+inline Mask8 operator<(const Float8& a, const Float8& b)
+{
+    Mask8 ret;
+    for (int i = 0; i < Float8::Width; ++i)
+        ret.lanes[i] = a.lanes[i] < b.lanes[i];
+    return ret;
+}
+
+inline Float8 Select(const Mask8& mask, const Float8& a, const Float8& b)
+{
+    Float8 ret;
+    for (int i = 0; i < Float8::Width; ++i)
+        ret.lanes[i] = mask.lanes[i] ? a.lanes[i] : b.lanes[i];
+    return ret;
+}
+
+#endif
+
+inline Float8& operator+=(Float8& a, const Float8& b)
+{
+    return a = a + b;
+}
+
+inline Float8& operator*=(Float8& a, const Float8& b)
+{
+    return a = a * b;
+}
+
+inline Float8 Clamp01(const Float8& val)
+{
+    return Min(Float8(1.f), Max(val, Float8(0.f)));
+}
+
+// No vector pow, std::pow per lane
+inline Float8 Pow(const Float8& val, const Float8& pval)
+{
+    Float v[Float8::Width], p[Float8::Width];
+    val.Store(v);
+    pval.Store(p);
+    for (int i = 0; i < Float8::Width; ++i)
+        v[i] = std::pow(v[i], p[i]);
+    return Float8::Load(v);
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+// Packet of 8 Vector3f (SoA)
+struct Vec3x8
+{
+    Float8 x, y, z;
+
+    Vec3x8() = default;
+    explicit Vec3x8(const Float8& v) : x(v), y(v), z(v) { }
+    explicit Vec3x8(const Vector3f& v) : x(v.x), y(v.y), z(v.z) { }  // in every lane
+    Vec3x8(const Float8& x, const Float8& y, const Float8& z) : x(x), y(y), z(z) { }
+
+    static Vec3x8 Load(const Vector3f* values)  // 8 vectors
+    {
+        Float lanes[3][Float8::Width];
+        for (int i = 0; i < Float8::Width; ++i)
+        {
+            lanes[0][i] = values[i].x;
+            lanes[1][i] = values[i].y;
+            lanes[2][i] = values[i].z;
+        }
+        return Vec3x8(Float8::Load(lanes[0]), Float8::Load(lanes[1]),
+                      Float8::Load(lanes[2]));
+    }
+
+    void Store(Vector3f* values) const
+    {
+        Float lanes[3][Float8::Width];
+        x.Store(lanes[0]);
+        y.Store(lanes[1]);
+        z.Store(lanes[2]);
+        for (int i = 0; i < Float8::Width; ++i)
+            values[i] = Vector3f(lanes[0][i], lanes[1][i], lanes[2][i]);
+    }
+
+    Vec3x8 operator+(const Vec3x8& v) const { return Vec3x8(x + v.x, y + v.y, z + v.z); }
+    Vec3x8 operator-(const Vec3x8& v) const { return Vec3x8(x - v.x, y - v.y, z - v.z); }
+    Vec3x8 operator*(const Vec3x8& v) const { return Vec3x8(x * v.x, y * v.y, z * v.z); }
+    Vec3x8 operator/(const Vec3x8& v) const { return Vec3x8(x / v.x, y / v.y, z / v.z); }
+    Vec3x8 operator*(const Float8& f) const { return Vec3x8(x * f, y * f, z * f); }
+
+    // Multiplies by the inverse, as Vector3f does
+    Vec3x8 operator/(const Float8& f) const
+    {
+        Float8 inv = Float8(1.f) / f;
+        return Vec3x8(x * inv, y * inv, z * inv);
+    }
+
+    Vec3x8& operator+=(const Vec3x8& v) { return *this = *this + v; }
+    Vec3x8& operator*=(const Float8& f) { return *this = *this * f; }
+
+    Float8 Length() const { return Sqrt(x * x + y * y + z * z); }
+};
+
+// Vec3x8 Inline Functions
+inline Vec3x8 operator*(const Float8& s, const Vec3x8& v)
+{
+    return v * s;
+}
+
+// Accumulates from zero as Dot(Vector) does (-0 products)
+inline Float8 Dot(const Vec3x8& v1, const Vec3x8& v2)
+{
+    return Float8(0.f) + v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+}
+
+inline Vec3x8 Normalize(const Vec3x8& v)
+{
+    return v / v.Length();
+}
+
+inline Vec3x8 Lerp(const Float8& t, const Vec3x8& v1, const Vec3x8& v2)
+{
+    return (1.f - t) * v1 + t * v2;
+}
+
+inline Vec3x8 Clamp01(const Vec3x8& val)
+{
+    return Vec3x8(Clamp01(val.x), Clamp01(val.y), Clamp01(val.z));
+}
+
+inline Vec3x8 Pow(const Vec3x8& v, Float pval)
+{
+    return Vec3x8(Pow(v.x, pval), Pow(v.y, pval), Pow(v.z, pval));
+}
+
+inline Vec3x8 Select(const Mask8& mask, const Vec3x8& a, const Vec3x8& b)
+{
+    return Vec3x8(Select(mask, a.x, b.x), Select(mask, a.y, b.y), Select(mask, a.z, b.z));
+}
@@ -6,6 +6,8 @@
 
 #include <spdlog/spdlog.h>
 
+#include "threadpool.h"
+
 static const Float s_ShadowViewSize = 3.0f;
 static const Float s_ShadowNearPlane = 0.1f;
 static const Float s_ShadowFarPlane = 20.f;
@@ -30,11 +32,77 @@ inline int GetHeight(const Scene& scene)
                             : scene.GetHeight();
 }
 
+inline Matrix4x4f GetProjectionMatrix(const Scene& scene)
+{
+    Float ratio = scene.GetRatio();
+    return (scene.GetProjectionType() == Camera::Orthographic)
+               ? scene.GetCamera().GetOrthographicMatrix(-1.f * ratio, 1.f * ratio, -1.f,
+                                                         1.f, s_CameraNearPlane,
+                                                         s_CameraFarPlane)
+               : scene.GetCamera().GetPerspectiveMatrix(45.f, ratio, s_CameraNearPlane,
+                                                        s_CameraFarPlane);
+}
+
 void Preconfigure(const Scene& scene)
 {
+    stepStopwatch.reset();  // frames may be rendered again later (watch mode)
     ForkerGL::SetViewportMatrix(0, 0, GetWidth(scene), GetHeight(scene));
-    ForkerGL::TextureWrapMode(Texture::NoWrap);     // or Repeat, ClampedToEdge, etc
-    ForkerGL::TextureFilterMode(Texture::Nearest);  // or Linear
+
+    PrefetchTextures(scene);
+    UpdateVirtualTextures(scene);
+}
+
+void PrefetchTextures(const Scene& scene)
+{
+    if (ForkerGL::TextureLoading != Texture::Deferred) return;
+
+    spdlog::info("Texture Prefetch:");
+
+    // Only textures of meshes inside the camera frustum (the shadow pass samples none)
+    Matrix4x4f viewProjectionMatrix =
+        GetProjectionMatrix(scene) * scene.GetCamera().GetViewMatrix();
+
+    std::unordered_set<const Texture*> textures;
+    for (int i = 0; i < scene.GetModelCount(); ++i)
+    {
+        scene.GetModel(i).CollectVisibleTextures(
+            viewProjectionMatrix * scene.GetModelMatrix(i), textures);
+    }
+
+    {
+        ThreadPool pool;
+        for (const Texture* texture : textures)
+        {
+            pool.Enqueue([texture]() { texture->Prefetch(); });
+        }
+    }  // join
+
+    spdlog::info("  [Decoded] {} textures", textures.size());
+    TimeElapsed(stepStopwatch, "Texture Prefetch");
+}
+
+void UpdateVirtualTextures(const Scene& scene)
+{
+    if (ForkerGL::TextureLoading != Texture::Virtual) return;
+
+    spdlog::info("Texture Feedback:");
+    ForkerGL::InitFeedbackBuffer(GetWidth(scene), GetHeight(scene));
+    ForkerGL::InitDepthBuffer(GetWidth(scene), GetHeight(scene));
+    ForkerGL::SetPassType(ForkerGL::FeedbackPass);
+
+    FeedbackShader feedbackShader;
+    feedbackShader.uViewProjectionMatrix =
+        GetProjectionMatrix(scene) * scene.GetCamera().GetViewMatrix();
+    for (int i = 0; i < scene.GetModelCount(); ++i)
+    {
+        feedbackShader.uModelMatrix = scene.GetModelMatrix(i);
+        scene.GetModel(i).Render(feedbackShader);
+    }
+
+    // Pages read by the visible pixels
+    feedbackShader.Resolve(ForkerGL::FeedbackBuffer);
+    VirtualTexture::Update();
+    TimeElapsed(stepStopwatch, "Texture Feedback");
 }
 
 void Render(const Scene& scene)
@@ -102,17 +170,12 @@ void DoForwardPass(const Scene& scene)
     ForkerGL::InitDepthBuffer(GetWidth(scene), GetHeight(scene));
     ForkerGL::ClearColor(Color3(0.12f, 0.12f, 0.12f));
     ForkerGL::SetPassType(ForkerGL::ForwardPass);
+    ForkerGL::InitShadingAtlas(ForkerGL::TexelShadingDensity);
 
-    Float             ratio = scene.GetRatio();
     const Matrix4x4f& viewMatrix = scene.GetCamera().GetViewMatrix();
-    const Matrix4x4f& projectionMatrix =
-        (scene.GetProjectionType() == Camera::Orthographic)
-            ? scene.GetCamera().GetOrthographicMatrix(-1.f * ratio, 1.f * ratio, -1.f,
-                                                      1.f, s_CameraNearPlane,
-                                                      s_CameraFarPlane)
-            : scene.GetCamera().GetPerspectiveMatrix(45.f, ratio, s_CameraNearPlane,
-                                                     s_CameraFarPlane);
+    const Matrix4x4f& projectionMatrix = GetProjectionMatrix(scene);
     ForkerGL::SetViewProjectionMatrix(projectionMatrix * viewMatrix);
+    CullLocalLights(scene);
 
     for (int i = 0; i < scene.GetModelCount(); ++i)
     {
@@ -153,6 +216,15 @@ void DoForwardPass(const Scene& scene)
             model.Render(pbrShader);
         }
     }
+
+    if (ForkerGL::ShadingAtlas.IsEnabled())
+    {
+        spdlog::info("  [Texel Shading] {} texels shaded for {} samples (density {})",
+                     ForkerGL::ShadingAtlas.GetNumShaded(),
+                     ForkerGL::ShadingAtlas.GetNumSamples(),
+                     ForkerGL::ShadingAtlas.GetDensity());
+        ForkerGL::InitShadingAtlas(0);  // releases the texels
+    }
     TimeElapsed(stepStopwatch, "Forward Pass");
 }
 
@@ -162,15 +234,8 @@ void DoGeometryPass(const Scene& scene)
     ForkerGL::InitDepthBuffer(GetWidth(scene), GetHeight(scene));
     ForkerGL::SetPassType(ForkerGL::GeometryPass);
 
-    Float             ratio = scene.GetRatio();
     const Matrix4x4f& viewMatrix = scene.GetCamera().GetViewMatrix();
-    const Matrix4x4f& projectionMatrix =
-        (scene.GetProjectionType() == Camera::Orthographic)
-            ? scene.GetCamera().GetOrthographicMatrix(-1.f * ratio, 1.f * ratio, -1.f,
-                                                      1.f, s_CameraNearPlane,
-                                                      s_CameraFarPlane)
-            : scene.GetCamera().GetPerspectiveMatrix(45.f, ratio, s_CameraNearPlane,
-                                                     s_CameraFarPlane);
+    const Matrix4x4f& projectionMatrix = GetProjectionMatrix(scene);
     ForkerGL::SetViewProjectionMatrix(projectionMatrix *
                                       viewMatrix);  // used in lighting pass
 
@@ -189,6 +254,16 @@ void DoGeometryPass(const Scene& scene)
         // Render
         model.Render(geometryShader);
     }
+
+    // Tiles for the screen space passes (SSAO, Lighting Pass)
+    ForkerGL::ClassifyTiles();
+    int numTiles[4] = { 0, 0, 0, 0 };
+    for (ForkerGL::TileType type : ForkerGL::TileTypes)
+        ++numTiles[type];
+    spdlog::info("  [Tiles] {} empty, {} Phong, {} PBR, {} mixed ({}x{} pixels)",
+                 numTiles[ForkerGL::EmptyTile], numTiles[ForkerGL::PhongTile],
+                 numTiles[ForkerGL::PBRTile], numTiles[ForkerGL::MixedTile],
+                 ForkerGL::TileSize, ForkerGL::TileSize);
     TimeElapsed(stepStopwatch, "Geometry Pass");
 }
 
@@ -198,7 +273,7 @@ void DoLightingPass(const Scene& scene)
 
     ForkerGL::InitFrameBuffer(GetWidth(scene), GetHeight(scene));
     ForkerGL::SetPassType(ForkerGL::LightingPass);
-    ForkerGL::ClearColor(Color3(0.12f, 0.12f, 0.12f));  // this does not work
+    ForkerGL::ClearColor(Color3(0.12f, 0.12f, 0.12f));  // background (empty pixels)
 
     // SSAO Effect
     if (scene.IsSSAOOn())
@@ -206,11 +281,27 @@ void DoLightingPass(const Scene& scene)
         DoSSAO(scene);
     }
 
+    CullLocalLights(scene);
     ForkerGL::DrawScreenSpacePixels(scene);
 
     TimeElapsed(stepStopwatch, "Lighting Pass");
 }
 
+void CullLocalLights(const Scene& scene)
+{
+    ForkerGL::LightClusters.Build(scene.GetLocalLights(), scene.GetCamera().GetViewMatrix(),
+                                  GetProjectionMatrix(scene), ForkerGL::GetViewportMatrix(),
+                                  s_CameraNearPlane, s_CameraFarPlane, GetWidth(scene),
+                                  GetHeight(scene));
+    if (ForkerGL::LightClusters.IsEmpty()) return;
+
+    const LightGrid& grid = ForkerGL::LightClusters;
+    spdlog::info("Light Culling:");
+    spdlog::info("  [Clusters] {} local lights, {} entries in {} clusters (max {})",
+                 grid.GetNumLights(), grid.GetNumEntries(), grid.GetNumClusters(),
+                 grid.GetMaxClusterLights());
+}
+
 void DoSSAO(const Scene& scene)
 {
     spdlog::info("* Applying SSAO in deferred shading...");
@@ -226,62 +317,74 @@ void DoSSAO(const Scene& scene)
     int screenWidth = ForkerGL::FrameBuffer.GetWidth();
     int screenHeight = ForkerGL::FrameBuffer.GetHeight();
 
+    // Background pixels (empty tiles, uncovered pixels of mixed ones) stay unoccluded
     for (int y = 0; y < screenHeight; ++y)
     {
-        for (int x = 0; x < screenWidth; ++x)
+        for (int tileX = 0; tileX < ForkerGL::NumTilesX; ++tileX)
         {
-            Point3f  positionWS = ForkerGL::WorldPosGBuffer.GetValue(x, y);
-            Vector3f normalWS = ForkerGL::NormalGBuffer.GetValue(x, y);
-            Float    fragDepth = ForkerGL::DepthBuffer.GetValue(x, y);
+            ForkerGL::TileType type =
+                ForkerGL::GetTileType(tileX, y / ForkerGL::TileSize);
+            if (type == ForkerGL::EmptyTile) continue;
 
-            Float occlusion = 0.f;
-            for (int s = 0; s < numSample; ++s)
+            int xMax = Min(screenWidth, (tileX + 1) * ForkerGL::TileSize);
+            for (int x = tileX * ForkerGL::TileSize; x < xMax; ++x)
             {
-                Vector3f sampledDirection = RandomVectorInHemisphere(normalWS);
-                Float    scale = sampledDirection.Length();
-                scale = Lerp(0.1f, 1.0f, scale * scale);
-                sampledDirection *= scale;
-
-                Point3f sampledPositionWS = positionWS + sampledDirection * radius;
-                Point4f sampledPositionCS = ForkerGL::GetViewProjectionMatrix() *
-                                            Vector4f(sampledPositionWS, 1.f);
-                Point4f sampledPositionNDC = sampledPositionCS / sampledPositionCS.w;
-                Point3f sampledPositionSS =
-                    (ForkerGL::GetViewportMatrix() * sampledPositionNDC).xyz;
-
-                Point2i sampledScreenPosition =
-                    Point2i(sampledPositionSS.x, sampledPositionSS.y);
-                Float sampledDepth = sampledPositionSS.z;
-                Float cachedDepth = ForkerGL::DepthBuffer.GetValue(
-                    sampledScreenPosition.x, sampledScreenPosition.y);
-
-                const Float bias = 0.0005f;
-
-                if (sampledDepth >= cachedDepth + bias)
+                if (type == ForkerGL::MixedTile && !ForkerGL::IsCovered(x, y)) continue;
+
+                Point3f  positionWS = ForkerGL::WorldPosGBuffer.GetValue(x, y);
+                Vector3f normalWS = ForkerGL::NormalGBuffer.GetValue(x, y);
+                Float    fragDepth = ForkerGL::DepthBuffer.GetValue(x, y);
+
+                Float occlusion = 0.f;
+                for (int s = 0; s < numSample; ++s)
                 {
-                    if (rangeCheckEnabled)
-                    {
-                        Float rangeCheck =
-                            std::abs(fragDepth - cachedDepth) < rangeCheckRadius ? 1.f
-                                                                                 : 0.f;
-                        // Another way
-                        // Float rangeCheck = Smoothstep(
-                        //     0.f, 1.f, rangeCheckRadius / std::abs(cachedDepth -
-                        //     fragDepth));
-                        occlusion += kernelScale * rangeCheck;
-                    }
-                    else
+                    Vector3f sampledDirection = RandomVectorInHemisphere(normalWS);
+                    Float    scale = sampledDirection.Length();
+                    scale = Lerp(0.1f, 1.0f, scale * scale);
+                    sampledDirection *= scale;
+
+                    Point3f sampledPositionWS = positionWS + sampledDirection * radius;
+                    Point4f sampledPositionCS = ForkerGL::GetViewProjectionMatrix() *
+                                                Vector4f(sampledPositionWS, 1.f);
+                    Point4f sampledPositionNDC = sampledPositionCS / sampledPositionCS.w;
+                    Point3f sampledPositionSS =
+                        (ForkerGL::GetViewportMatrix() * sampledPositionNDC).xyz;
+
+                    Point2i sampledScreenPosition =
+                        Point2i(sampledPositionSS.x, sampledPositionSS.y);
+                    Float sampledDepth = sampledPositionSS.z;
+                    Float cachedDepth = ForkerGL::DepthBuffer.GetValue(
+                        sampledScreenPosition.x, sampledScreenPosition.y);
+
+                    const Float bias = 0.0005f;
+
+                    if (sampledDepth >= cachedDepth + bias)
                     {
-                        occlusion += kernelScale;
+                        if (rangeCheckEnabled)
+                        {
+                            Float rangeCheck =
+                                std::abs(fragDepth - cachedDepth) < rangeCheckRadius
+                                    ? 1.f
+                                    : 0.f;
+                            // Another way
+                            // Float rangeCheck = Smoothstep(
+                            //     0.f, 1.f, rangeCheckRadius / std::abs(cachedDepth -
+                            //     fragDepth));
+                            occlusion += kernelScale * rangeCheck;
+                        }
+                        else
+                        {
+                            occlusion += kernelScale;
+                        }
                     }
                 }
-            }
 
-            occlusion = 1.f - occlusion;
+                occlusion = 1.f - occlusion;
 
-            occlusion = Pow(occlusion, 3);
+                occlusion = Pow(occlusion, 3);
 
-            ForkerGL::AmbientOcclusionGBuffer.SetValue(x, y, occlusion);
+                ForkerGL::AmbientOcclusionGBuffer.SetValue(x, y, occlusion);
+            }
         }
     }
 
@@ -6,6 +6,7 @@
 
 #include "camera.h"
 #include "depthshader.h"
+#include "feedbackshader.h"
 #include "forkergl.h"
 #include "geometry.h"
 #include "gshader.h"
@@ -15,12 +16,19 @@
 #include "phongshader.h"
 #include "scene.h"
 #include "shadow.h"
+#include "virtualtexture.h"
 
 namespace Render
 {
 // Configure
 void Preconfigure(const Scene& scene);
 
+// Decode deferred textures that visible meshes will sample
+void PrefetchTextures(const Scene& scene);
+
+// Feedback pass, then load the virtual texture pages that visible pixels will sample
+void UpdateVirtualTextures(const Scene& scene);
+
 // Render
 void Render(const Scene& scene);
 
@@ -30,6 +38,9 @@ void DoForwardPass(const Scene& scene);
 void DoGeometryPass(const Scene& scene);
 void DoLightingPass(const Scene& scene);
 
+// Light Culling (local lights of the camera view)
+void CullLocalLights(const Scene& scene);
+
 // SSAO
 void DoSSAO(const Scene& scene);
 
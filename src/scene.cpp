@@ -6,37 +6,84 @@
 
 #include <spdlog/spdlog.h>
 
+#include "assetio.h"
 #include "color.h"
 #include "forkergl.h"
 #include "light.h"
 #include "model.h"
+#include "packarchive.h"
 #include "shadow.h"
+#include "threadpool.h"
 #include "utility.h"
+#include "virtualtexture.h"
 
 const static int s_DefaultWidth = 1280;
 const static int s_DefaultHeight = 800;
 
+static const char* getFilterName(Texture::FilterMode filter)
+{
+    switch (filter)
+    {
+        case Texture::Linear: return "linear";
+        case Texture::NearestMipmap: return "nearestmip";
+        case Texture::Trilinear: return "trilinear";
+        default: return "nearest";
+    }
+}
+
+static const char* getLoadName(Texture::LoadMode mode)
+{
+    switch (mode)
+    {
+        case Texture::Eager: return "eager";
+        case Texture::Virtual: return "virtual";
+        default: return "deferred";
+    }
+}
+
 Scene::Scene(const std::string& filename)
-    : m_Width(s_DefaultWidth),
+    : m_Filename(filename),
+      m_Width(s_DefaultWidth),
       m_Height(s_DefaultHeight),
       m_SSAA(false),
       m_SSAO(false),
       m_SSAAKernelSize(2),
       m_PointLight(nullptr),
       m_DirLight(nullptr),
+      m_LocalLights(),
       m_Camera(nullptr),
       m_Models(),
-      m_ModelMatrices()
+      m_ModelMatrices(),
+      m_ModelSources()
 {
-    // Load Scene File
-    std::ifstream in;
-    in.open(filename, std::ifstream::in);
+    // Models and their textures are decoded concurrently
+    ThreadPool                                       loaderPool;
+    std::vector<std::future<std::unique_ptr<Model>>> modelFutures;
+    std::vector<Matrix4x4f>                          modelMatrices;
+    std::vector<ModelSource>                         modelSources;
+
+    // A pack archive holds the scene file and everything it loads
+    std::string sceneFilename = filename;
+    if (GetExtension(filename) == ".fpk")
+    {
+        if (!PackArchive::Mount(filename, loaderPool)) assert(false);
+        sceneFilename = PackArchive::GetSceneFilename();
+    }
+    bool packed = PackArchive::IsMounted() || PackArchive::IsRecording();
 
-    if (in.fail())
+    // Load Scene File
+    std::string text;
+    if (!AssetIO::ReadText(sceneFilename, text))
     {
         spdlog::error("Failed to open the .scene file");
         assert(false);
     }
+    if (PackArchive::IsRecording())
+    {
+        PackArchive::Record(sceneFilename,
+                            std::vector<std::uint8_t>(text.begin(), text.end()));
+    }
+    std::istringstream in(text);
 
     spdlog::info("Scene File: \'{}\'", filename);
 
@@ -97,6 +144,58 @@ Scene::Scene(const std::string& filename)
             iss >> strTrash >> status;
             Shadow::SetShadowStatus(status == "on");
         }
+        else if (line.compare(0, 8, "texture ") == 0)  // Texture Loading
+        {
+            std::string mode, option;
+            iss >> strTrash >> mode >> option;
+            if (mode == "virtual")
+            {
+                // Pages are read from the cache files, option is the budget in MB
+                Float       budgetMB = option.empty() ? 256.f : std::atof(option.c_str());
+                std::size_t budget = (std::size_t)(Max(budgetMB, 0.f) * 1024 * 1024);
+                ForkerGL::TextureLoadMode(Texture::Virtual);
+                ForkerGL::TextureCacheMode(true);
+                VirtualTexture::SetBudget(budget);
+            }
+            else
+            {
+                ForkerGL::TextureLoadMode(mode == "eager" ? Texture::Eager
+                                                          : Texture::Deferred);
+                ForkerGL::TextureCacheMode(option == "cache");
+            }
+        }
+        else if (line.compare(0, 9, "compress ") == 0)  // Texture Compression
+        {
+            std::string status;
+            iss >> strTrash >> status;
+            ForkerGL::TextureCompressMode(status == "on");
+        }
+        else if (line.compare(0, 7, "filter ") == 0)  // Texture Filtering
+        {
+            std::string mode;
+            iss >> strTrash >> mode;
+            if (mode == "linear")
+                ForkerGL::TextureFilterMode(Texture::Linear);
+            else if (mode == "nearestmip")
+                ForkerGL::TextureFilterMode(Texture::NearestMipmap);
+            else if (mode == "trilinear")
+                ForkerGL::TextureFilterMode(Texture::Trilinear);
+            else  // Nearest as default
+                ForkerGL::TextureFilterMode(Texture::Nearest);
+        }
+        else if (line.compare(0, 8, "shading ") == 0)  // Texture-Space Shading
+        {
+            std::string mode;
+            int         density = 0;
+            iss >> strTrash >> mode >> density;
+            ForkerGL::TexelShadingMode(mode == "texel" ? density : 0);
+        }
+        else if (line.compare(0, 7, "assets ") == 0)  // Asset Sharing
+        {
+            std::string mode;
+            iss >> strTrash >> mode;
+            ForkerGL::SharedAssetMode(mode == "shared");
+        }
         else if (line.compare(0, 6, "light ") == 0)  // Light
         {
             std::string lightType;
@@ -117,6 +216,51 @@ Scene::Scene(const std::string& filename)
                                  m_PointLight->position, m_PointLight->color);
                 }
             }
+            else if (lightType == "local")
+            {
+                Point3f position;
+                iss >> position.x >> position.y >> position.z;
+
+                Color3 color;
+                iss >> color.x >> color.y >> color.z;
+
+                Float radius = 1.f;
+                iss >> radius;
+
+                m_LocalLights.emplace_back(position, color, Max(radius, 0.001f));
+
+                spdlog::info("  [Local Light] position: {}, color: {}, radius: {}",
+                             position, color, radius);
+            }
+            else if (lightType == "scatter")
+            {
+                int   count = 0;
+                Float radius = 1.f, intensity = 1.f;
+                iss >> count >> radius >> intensity;
+
+                Point3f minPos, maxPos;
+                iss >> minPos.x >> minPos.y >> minPos.z;
+                iss >> maxPos.x >> maxPos.y >> maxPos.z;
+
+                // Own generator: the same lights each run, other random users unaffected
+                std::mt19937                          generator(1234u);
+                std::uniform_real_distribution<Float> random01(0.f, 1.f);
+                for (int i = 0; i < count; ++i)
+                {
+                    Vector3f t, color;  // in drawing order
+                    t.x = random01(generator);
+                    t.y = random01(generator);
+                    t.z = random01(generator);
+                    color.x = random01(generator);
+                    color.y = random01(generator);
+                    color.z = random01(generator);
+                    m_LocalLights.emplace_back(minPos + (maxPos - minPos) * t,
+                                               color * intensity, Max(radius, 0.001f));
+                }
+
+                spdlog::info("  [Local Lights] {} scattered in {} - {}, radius: {}", count,
+                             minPos, maxPos, radius);
+            }
             else if (lightType == "dir")
             {
                 Vector3f direction;
@@ -184,13 +328,131 @@ Scene::Scene(const std::string& filename)
             iss >> position.x >> position.y >> position.z;
             iss >> rotateY >> uniformScale;
 
-            std::unique_ptr<Model> m =
-                Model::Load(filename, normalized, generateTangent);  // Copy Elision
+            // Optional: 'stream <MB>' keeps faces on disk and draws them in batches
+            std::string streamOption;
+            Float       streamBudgetMB = 0.f;
+            iss >> streamOption >> streamBudgetMB;
+            std::size_t streamBudget =
+                (streamOption == "stream" && streamBudgetMB > 0.f)
+                    ? (std::size_t)(streamBudgetMB * 1024 * 1024)
+                    : 0;
+            if (streamBudget > 0 && packed)
+            {
+                spdlog::info("  [Pack] \'{}\' is loaded in memory, not streamed",
+                             filename);
+                streamBudget = 0;
+            }
+
+            // Read while the scene file is still being parsed (a .glb is mapped). Not
+            // when the meshes may come from elsewhere, a queued read is taken only once.
+            if (streamBudget == 0 && GetExtension(filename) == ".obj" &&
+                !PackArchive::IsMounted() && !ForkerGL::SharedAssets)
+            {
+                AssetIO::Prefetch(filename);
+            }
 
-            m_Models.push_back(std::move(m));
-            m_ModelMatrices.push_back(MakeModelMatrix(position, rotateY, uniformScale));
+            ModelSource source = { filename, normalized, generateTangent, streamBudget };
+            ThreadPool* pool = &loaderPool;
+            modelFutures.push_back(
+                loaderPool.Enqueue([source, pool]() { return loadModel(source, pool); }));
+            modelMatrices.push_back(MakeModelMatrix(position, rotateY, uniformScale));
+            modelSources.push_back(source);
         }
     }
-    spdlog::info("  [Config] SSAA(x{})[{}] shadow[{}] SSAO[{}]", m_SSAAKernelSize,
-                 m_SSAA ? "on" : "off", Shadow::GetShadowStatus() ? "on" : "off" , m_SSAO ? "on" : "off");
+
+    // Join Point (in scene order)
+    for (size_t i = 0; i < modelFutures.size(); ++i)
+    {
+        std::unique_ptr<Model> m = modelFutures[i].get();
+        if (m == nullptr) continue;
+
+        m->FinishLoading();
+        m_Models.push_back(std::move(m));
+        m_ModelMatrices.push_back(modelMatrices[i]);
+        m_ModelSources.push_back(modelSources[i]);
+    }
+    PackArchive::Unmount();  // models keep the entries they use
+    spdlog::info("  [Loader] {} threads, I/O[{}]", loaderPool.GetNumThreads(),
+                 AssetIO::GetBackendName());
+    spdlog::info(
+        "  [Config] SSAA(x{})[{}] shadow[{}] SSAO[{}] texture[{}] filter[{}] cache[{}] "
+        "compress[{}] shading[{}] assets[{}]",
+        m_SSAAKernelSize, m_SSAA ? "on" : "off", Shadow::GetShadowStatus() ? "on" : "off",
+        m_SSAO ? "on" : "off",
+        getLoadName(ForkerGL::TextureLoading),
+        getFilterName(ForkerGL::TextureFiltering),
+        ForkerGL::TextureCaching ? "on" : "off",
+        ForkerGL::TextureCompression ? "on" : "off",
+        ForkerGL::TexelShadingDensity > 0
+            ? "texel " + std::to_string(ForkerGL::TexelShadingDensity)
+            : std::string("pixel"),
+        ForkerGL::SharedAssets ? "shared" : "private");
+}
+
+std::unique_ptr<Model> Scene::loadModel(const ModelSource& source, ThreadPool* pool)
+{
+    if (source.streamBudget > 0)
+    {
+        return Model::LoadStreaming(source.filename, source.normalized,
+                                    source.generateTangent, true, source.streamBudget,
+                                    pool);
+    }
+    return Model::Load(source.filename, source.normalized, source.generateTangent, true,
+                       pool);
+}
+
+void Scene::GetSourceFiles(std::vector<std::string>& files) const
+{
+    std::set<std::string> sources = { m_Filename };
+    for (const std::unique_ptr<Model>& model : m_Models)
+    {
+        sources.insert(model->GetSourceFiles().begin(), model->GetSourceFiles().end());
+    }
+    files.assign(sources.begin(), sources.end());
+}
+
+void Scene::Reload(const std::vector<std::string>& changedFiles)
+{
+    ThreadPool                                       loaderPool;
+    std::vector<std::future<std::unique_ptr<Model>>> modelFutures;
+    std::vector<std::size_t>                         modelIndices;
+
+    for (std::size_t i = 0; i < m_Models.size(); ++i)
+    {
+        const ModelSource&           source = m_ModelSources[i];
+        const std::set<std::string>& sources = m_Models[i]->GetSourceFiles();
+
+        // Textures are replaced in place, any other file reloads the whole model
+        bool reloadModel = false;
+        for (const std::string& filename : changedFiles)
+        {
+            if (sources.count(filename) == 0) continue;
+            if (m_Models[i]->ReloadTexture(filename))
+            {
+                spdlog::info("  [Reload] texture \'{}\' of \'{}\'", filename,
+                             source.filename);
+            }
+            else
+            {
+                reloadModel = true;
+            }
+        }
+        if (!reloadModel) continue;
+
+        spdlog::info("  [Reload] model \'{}\'", source.filename);
+        ThreadPool* pool = &loaderPool;
+        modelFutures.push_back(
+            loaderPool.Enqueue([source, pool]() { return loadModel(source, pool); }));
+        modelIndices.push_back(i);
+    }
+
+    // A model that fails to load keeps its previous version
+    for (size_t i = 0; i < modelFutures.size(); ++i)
+    {
+        std::unique_ptr<Model> m = modelFutures[i].get();
+        if (m == nullptr) continue;
+
+        m->FinishLoading();
+        m_Models[modelIndices[i]] = std::move(m);
+    }
 }
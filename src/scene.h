@@ -6,9 +6,11 @@
 
 #include <camera.h>
 
-class PointLight;
+#include "light.h"
+
 class DirLight;
 class Model;
+class ThreadPool;
 
 class Scene
 {
@@ -34,6 +36,9 @@ public:
         return *m_PointLight;
     }
 
+    // Local lights ('light local', 'light scatter'), culled per view (LightGrid)
+    const std::vector<PointLight>& GetLocalLights() const { return m_LocalLights; }
+
     const DirLight& GetDirLight() const
     {
         assert(m_DirLight != nullptr);
@@ -57,7 +62,24 @@ public:
 
     Matrix4x4f GetModelMatrix(int index) const { return m_ModelMatrices[index]; }
 
+    // Watch Mode
+    // Files the scene was loaded from: the scene file, models, materials and textures
+    void GetSourceFiles(std::vector<std::string>& files) const;
+    // Reloads only what was loaded from the changed files (the scene file is not)
+    void Reload(const std::vector<std::string>& changedFiles);
+
 private:
+    struct ModelSource
+    {
+        std::string filename;
+        bool        normalized;
+        bool        generateTangent;
+        std::size_t streamBudget;  // 0 if loaded in memory
+    };
+
+    static std::unique_ptr<Model> loadModel(const ModelSource& source, ThreadPool* pool);
+
+    std::string                         m_Filename;
     int                                 m_Width;
     int                                 m_Height;
     bool                                m_SSAA;
@@ -65,8 +87,10 @@ private:
     bool                                m_SSAO;
     std::unique_ptr<PointLight>         m_PointLight;
     std::unique_ptr<DirLight>           m_DirLight;
+    std::vector<PointLight>             m_LocalLights;
     std::unique_ptr<Camera>             m_Camera;
     Camera::ProjectionType              m_ProjectionType;
     std::vector<std::unique_ptr<Model>> m_Models;
     std::vector<Matrix4x4f>             m_ModelMatrices;
+    std::vector<ModelSource>            m_ModelSources;
 };
@@ -0,0 +1,100 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#pragma once
+
+#include "shader.h"
+
+// Feedback Shader For Virtual Textures
+// Each fragment keeps its texture coordinate and LOD, the pixel stores the index of the
+// visible one in ForkerGL::FeedbackBuffer. Resolve() then requests the pages that the
+// textures of the visible fragments will read.
+struct FeedbackShader : public Shader
+{
+    struct Record
+    {
+        const std::vector<const Texture*>* textures;
+        Vector2f                           texCoord;
+        Float                              lod;
+    };
+
+    // Interpolation
+    Matrix2x3f vTexCoordCorrected;
+
+    // Transformations
+    Matrix4x4f uModelMatrix;
+    Matrix4x4f uViewProjectionMatrix;
+
+    // Fragments (index + 1 in the buffer) and the textures of each material
+    using MaterialKey = std::pair<const Material*, const PBRMaterial*>;
+    std::vector<Record>                                records;
+    std::map<MaterialKey, std::vector<const Texture*>> materialTextures;
+
+    FeedbackShader() : Shader(), m_Textures(nullptr) { }
+
+    // Textures of the mesh's materials (once per mesh)
+    void SelectVariant() override
+    {
+        MaterialKey key(mesh->GetMaterial().get(), mesh->GetPBRMaterial().get());
+        auto        iter = materialTextures.find(key);
+        if (iter == materialTextures.end())
+        {
+            std::unordered_set<const Texture*> textures;
+            mesh->CollectTextures(mesh->GetModel().SupportPBR(), textures);
+            iter = materialTextures
+                       .emplace(key, std::vector<const Texture*>(textures.begin(),
+                                                                 textures.end()))
+                       .first;
+        }
+        m_Textures = &iter->second;
+    }
+
+    Point4f ProcessVertex(int faceIdx, int vertIdx) override
+    {
+        Point4f positionWS = uModelMatrix * Point4f(mesh->Vert(faceIdx, vertIdx), 1.f);
+        Point4f positionCS = uViewProjectionMatrix * positionWS;
+
+        Vector2f texCoord = mesh->TexCoord(faceIdx, vertIdx);
+        v2fTexCoords.SetCol(vertIdx, texCoord);
+
+#ifdef PERSPECTIVE_CORRECT_INTERPOLATION
+        Float oneOverW = 1.f / positionCS.w;
+        v2fOneOverWs[vertIdx] = oneOverW;
+        texCoord *= oneOverW;
+#endif
+        vTexCoordCorrected.SetCol(vertIdx, texCoord);
+        return positionCS / positionCS.w;
+    }
+
+    bool ProcessFragment(const Vector3f& baryCoord, Color3& gl_Color) override
+    {
+        Vector2f texCoord = vTexCoordCorrected * baryCoord;
+#ifdef PERSPECTIVE_CORRECT_INTERPOLATION
+        texCoord *= 1.f / Dot(v2fOneOverWs, baryCoord);
+#endif
+
+        records.push_back(Record{ m_Textures, texCoord, v2fTexLod });
+        gl_Color.x = (Float)records.size();
+        return false;
+    }
+
+    void Resolve(const Buffer1f& buffer) const
+    {
+        for (int y = 0; y < buffer.GetHeight(); ++y)
+        {
+            for (int x = 0; x < buffer.GetWidth(); ++x)
+            {
+                int index = (int)buffer.GetValue(x, y);
+                if (index <= 0) continue;
+
+                const Record& record = records[index - 1];
+                for (const Texture* texture : *record.textures)
+                    texture->RecordFeedback(record.texCoord, record.lod);
+            }
+        }
+    }
+
+private:
+    const std::vector<const Texture*>* m_Textures;  // of the mesh being drawn
+};
@@ -16,8 +16,6 @@ struct GShader : public Shader
 
     // Vertex (out) -> Fragment (in)
     Matrix3x3f v2fPositionsWS;
-    Matrix2x3f v2fTexCoords;
-    Vector3f   v2fOneOverWs;
 
     // Uniform Variables
     Matrix4x4f uModelMatrix;
@@ -38,7 +36,26 @@ struct GShader : public Shader
     Vector3f outParam;        // Specular
     Float    outShadingType;  // PBR or Non-PBR
 
+    // Variant for the material features of the mesh (PBR or Blinn-Phong path)
+    void SelectVariant() override
+    {
+        bool pbr = mesh->GetModel().SupportPBR();
+        int  features = GetMaterialFeatures(*mesh, pbr);
+        m_VertexVariant = getVertexVariant(features);
+        m_FragmentVariant =
+            pbr ? getFragmentVariant<true>(
+                      features, std::make_integer_sequence<int, NumPBRVariants>())
+                : getFragmentVariant<false>(
+                      features, std::make_integer_sequence<int, NumPhongVariants>());
+    }
+
     Point4f ProcessVertex(int faceIdx, int vertIdx) override
+    {
+        return (this->*m_VertexVariant)(faceIdx, vertIdx);
+    }
+
+    template <int Features>
+    Point4f ProcessVertex(int faceIdx, int vertIdx)
     {
         // MVP
         Point4f positionWS = uModelMatrix * Point4f(mesh->Vert(faceIdx, vertIdx), 1.f);
@@ -49,7 +66,7 @@ struct GShader : public Shader
         Vector2f texCoord = mesh->TexCoord(faceIdx, vertIdx);
         Vector3f normalWS = uNormalMatrix * mesh->Normal(faceIdx, vertIdx);
         Vector3f tangentWS;
-        if (mesh->GetModel().HasTangents())
+        if (Features & NormalMapFeature)
         {
             tangentWS = uNormalMatrix * mesh->Tangent(faceIdx, vertIdx);
         }
@@ -59,7 +76,7 @@ struct GShader : public Shader
         v2fTexCoords.SetCol(vertIdx, texCoord);
 
         // Shadow Mapping
-        bool    isShadowOn = Shadow::GetShadowStatus();
+        bool    isShadowOn = Features & ShadowFeature;
         Point4f positionLightSpaceNDC;
         if (isShadowOn)
         {
@@ -74,7 +91,7 @@ struct GShader : public Shader
         positionWS *= oneOverW;
         texCoord *= oneOverW;
         normalWS *= oneOverW;
-        if (mesh->GetModel().HasTangents()) tangentWS *= oneOverW;
+        if (Features & NormalMapFeature) tangentWS *= oneOverW;
         if (isShadowOn) positionLightSpaceNDC *= oneOverW;
 #endif
 
@@ -82,8 +99,7 @@ struct GShader : public Shader
         vTexCoordCorrected.SetCol(vertIdx, texCoord);
         vPositionCorrectedWS.SetCol(vertIdx, positionWS.xyz);
         vNormalCorrectedWS.SetCol(vertIdx, normalWS);
-        if (mesh->GetModel().HasTangents())
-            vTangentCorrectedWS.SetCol(vertIdx, tangentWS);
+        if (Features & NormalMapFeature) vTangentCorrectedWS.SetCol(vertIdx, tangentWS);
         if (isShadowOn) vPositionLightSpaceNDC.SetCol(vertIdx, positionLightSpaceNDC.xyz);
 
         // Perspective Division
@@ -94,8 +110,12 @@ struct GShader : public Shader
 
     bool ProcessFragment(const Vector3f& baryCoord, Color3& gl_Color) override
     {
-        std::shared_ptr<const Material> material = mesh->GetMaterial();
+        return (this->*m_FragmentVariant)(baryCoord, gl_Color);
+    }
 
+    template <bool PBR, int Features>
+    bool ProcessFragment(const Vector3f& baryCoord, Color3& gl_Color)
+    {
         // Interpolation
         Point3f  positionWS = vPositionCorrectedWS * baryCoord;
         Vector2f texCoord = vTexCoordCorrected * baryCoord;
@@ -111,7 +131,7 @@ struct GShader : public Shader
         Vector3f N = Normalize(normalWS);  // World Space
         Vector3f normal;
 
-        if (mesh->GetModel().HasTangents() && material->HasNormalMap())
+        if (Features & NormalMapFeature)
         {
             Vector3f tangentWS = vTangentCorrectedWS * baryCoord;
 #ifdef PERSPECTIVE_CORRECT_INTERPOLATION
@@ -123,8 +143,8 @@ struct GShader : public Shader
             Vector3f   B = Normalize(Cross(N, T));
             Matrix3x3f TbnMatrix;
             TbnMatrix.SetCol(0, T).SetCol(1, B).SetCol(2, N);
-            Vector3f sampledNormal = material->normalMap->Sample(texCoord);
-            sampledNormal = Normalize(sampledNormal * 2.f - Vector3f(1.f));  // remap
+            Vector3f sampledNormal =
+                material.normalMap->SampleNormal(texCoord, v2fTexLod);  // [-1, 1]
             normal = Normalize(TbnMatrix * sampledNormal);  // World Space
         }
         else
@@ -133,7 +153,7 @@ struct GShader : public Shader
         }
 
         // Light Space NDC Info
-        if (Shadow::GetShadowStatus())
+        if (Features & ShadowFeature)
         {
             Point3f positionLightSpaceNDC = vPositionLightSpaceNDC * baryCoord;
 #ifdef PERSPECTIVE_CORRECT_INTERPOLATION
@@ -146,29 +166,28 @@ struct GShader : public Shader
         outNormalWS = normal;
         outPositionWS = positionWS;
 
-        if (mesh->GetModel().SupportPBR())
+        if (PBR)
         {
             // PBR Material
-            std::shared_ptr<const PBRMaterial> pbrMaterial = mesh->GetPBRMaterial();
-            std::shared_ptr<const Texture>     baseColorMap = pbrMaterial->baseColorMap;
-            std::shared_ptr<const Texture>     metalnessMap = pbrMaterial->metalnessMap;
-            std::shared_ptr<const Texture>     roughnessMap = pbrMaterial->roughnessMap;
-            std::shared_ptr<const Texture>     aoMap = pbrMaterial->ambientOcclusionMap;
-            std::shared_ptr<const Texture>     emissiveMap = pbrMaterial->emissiveMap;
-
-            Color3 albedo = pbrMaterial->HasBaseColorMap()
-                                ? baseColorMap->Sample(texCoord)
-                                : pbrMaterial->albedo;
-            Color3 emissive = pbrMaterial->HasEmssiveMap() ? emissiveMap->Sample(texCoord)
-                                                           : material->ke;
-            Float  roughness = pbrMaterial->HasRoughnessMap()
-                                   ? roughnessMap->SampleFloat(texCoord)
-                                   : pbrMaterial->roughness;
-            Float  metalness = pbrMaterial->HasMetalnessMap()
-                                   ? metalnessMap->SampleFloat(texCoord)
-                                   : pbrMaterial->metalness;
-            Float  ao = pbrMaterial->HasAmbientOcclusionMap()
-                            ? aoMap->SampleFloat(texCoord)
+            Color3 albedo = pbrMaterial.albedo;
+            if (Features & ColorMapFeature)
+                albedo = pbrMaterial.baseColorMap->SampleLinear(texCoord, v2fTexLod);
+            Color3 emissive = material.ke;
+            if (Features & EmissiveMapFeature)
+                emissive = pbrMaterial.emissiveMap->SampleLinear(texCoord, v2fTexLod);
+
+            // AO, roughness and metalness in one fetch
+            Color3 orm = (Features & OrmMapFeatures)
+                             ? pbrMaterial.ormMap->Sample(texCoord, v2fTexLod)
+                             : Color3(0.f);
+            Float  roughness = (Features & RoughnessMapFeature)
+                                   ? orm[pbrMaterial.roughnessChannel]
+                                   : pbrMaterial.roughness;
+            Float  metalness = (Features & MetalnessMapFeature)
+                                   ? orm[pbrMaterial.metalnessChannel]
+                                   : pbrMaterial.metalness;
+            Float  ao = (Features & AmbientOcclusionMapFeature)
+                            ? orm[pbrMaterial.aoChannel]
                             : 1.f;
 
             outAlbedo = albedo;
@@ -179,18 +198,18 @@ struct GShader : public Shader
         else
         {
             // Material
-            std::shared_ptr<const Material> material = mesh->GetMaterial();
-            std::shared_ptr<const Texture>  diffuseMap = material->diffuseMap;
-            std::shared_ptr<const Texture>  specularMap = material->specularMap;
-            std::shared_ptr<const Texture>  emissiveMap = material->emissiveMap;
-
-            Color3 emissive =
-                material->HasEmissiveMap() ? emissiveMap->Sample(texCoord) : material->ke;
-            Color3 diffuseColor =
-                material->HasDiffuseMap() ? diffuseMap->Sample(texCoord) : material->kd;
+            Color3 emissive = material.ke;
+            if (Features & EmissiveMapFeature)
+                emissive = material.emissiveMap->SampleLinear(texCoord, v2fTexLod);
+            Color3 diffuseColor = material.kd;
+            if (Features & ColorMapFeature)
+                diffuseColor = material.diffuseMap->SampleLinear(texCoord, v2fTexLod);
             Float ao = 1.f;
-            Float specular = material->ks.r;
-            Float shininess = material->HasSpecularMap() ? specularMap->SampleFloat(texCoord) + 5 : 1.f;
+            Float specular = material.ks.r;
+            Float shininess = 1.f;
+            if (Features & SpecularMapFeature)
+                shininess =
+                    material.specularMap->SampleFloat(texCoord, 2, v2fTexLod) + 5;
 
             outAlbedo = diffuseColor;
             outEmissive = emissive;
@@ -200,4 +219,31 @@ struct GShader : public Shader
 
         return false;  // do not discard
     }
+
+private:
+    using VertexVariant = Point4f (GShader::*)(int, int);
+    using FragmentVariant = bool (GShader::*)(const Vector3f&, Color3&);
+
+    VertexVariant   m_VertexVariant = nullptr;
+    FragmentVariant m_FragmentVariant = nullptr;
+
+    // Variants indexed by their features
+    static VertexVariant getVertexVariant(int features)
+    {
+        static const VertexVariant s_Variants[] = {
+            &GShader::ProcessVertex<0>, &GShader::ProcessVertex<1>,
+            &GShader::ProcessVertex<2>, &GShader::ProcessVertex<3>
+        };
+        return s_Variants[features & VertexFeatures];
+    }
+
+    template <bool PBR, int... Features>
+    static FragmentVariant getFragmentVariant(int features,
+                                              std::integer_sequence<int, Features...>)
+    {
+        static const FragmentVariant s_Variants[] = {
+            &GShader::ProcessFragment<PBR, Features>...
+        };
+        return s_Variants[features];
+    }
 };
\ No newline at end of file
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "packet.h"
 #include "shader.h"
 
 struct PBRShader : public Shader
@@ -16,8 +17,6 @@ struct PBRShader : public Shader
 
     // Vertex (out) -> Fragment (in)
     Matrix3x3f v2fPositionsWS;
-    Matrix2x3f v2fTexCoords;
-    Vector3f   v2fOneOverWs;
 
     // Uniform Variables
     Matrix4x4f uModelMatrix;
@@ -31,8 +30,23 @@ struct PBRShader : public Shader
     Matrix4x4f uLightSpaceMatrix;
     Matrix3x3f vPositionLightSpaceNDC;
 
+    // Variant for the material features of the mesh
+    void SelectVariant() override
+    {
+        int features = GetMaterialFeatures(*mesh, true);
+        m_VertexVariant = getVertexVariant(features);
+        m_FragmentVariant = getFragmentVariant(
+            features, std::make_integer_sequence<int, NumPBRVariants>());
+    }
+
     // Vertex Shader
     Point4f ProcessVertex(int faceIdx, int vertIdx) override
+    {
+        return (this->*m_VertexVariant)(faceIdx, vertIdx);
+    }
+
+    template <int Features>
+    Point4f ProcessVertex(int faceIdx, int vertIdx)
     {
         // MVP
         Point4f positionWS = uModelMatrix * Point4f(mesh->Vert(faceIdx, vertIdx), 1.f);
@@ -43,7 +57,7 @@ struct PBRShader : public Shader
         Vector2f texCoord = mesh->TexCoord(faceIdx, vertIdx);
         Vector3f normalWS = uNormalMatrix * mesh->Normal(faceIdx, vertIdx);
         Vector3f tangentWS;
-        if (mesh->GetModel().HasTangents())
+        if (Features & NormalMapFeature)
         {
             tangentWS = uNormalMatrix * mesh->Tangent(faceIdx, vertIdx);
         }
@@ -53,7 +67,7 @@ struct PBRShader : public Shader
         v2fTexCoords.SetCol(vertIdx, texCoord);
 
         // Shadow Mapping
-        bool    isShadowOn = Shadow::GetShadowStatus();
+        bool    isShadowOn = Features & ShadowFeature;
         Point4f positionLightSpaceNDC;
         if (isShadowOn)
         {
@@ -68,15 +82,14 @@ struct PBRShader : public Shader
         positionWS *= oneOverW;
         texCoord *= oneOverW;
         normalWS *= oneOverW;
-        if (mesh->GetModel().HasTangents()) tangentWS *= oneOverW;
+        if (Features & NormalMapFeature) tangentWS *= oneOverW;
         if (isShadowOn) positionLightSpaceNDC *= oneOverW;
 #endif
         // Varying
         vTexCoordCorrected.SetCol(vertIdx, texCoord);
         vPositionCorrectedWS.SetCol(vertIdx, positionWS.xyz);
         vNormalCorrectedWS.SetCol(vertIdx, normalWS);
-        if (mesh->GetModel().HasTangents())
-            vTangentCorrectedWS.SetCol(vertIdx, tangentWS);
+        if (Features & NormalMapFeature) vTangentCorrectedWS.SetCol(vertIdx, tangentWS);
         if (isShadowOn) vPositionLightSpaceNDC.SetCol(vertIdx, positionLightSpaceNDC.xyz);
 
         // Perspective Division
@@ -89,8 +102,12 @@ struct PBRShader : public Shader
     // Fragment Shader
     bool ProcessFragment(const Vector3f& baryCoord, Color3& gl_Color) override
     {
-        std::shared_ptr<const PBRMaterial> pbrMaterial = mesh->GetPBRMaterial();
+        return (this->*m_FragmentVariant)(baryCoord, gl_Color);
+    }
 
+    template <int Features>
+    bool ProcessFragment(const Vector3f& baryCoord, Color3& gl_Color)
+    {
         // Interpolation
         Point3f  positionWS = vPositionCorrectedWS * baryCoord;
         Vector2f texCoord = vTexCoordCorrected * baryCoord;
@@ -107,7 +124,7 @@ struct PBRShader : public Shader
         Vector3f N = Normalize(normalWS);  // World Space
         Vector3f normal;
 
-        if (mesh->GetModel().HasTangents() && pbrMaterial->HasNormalMap())
+        if (Features & NormalMapFeature)
         {
             Vector3f tangentWS = vTangentCorrectedWS * baryCoord;
 #ifdef PERSPECTIVE_CORRECT_INTERPOLATION
@@ -119,8 +136,8 @@ struct PBRShader : public Shader
             Vector3f   B = Normalize(Cross(N, T));
             Matrix3x3f TbnMatrix;
             TbnMatrix.SetCol(0, T).SetCol(1, B).SetCol(2, N);
-            Vector3f sampledNormal = pbrMaterial->normalMap->Sample(texCoord);
-            sampledNormal = Normalize(sampledNormal * 2.f - Vector3f(1.f));  // remap
+            Vector3f sampledNormal =
+                pbrMaterial.normalMap->SampleNormal(texCoord, v2fTexLod);  // [-1, 1]
             normal = Normalize(TbnMatrix * sampledNormal);
         }
         else
@@ -140,7 +157,7 @@ struct PBRShader : public Shader
 
         // Shadow Mapping
         Float visibility = 0.f;
-        if (Shadow::GetShadowStatus())
+        if (Features & ShadowFeature)
         {
             Point3f positionLightSpaceNDC = vPositionLightSpaceNDC * baryCoord;
 #ifdef PERSPECTIVE_CORRECT_INTERPOLATION
@@ -152,99 +169,78 @@ struct PBRShader : public Shader
 
         // Physically-Based Shading
         // Texture Sampling
-        std::shared_ptr<const Texture> baseColorMap = pbrMaterial->baseColorMap;
-        std::shared_ptr<const Texture> metalnessMap = pbrMaterial->metalnessMap;
-        std::shared_ptr<const Texture> roughnessMap = pbrMaterial->roughnessMap;
-        std::shared_ptr<const Texture> aoMap = pbrMaterial->ambientOcclusionMap;
-        std::shared_ptr<const Texture> emissiveMap = pbrMaterial->emissiveMap;
-
-        Color3 albedo = pbrMaterial->HasBaseColorMap() ? baseColorMap->Sample(texCoord)
-                                                       : pbrMaterial->albedo;
-        Color3 emissive = pbrMaterial->HasEmssiveMap() ? emissiveMap->Sample(texCoord)
-                                                       : pbrMaterial->ke;
-
-        Float roughness = pbrMaterial->HasRoughnessMap()
-                              ? roughnessMap->SampleFloat(texCoord)
-                              : pbrMaterial->roughness;
-        Float metalness = pbrMaterial->HasMetalnessMap()
-                              ? metalnessMap->SampleFloat(texCoord)
-                              : pbrMaterial->metalness;
-        Float ao =
-            pbrMaterial->HasAmbientOcclusionMap() ? aoMap->SampleFloat(texCoord) : 1.f;
+        Color3 albedo = pbrMaterial.albedo;
+        if (Features & ColorMapFeature)
+            albedo = pbrMaterial.baseColorMap->SampleLinear(texCoord, v2fTexLod);
+        Color3 emissive = pbrMaterial.ke;
+        if (Features & EmissiveMapFeature)
+            emissive = pbrMaterial.emissiveMap->SampleLinear(texCoord, v2fTexLod);
+
+        // AO, roughness and metalness in one fetch
+        Color3 orm = (Features & OrmMapFeatures)
+                         ? pbrMaterial.ormMap->Sample(texCoord, v2fTexLod)
+                         : Color3(0.f);
+        Float  roughness = (Features & RoughnessMapFeature)
+                               ? orm[pbrMaterial.roughnessChannel]
+                               : pbrMaterial.roughness;
+        Float  metalness = (Features & MetalnessMapFeature)
+                               ? orm[pbrMaterial.metalnessChannel]
+                               : pbrMaterial.metalness;
+        Float  ao =
+            (Features & AmbientOcclusionMapFeature) ? orm[pbrMaterial.aoChannel] : 1.f;
         Vector3f param(ao, metalness, roughness);
 
+        // Local Lights (of the light cluster of the fragment)
+        Color3 localLight(0.f);
+        if (!ForkerGL::LightClusters.IsEmpty())
+        {
+            LightGrid::LightList lights = ForkerGL::LightClusters.GetLights(positionWS);
+            localLight = CalculateLocalLights<Float>(lights, positionWS, viewDir, normal,
+                                                     albedo, param);
+        }
+
         gl_Color = CalculateLight(lightDir, viewDir, halfwayDir, normal, visibility,
-                                  albedo, emissive, param, uPointLight.color);
+                                  albedo, emissive, param, uPointLight.color, localLight);
 
         return false;  // do not discard
     }
 
-    static Color3 CalculateLight(const Vector3f& lightDir, const Vector3f& viewDir,
-                                 const Vector3f& halfwayDir, const Vector3f& normal,
-                                 Float visibility, const Color3& albedo,
-                                 const Color3& emissive, const Vector3f& param,
-                                 const Color3& lightRadiance)
+    // albedo and emissive are in linear space (Texture::SampleLinear, material colors
+    // are linearized when loaded). localLight is the outgoing radiance of the local
+    // lights (CalculateLocalLights). For a pixel (Float, Vector3f) or a packet of 8
+    // pixels (Float8, Vec3x8, deferred lighting pass), the same operations per lane.
+    template <typename T, typename V>
+    static V CalculateLight(const V& lightDir, const V& viewDir, const V& halfwayDir,
+                            const V& normal, T visibility, const V& albedo,
+                            const V& emissive, const V& param, const V& lightRadiance,
+                            const V& localLight)
     {
-        // Gamma Correction (sRGB -> Linear Space)
-        Color3 albedoLinear = Pow(albedo, Gamma);
-        Color3 emissiveLinear = Pow(emissive, Gamma);
-
-        Float ao = param.x;
-        Float metalness = param.y;
-        Float roughness = param.z;
-
-        // Dot, Dot, Dot
-        Float NdotV = Max(Dot(normal, viewDir), 0.f);
-        Float NdotL = Max(Dot(normal, lightDir), 0.f);
-        Float NdotH = Max(Dot(normal, halfwayDir), 0.f);
-        Float HdotV = Max(Dot(halfwayDir, viewDir), 0.f);
-
-        // Reflectance Equation
-        Color3 F0 = Vector3f(0.04f);  // average base reflectivity
-        F0 = Lerp(metalness, F0, albedoLinear);
-
-        // Cook-Torrance BRDF
-        Float    NDF = distributionGGX(NdotH, roughness);  // D
-        Float    G = geometrySmith(NdotV, NdotL, roughness);
-        Vector3f F = fresnelSchlick(HdotV, F0);
-        Vector3f DGF = NDF * G * F;
-        Float    denominator =
-            4 * NdotV * NdotL + 0.001f;  // 0.001 to avoid division by zero
-
-        // Specular
-        Vector3f ks = F;
-        Vector3f specular = DGF / denominator;
-
-        // Diffuse
-        Vector3f kd = Vector3f(1.f) - ks;
-        kd *= 1.f - metalness;  // only non-metallic material has diffuse lighting
-
-        // BRDF
-        Vector3f brdf = kd * albedoLinear * InvPi + specular;
+        T ao = param.x;
 
         // Outgoing Radiance
-        Color3 Lo = brdf * lightRadiance * NdotL;
+        V Lo = CalculateDirectLight<T>(lightDir, viewDir, halfwayDir, normal, albedo,
+                                       param, lightRadiance);
 
         // Shadow Mapping
         if (Shadow::GetShadowStatus())
         {
             Float shadowIntensity = 0.6f;
-            Float shadow = (1 - visibility) * shadowIntensity;
-            visibility = 1 - shadow;
+            T     shadow = (1.f - visibility) * shadowIntensity;
+            visibility = 1.f - shadow;
             Lo *= visibility;
         }
 
-        Color3 color = Lo;
+        V color = Lo + localLight;
 
         // Ambient
-        Color3 ambient = Color3(0.3) * albedoLinear * ao;
+        V ambient = V(0.3f) * albedo * ao;
         color += ambient;
 
         // Emissive
-        color += emissiveLinear;
+        color += emissive;
 
         // HDR Tonemapping
-        color = color / (color + Color3(1.f));
+        color = color / (color + V(1.f));
 
         // Gamma Correction
         color = Pow(color, InvGamma);
@@ -252,38 +248,128 @@ struct PBRShader : public Shader
         return Clamp01(color);
     }
 
+    // Outgoing radiance of one light (Cook-Torrance BRDF)
+    template <typename T, typename V>
+    static V CalculateDirectLight(const V& lightDir, const V& viewDir,
+                                  const V& halfwayDir, const V& normal, const V& albedo,
+                                  const V& param, const V& lightRadiance)
+    {
+        T metalness = param.y;
+        T roughness = param.z;
+
+        // Dot, Dot, Dot
+        T NdotV = Max(Dot(normal, viewDir), T(0.f));
+        T NdotL = Max(Dot(normal, lightDir), T(0.f));
+        T NdotH = Max(Dot(normal, halfwayDir), T(0.f));
+        T HdotV = Max(Dot(halfwayDir, viewDir), T(0.f));
+
+        // Reflectance Equation
+        V F0 = V(0.04f);  // average base reflectivity
+        F0 = Lerp(metalness, F0, albedo);
+
+        // Cook-Torrance BRDF
+        T NDF = distributionGGX(NdotH, roughness);  // D
+        T G = geometrySmith(NdotV, NdotL, roughness);
+        V F = fresnelSchlick(HdotV, F0);
+        V DGF = NDF * G * F;
+        T denominator = 4.f * NdotV * NdotL + 0.001f;  // 0.001 to avoid division by zero
+
+        // Specular
+        V ks = F;
+        V specular = DGF / denominator;
+
+        // Diffuse
+        V kd = V(1.f) - ks;
+        kd *= 1.f - metalness;  // only non-metallic material has diffuse lighting
+
+        // BRDF
+        V brdf = kd * albedo * InvPi + specular;
+
+        return brdf * lightRadiance * NdotL;
+    }
+
+    // Outgoing radiance of the local lights of a light cluster (ForkerGL::LightClusters)
+    template <typename T, typename V>
+    static V CalculateLocalLights(const LightGrid::LightList& lights, const V& positionWS,
+                                  const V& viewDir, const V& normal, const V& albedo,
+                                  const V& param)
+    {
+        V Lo(0.f);
+        for (const PointLight* light : lights)
+        {
+            V lightVec = V(light->position) - positionWS;
+            T falloff = LocalLightFalloff(Dot(lightVec, lightVec), light->radius);
+            V lightDir = Normalize(lightVec);
+            V halfwayDir = Normalize(lightDir + viewDir);
+            Lo += CalculateDirectLight<T>(lightDir, viewDir, halfwayDir, normal, albedo,
+                                          param, V(light->color) * falloff);
+        }
+        return Lo;
+    }
+
 private:
-    static Float distributionGGX(Float NdotH, Float roughness)
+    using VertexVariant = Point4f (PBRShader::*)(int, int);
+    using FragmentVariant = bool (PBRShader::*)(const Vector3f&, Color3&);
+
+    VertexVariant   m_VertexVariant = nullptr;
+    FragmentVariant m_FragmentVariant = nullptr;
+
+    // Variants indexed by their features
+    static VertexVariant getVertexVariant(int features)
+    {
+        static const VertexVariant s_Variants[] = {
+            &PBRShader::ProcessVertex<0>, &PBRShader::ProcessVertex<1>,
+            &PBRShader::ProcessVertex<2>, &PBRShader::ProcessVertex<3>
+        };
+        return s_Variants[features & VertexFeatures];
+    }
+
+    template <int... Features>
+    static FragmentVariant getFragmentVariant(int features,
+                                              std::integer_sequence<int, Features...>)
+    {
+        static const FragmentVariant s_Variants[] = {
+            &PBRShader::ProcessFragment<Features>...
+        };
+        return s_Variants[features];
+    }
+
+    // Terms of the BRDF, for a Float or a packet of them (Float8)
+    template <typename T>
+    static T distributionGGX(const T& NdotH, const T& roughness)
     {
-        Float a = roughness * roughness;  // roughness^2 is better
-        Float a2 = a * a;
-        Float NdotH2 = NdotH * NdotH;
+        T a = roughness * roughness;  // roughness^2 is better
+        T a2 = a * a;
+        T NdotH2 = NdotH * NdotH;
 
-        Float denominator = (NdotH2 * (a2 - 1.f) + 1.f);
-        Float denominator2 = denominator * denominator;
-        Float NDF = a2 * InvPi / denominator2;
+        T denominator = (NdotH2 * (a2 - 1.f) + 1.f);
+        T denominator2 = denominator * denominator;
+        T NDF = a2 * InvPi / denominator2;
         return NDF;
     }
 
-    static Float geometrySchlickGGX(Float NdotV, Float roughness)
+    template <typename T>
+    static T geometrySchlickGGX(const T& NdotV, const T& roughness)
     {
-        Float a = roughness + 1.f;
-        Float k = a * a / 8.f;
+        T a = roughness + 1.f;
+        T k = a * a / 8.f;
         return NdotV / (NdotV * (1 - k) + k);
     }
 
-    static Float geometrySmith(Float NdotV, Float NdotL, Float roughness)
+    template <typename T>
+    static T geometrySmith(const T& NdotV, const T& NdotL, const T& roughness)
     {
         // Geometry Obstruction
-        Float ggx1 = geometrySchlickGGX(NdotV, roughness);
+        T ggx1 = geometrySchlickGGX(NdotV, roughness);
         // Geometry Shadowing
-        Float ggx2 = geometrySchlickGGX(NdotL, roughness);
+        T ggx2 = geometrySchlickGGX(NdotL, roughness);
         return ggx1 * ggx2;
     }
 
-    static Vector3f fresnelSchlick(Float cosTheta, const Vector3f& f0)
+    template <typename T, typename V>
+    static V fresnelSchlick(const T& cosTheta, const V& f0)
     {
-        Float OneMinusHdotV = Max(1.f - cosTheta, 0.f);
-        return f0 + (Vector3f(1.f) - f0) * Pow(OneMinusHdotV, 5.f);
+        T OneMinusHdotV = Max(1.f - cosTheta, T(0.f));
+        return f0 + (V(1.f) - f0) * Pow(OneMinusHdotV, 5.f);
     }
 };
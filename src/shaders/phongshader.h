@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "packet.h"
 #include "shader.h"
 
 struct BlinnPhongShader : public Shader
@@ -16,8 +17,6 @@ struct BlinnPhongShader : public Shader
 
     // Vertex (out) -> Fragment (in)
     Matrix3x3f v2fPositionsWS;
-    Matrix2x3f v2fTexCoords;
-    Vector3f   v2fOneOverWs;
 
     // Uniform Variables
     Matrix4x4f uModelMatrix;
@@ -31,8 +30,23 @@ struct BlinnPhongShader : public Shader
     Matrix4x4f uLightSpaceMatrix;
     Matrix3x3f vPositionLightSpaceNDC;
 
+    // Variant for the material features of the mesh
+    void SelectVariant() override
+    {
+        int features = GetMaterialFeatures(*mesh, false);
+        m_VertexVariant = getVertexVariant(features);
+        m_FragmentVariant = getFragmentVariant(
+            features, std::make_integer_sequence<int, NumPhongVariants>());
+    }
+
     // Vertex Shader
     Point4f ProcessVertex(int faceIdx, int vertIdx) override
+    {
+        return (this->*m_VertexVariant)(faceIdx, vertIdx);
+    }
+
+    template <int Features>
+    Point4f ProcessVertex(int faceIdx, int vertIdx)
     {
         // MVP
         Point4f positionWS = uModelMatrix * Point4f(mesh->Vert(faceIdx, vertIdx), 1.f);
@@ -43,7 +57,7 @@ struct BlinnPhongShader : public Shader
         Vector2f texCoord = mesh->TexCoord(faceIdx, vertIdx);
         Vector3f normalWS = uNormalMatrix * mesh->Normal(faceIdx, vertIdx);
         Vector3f tangentWS;
-        if (mesh->GetModel().HasTangents())
+        if (Features & NormalMapFeature)
         {
             tangentWS = uNormalMatrix * mesh->Tangent(faceIdx, vertIdx);
         }
@@ -53,7 +67,7 @@ struct BlinnPhongShader : public Shader
         v2fTexCoords.SetCol(vertIdx, texCoord);
 
         // Shadow Mapping
-        bool    isShadowOn = Shadow::GetShadowStatus();
+        bool    isShadowOn = Features & ShadowFeature;
         Point4f positionLightSpaceNDC;
         if (isShadowOn)
         {
@@ -68,15 +82,14 @@ struct BlinnPhongShader : public Shader
         positionWS *= oneOverW;
         texCoord *= oneOverW;
         normalWS *= oneOverW;
-        if (mesh->GetModel().HasTangents()) tangentWS *= oneOverW;
+        if (Features & NormalMapFeature) tangentWS *= oneOverW;
         if (isShadowOn) positionLightSpaceNDC *= oneOverW;
 #endif
         // Varying
         vTexCoordCorrected.SetCol(vertIdx, texCoord);
         vPositionCorrectedWS.SetCol(vertIdx, positionWS.xyz);
         vNormalCorrectedWS.SetCol(vertIdx, normalWS);
-        if (mesh->GetModel().HasTangents())
-            vTangentCorrectedWS.SetCol(vertIdx, tangentWS);
+        if (Features & NormalMapFeature) vTangentCorrectedWS.SetCol(vertIdx, tangentWS);
         if (isShadowOn) vPositionLightSpaceNDC.SetCol(vertIdx, positionLightSpaceNDC.xyz);
 
         // Perspective Division
@@ -89,8 +102,12 @@ struct BlinnPhongShader : public Shader
     // Fragment Shader
     bool ProcessFragment(const Vector3f& baryCoord, Color3& gl_Color) override
     {
-        std::shared_ptr<const Material> material = mesh->GetMaterial();
+        return (this->*m_FragmentVariant)(baryCoord, gl_Color);
+    }
 
+    template <int Features>
+    bool ProcessFragment(const Vector3f& baryCoord, Color3& gl_Color)
+    {
         // Interpolation
         Point3f  positionWS = vPositionCorrectedWS * baryCoord;
         Vector2f texCoord = vTexCoordCorrected * baryCoord;
@@ -106,7 +123,7 @@ struct BlinnPhongShader : public Shader
         Vector3f N = Normalize(normalWS);  // World Space
         Vector3f normal;
 
-        if (mesh->GetModel().HasTangents() && material->HasNormalMap())
+        if (Features & NormalMapFeature)
         {
             Vector3f tangentWS = vTangentCorrectedWS * baryCoord;
 #ifdef PERSPECTIVE_CORRECT_INTERPOLATION
@@ -118,8 +135,8 @@ struct BlinnPhongShader : public Shader
             Vector3f   B = Normalize(Cross(N, T));
             Matrix3x3f TbnMatrix;
             TbnMatrix.SetCol(0, T).SetCol(1, B).SetCol(2, N);
-            Vector3f sampledNormal = material->normalMap->Sample(texCoord);
-            sampledNormal = Normalize(sampledNormal * 2.f - Vector3f(1.f));  // remap
+            Vector3f sampledNormal =
+                material.normalMap->SampleNormal(texCoord, v2fTexLod);  // [-1, 1]
             normal = Normalize(TbnMatrix * sampledNormal);  // World Space
         }
         else
@@ -138,7 +155,7 @@ struct BlinnPhongShader : public Shader
 
         // Shadow Mapping
         Float visibility = 0.f;
-        if (Shadow::GetShadowStatus())
+        if (Features & ShadowFeature)
         {
             Point3f positionLightSpaceNDC = vPositionLightSpaceNDC * baryCoord;
 #ifdef PERSPECTIVE_CORRECT_INTERPOLATION
@@ -149,68 +166,127 @@ struct BlinnPhongShader : public Shader
         }
 
         // Blinn-Phong Shading
-        std::shared_ptr<const Texture> diffuseMap = material->diffuseMap;
-        std::shared_ptr<const Texture> specularMap = material->specularMap;
-        std::shared_ptr<const Texture> emissiveMap = material->emissiveMap;
-
-        Color3 diffuseColor =
-            material->HasDiffuseMap() ? diffuseMap->Sample(texCoord) : material->kd;
-        Color3 emissive =
-            material->HasEmissiveMap() ? emissiveMap->Sample(texCoord) : material->ke;
+        Color3 diffuseColor = material.kd;
+        if (Features & ColorMapFeature)
+            diffuseColor = material.diffuseMap->SampleLinear(texCoord, v2fTexLod);
+        Color3 emissive = material.ke;
+        if (Features & EmissiveMapFeature)
+            emissive = material.emissiveMap->SampleLinear(texCoord, v2fTexLod);
         Float shininess = 1.f;
-        if (material->HasSpecularMap())
-            shininess = specularMap->SampleFloat(texCoord) + 5;
-        Vector3f param(material->ka.x, material->ks.x, shininess);
+        if (Features & SpecularMapFeature)
+            shininess = material.specularMap->SampleFloat(texCoord, 2, v2fTexLod) + 5;
+        Vector3f param(material.ka.x, material.ks.x, shininess);
+
+        // Local Lights (of the light cluster of the fragment)
+        Color3 localLight(0.f);
+        if (!ForkerGL::LightClusters.IsEmpty())
+        {
+            LightGrid::LightList lights = ForkerGL::LightClusters.GetLights(positionWS);
+            localLight = CalculateLocalLights<Float>(lights, positionWS, viewDir, normal,
+                                                     diffuseColor, param);
+        }
 
         gl_Color = CalculateLight(lightDir, halfwayDir, normal, visibility, diffuseColor,
-                                  emissive, param, uPointLight.color);
+                                  emissive, param, uPointLight.color, localLight);
 
         return false;  // do not discard
     }
 
-    static Color3 CalculateLight(const Vector3f& lightDir, const Vector3f& halfwayDir,
-                                 const Vector3f& normal, Float visibility,
-                                 const Color3& diffuseColor, const Color3& emissive,
-                                 const Vector3f& param, const Color3& lightColor)
+    // diffuseColor and emissive are in linear space, localLight is the light of the local
+    // lights (see PBRShader::CalculateLight)
+    template <typename T, typename V>
+    static V CalculateLight(const V& lightDir, const V& halfwayDir, const V& normal,
+                            T visibility, const V& diffuseColor, const V& emissive,
+                            const V& param, const V& lightColor, const V& localLight)
     {
-        // Gamma Correction (sRGB -> Linear Space)
-        Color3 diffuseColorLinear = Pow(diffuseColor, Gamma);
-        Color3 emissiveLinear = Pow(emissive, Gamma);
-
-        Float ao = param.x;
-        Float ks = param.y;
-        Float shininess = param.z;
+        T ao = param.x;
+        T ks = param.y;
+        T shininess = param.z;
 
         // Diffuse
-        Float diff = Max(0.f, Dot(lightDir, normal));
+        T diff = Max(T(0.f), Dot(lightDir, normal));
 
         // Specular
-        Float spec = std::pow(Max(0.f, Dot(halfwayDir, normal)), shininess);
+        T spec = Pow(Max(T(0.f), Dot(halfwayDir, normal)), shininess);
 
         // Color of Shading Component
-        Color3 ambient = Color3(0.3f) * diffuseColorLinear * ao;
-        Color3 diffuse = diffuseColorLinear * diff * ao;
-        Color3 specular = Color3(ks) * spec;
+        V ambient = V(0.3f) * diffuseColor * ao;
+        V diffuse = diffuseColor * diff * ao;
+        V specular = V(ks) * spec;
 
         // Shadow Mapping
         if (Shadow::GetShadowStatus())
         {
             Float shadowIntensity = 0.6f;
-            Float shadow = (1 - visibility) * shadowIntensity;
-            visibility = 1 - shadow;
+            T     shadow = (1.f - visibility) * shadowIntensity;
+            visibility = 1.f - shadow;
             diffuse *= visibility;
             specular *= visibility;
         }
 
         // Combine
-        Color3 color = ambient + (diffuse + specular + emissiveLinear) * lightColor;
+        V color = ambient + (diffuse + specular + emissive) * lightColor + localLight;
 
         // HDR Tonemapping
-        color = color / (color + Color3(1.f));
+        color = color / (color + V(1.f));
 
         // Gamma Correction
         color = Pow(color, InvGamma);
 
         return Clamp01(color);
     }
+
+    // Diffuse and specular light of the local lights of a light cluster
+    template <typename T, typename V>
+    static V CalculateLocalLights(const LightGrid::LightList& lights, const V& positionWS,
+                                  const V& viewDir, const V& normal,
+                                  const V& diffuseColor, const V& param)
+    {
+        T ao = param.x;
+        T ks = param.y;
+        T shininess = param.z;
+
+        V color(0.f);
+        for (const PointLight* light : lights)
+        {
+            V lightVec = V(light->position) - positionWS;
+            T falloff = LocalLightFalloff(Dot(lightVec, lightVec), light->radius);
+            V lightDir = Normalize(lightVec);
+            V halfwayDir = Normalize(lightDir + viewDir);
+
+            T diff = Max(T(0.f), Dot(lightDir, normal));
+            T spec = Pow(Max(T(0.f), Dot(halfwayDir, normal)), shininess);
+            V diffuse = diffuseColor * diff * ao;
+            V specular = V(ks) * spec;
+            color += (diffuse + specular) * V(light->color) * falloff;
+        }
+        return color;
+    }
+
+private:
+    using VertexVariant = Point4f (BlinnPhongShader::*)(int, int);
+    using FragmentVariant = bool (BlinnPhongShader::*)(const Vector3f&, Color3&);
+
+    VertexVariant   m_VertexVariant = nullptr;
+    FragmentVariant m_FragmentVariant = nullptr;
+
+    // Variants indexed by their features
+    static VertexVariant getVertexVariant(int features)
+    {
+        static const VertexVariant s_Variants[] = {
+            &BlinnPhongShader::ProcessVertex<0>, &BlinnPhongShader::ProcessVertex<1>,
+            &BlinnPhongShader::ProcessVertex<2>, &BlinnPhongShader::ProcessVertex<3>
+        };
+        return s_Variants[features & VertexFeatures];
+    }
+
+    template <int... Features>
+    static FragmentVariant getFragmentVariant(int features,
+                                              std::integer_sequence<int, Features...>)
+    {
+        static const FragmentVariant s_Variants[] = {
+            &BlinnPhongShader::ProcessFragment<Features>...
+        };
+        return s_Variants[features];
+    }
 };
\ No newline at end of file
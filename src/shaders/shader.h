@@ -14,18 +14,91 @@
 #include "shadow.h"
 #include "forkergl.h"
 
+// Material features that shader variants are specialized for: the fragment (and vertex)
+// shaders are instantiated per combination, and Shader::SelectVariant picks one per mesh
+enum ShaderFeature
+{
+    NormalMapFeature = 1 << 0,  // normal map and tangents
+    ShadowFeature = 1 << 1,
+    ColorMapFeature = 1 << 2,  // base color (PBR) or diffuse (Blinn-Phong) map
+    EmissiveMapFeature = 1 << 3,
+    SpecularMapFeature = 1 << 4,  // Blinn-Phong
+    RoughnessMapFeature = 1 << 4,  // PBR
+    MetalnessMapFeature = 1 << 5,
+    AmbientOcclusionMapFeature = 1 << 6,
+
+    OrmMapFeatures = RoughnessMapFeature | MetalnessMapFeature |
+                     AmbientOcclusionMapFeature,  // packed in one texture
+    VertexFeatures = NormalMapFeature | ShadowFeature,  // the lowest bits
+    NumPhongVariants = 1 << 5,
+    NumPBRVariants = 1 << 7
+};
+
 // Abstract Class
 struct Shader
 {
-    std::shared_ptr<const Mesh> mesh;
+    // Mesh being drawn and its materials (set by Use, once per draw)
+    const Mesh*       mesh;
+    MaterialRecord    material;
+    PBRMaterialRecord pbrMaterial;
 
-    Shader() : mesh(nullptr) { }
+    // Texture Level Of Detail (per triangle)
+    // Vertex texture coordinates are written by the vertex shader, the rasterizer turns
+    // them into the LOD passed to Texture::Sample()
+    Matrix2x3f v2fTexCoords;
+    Float      v2fTexLod;
+
+    // 1/w of the vertices (perspective correct interpolation), also used by the
+    // rasterizer to interpolate v2fTexCoords (see ShadingCache)
+    Vector3f v2fOneOverWs;
+
+    Shader()
+        : mesh(nullptr), material(), pbrMaterial(), v2fTexLod(-FLT_MAX), v2fOneOverWs(1.f)
+    {
+    }
     virtual ~Shader() { }
 
-    // Use Shader Program (set which mesh to shade on)
-    void Use(std::shared_ptr<const Mesh> m) { mesh = m; }
+    // Use Shader Program (set which mesh to shade on, before Mesh::Draw)
+    void Use(const Mesh& m)
+    {
+        mesh = &m;
+
+        std::shared_ptr<const Material>    mtl = m.GetMaterial();
+        std::shared_ptr<const PBRMaterial> pbrMtl = m.GetPBRMaterial();
+        material = mtl ? mtl->GetRecord() : MaterialRecord();
+        pbrMaterial = pbrMtl ? pbrMtl->GetRecord() : PBRMaterialRecord();
+    }
+    // Specializes the shader for the material features of its mesh (once per mesh)
+    virtual void SelectVariant() { }
     // Vertex Shader
     virtual Point4f ProcessVertex(int faceIdx, int vertIdx) = 0;
     // Fragment Shader
     virtual bool ProcessFragment(const Vector3f& baryCoord, Color3& gl_Color) = 0;
+
+    // Features of the mesh for the PBR or Blinn-Phong path (ShaderFeature bits)
+    static int GetMaterialFeatures(const Mesh& mesh, bool pbr)
+    {
+        int features = Shadow::GetShadowStatus() ? ShadowFeature : 0;
+        if (pbr)
+        {
+            std::shared_ptr<const PBRMaterial> m = mesh.GetPBRMaterial();
+            if (mesh.GetModel().HasTangents() && m->HasNormalMap())
+                features |= NormalMapFeature;
+            if (m->HasBaseColorMap()) features |= ColorMapFeature;
+            if (m->HasEmssiveMap()) features |= EmissiveMapFeature;
+            if (m->HasRoughnessMap()) features |= RoughnessMapFeature;
+            if (m->HasMetalnessMap()) features |= MetalnessMapFeature;
+            if (m->HasAmbientOcclusionMap()) features |= AmbientOcclusionMapFeature;
+        }
+        else
+        {
+            std::shared_ptr<const Material> m = mesh.GetMaterial();
+            if (mesh.GetModel().HasTangents() && m->HasNormalMap())
+                features |= NormalMapFeature;
+            if (m->HasDiffuseMap()) features |= ColorMapFeature;
+            if (m->HasEmissiveMap()) features |= EmissiveMapFeature;
+            if (m->HasSpecularMap()) features |= SpecularMapFeature;
+        }
+        return features;
+    }
 };
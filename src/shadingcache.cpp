@@ -0,0 +1,173 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#include "shadingcache.h"
+
+#include <spdlog/spdlog.h>
+
+#include "mesh.h"
+#include "shader.h"
+#include "utility.h"
+
+static const std::size_t s_MaxTiles = 1 << 20;  // per mesh, both sides
+static const Float       s_MaxExtrapolation = 0.5f;  // barycentric, beyond the triangle
+
+ShadingCache::ShadingCache() : ShadingCache(0) { }
+
+ShadingCache::ShadingCache(int density)
+    : m_Density(Max(density, 0)),
+      m_Atlas(nullptr),
+      m_Side(0),
+      m_NumSamples(0),
+      m_NumShaded(0)
+{
+}
+
+void ShadingCache::BeginTriangle(Shader& shader)
+{
+    Atlas& atlas = getAtlas(*shader.mesh);
+
+    const Matrix2x3f& uv = shader.v2fTexCoords;
+    m_TexCoord0 = Vector2f(uv[0][0], uv[1][0]);
+    Vector2f t1 = Vector2f(uv[0][1], uv[1][1]) - m_TexCoord0;
+    Vector2f t2 = Vector2f(uv[0][2], uv[1][2]) - m_TexCoord0;
+    Float    det = t1.x * t2.y - t1.y * t2.x;
+
+    // No texture space to shade in (too large atlas or degenerate texture coordinates)
+    m_Atlas = &atlas;
+    if (atlas.tiles.empty() || std::abs(det) * m_Density * m_Density < 1e-6f)
+    {
+        m_Atlas = nullptr;
+        return;
+    }
+
+    // Inverse of [t1 t2]: texture coordinate offset -> (b1, b2)
+    m_Side = det > 0.f ? 0 : 1;
+    m_ToBary[0][0] = t2.y / det;
+    m_ToBary[0][1] = -t2.x / det;
+    m_ToBary[1][0] = -t1.y / det;
+    m_ToBary[1][1] = t1.x / det;
+}
+
+bool ShadingCache::Shade(Shader& shader, const Vector3f& baryCoord, Color3& color)
+{
+    ++m_NumSamples;
+    if (!m_Atlas)
+    {
+        ++m_NumShaded;
+        return shader.ProcessFragment(baryCoord, color);
+    }
+
+    // Texture coordinate of the sample, as the shaders interpolate it
+    Vector3f weights = baryCoord;
+#ifdef PERSPECTIVE_CORRECT_INTERPOLATION
+    weights = baryCoord * shader.v2fOneOverWs;
+    weights /= weights.x + weights.y + weights.z;
+#endif
+    Vector2f p = (shader.v2fTexCoords * weights) * (Float)m_Density - Vector2f(0.5f);
+    int      x = (int)std::floor(p.x), y = (int)std::floor(p.y);
+    Float    tx = p.x - x, ty = p.y - y;
+
+    Color3 top = Lerp(tx, getTexel(shader, x, y), getTexel(shader, x + 1, y));
+    Color3 bottom = Lerp(tx, getTexel(shader, x, y + 1), getTexel(shader, x + 1, y + 1));
+    color = Lerp(ty, top, bottom);
+    return false;
+}
+
+ShadingCache::Atlas& ShadingCache::getAtlas(const Mesh& mesh)
+{
+    auto iter = m_Atlases.find(&mesh);
+    if (iter != m_Atlases.end()) return iter->second;
+
+    Vector2f minUV(FLT_MAX), maxUV(-FLT_MAX);
+    for (int f = 0; f < mesh.NumFaces(); ++f)
+    {
+        for (int v = 0; v < 3; ++v)
+        {
+            Vector2f uv = mesh.TexCoord(f, v);
+            minUV = Vector2f(Min(minUV.x, uv.x), Min(minUV.y, uv.y));
+            maxUV = Vector2f(Max(maxUV.x, uv.x), Max(maxUV.y, uv.y));
+        }
+    }
+
+    // One texel of margin for the footprint of samples on the border
+    Atlas atlas;
+    atlas.mesh = mesh.shared_from_this();
+    double x0 = std::floor(minUV.x * (double)m_Density) - 1;
+    double y0 = std::floor(minUV.y * (double)m_Density) - 1;
+    double x1 = std::floor(maxUV.x * (double)m_Density) + 1;
+    double y1 = std::floor(maxUV.y * (double)m_Density) + 1;
+    double numTiles = 2.0 * (std::floor((x1 - x0) / s_TileSize) + 2) *
+                      (std::floor((y1 - y0) / s_TileSize) + 2);
+    if (mesh.NumFaces() == 0 || numTiles > s_MaxTiles)
+    {
+        spdlog::warn("Texture coordinates of a mesh span too many shading texels, "
+                     "shaded per sample");
+        return m_Atlases.emplace(&mesh, std::move(atlas)).first->second;
+    }
+
+    atlas.tileX = (int)x0 >> s_TileShift;
+    atlas.tileY = (int)y0 >> s_TileShift;
+    atlas.tilesPerRow = ((int)x1 >> s_TileShift) - atlas.tileX + 1;
+    atlas.tileRows = ((int)y1 >> s_TileShift) - atlas.tileY + 1;
+    atlas.tiles.resize(2 * (std::size_t)atlas.tilesPerRow * atlas.tileRows);
+    return m_Atlases.emplace(&mesh, std::move(atlas)).first->second;
+}
+
+Color3 ShadingCache::getTexel(Shader& shader, int x, int y)
+{
+    Atlas& atlas = *m_Atlas;
+    int    tileX = (x >> s_TileShift) - atlas.tileX;
+    int    tileY = (y >> s_TileShift) - atlas.tileY;
+    if (tileX < 0 || tileY < 0 || tileX >= atlas.tilesPerRow || tileY >= atlas.tileRows)
+    {
+        ++m_NumShaded;
+        return shadeTexel(shader, x, y);
+    }
+
+    std::unique_ptr<Tile>& tile =
+        atlas.tiles[(m_Side * atlas.tileRows + tileY) * atlas.tilesPerRow + tileX];
+    if (!tile)
+    {
+        tile.reset(new Tile);
+        tile->shaded = 0;
+    }
+
+    int           i = ((y & s_TileMask) << s_TileShift) + (x & s_TileMask);
+    std::uint64_t bit = (std::uint64_t)1 << i;
+    if (!(tile->shaded & bit))
+    {
+        tile->colors[i] = shadeTexel(shader, x, y);
+        tile->shaded |= bit;
+        ++m_NumShaded;
+    }
+    return tile->colors[i];
+}
+
+// Shades the point of the triangle (extended in its plane) at the texel center. Centers
+// far outside of it (triangles smaller than a texel) are moved onto the triangle.
+Color3 ShadingCache::shadeTexel(Shader& shader, int x, int y) const
+{
+    Vector2f center = Vector2f((x + 0.5f) / m_Density, (y + 0.5f) / m_Density);
+    Vector2f offset = center - m_TexCoord0;
+    Float    b1 = m_ToBary[0][0] * offset.x + m_ToBary[0][1] * offset.y;
+    Float    b2 = m_ToBary[1][0] * offset.x + m_ToBary[1][1] * offset.y;
+
+    Vector3f weights(1.f - b1 - b2, b1, b2);
+    if (Min3(weights.x, weights.y, weights.z) < -s_MaxExtrapolation)
+    {
+        weights = Vector3f(Max(weights.x, 0.f), Max(weights.y, 0.f), Max(weights.z, 0.f));
+        weights /= weights.x + weights.y + weights.z;
+    }
+
+    // Screen space barycentric coordinates of the point, as the rasterizer passes them
+#ifdef PERSPECTIVE_CORRECT_INTERPOLATION
+    weights = weights / shader.v2fOneOverWs;
+    weights /= weights.x + weights.y + weights.z;
+#endif
+
+    Color3 color;
+    shader.ProcessFragment(weights, color);
+    return color;
+}
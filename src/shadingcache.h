@@ -0,0 +1,77 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#pragma once
+
+#include "color.h"
+#include "geometry.h"
+
+class Mesh;
+struct Shader;
+
+// Texture-space shading ('shading texel <density>', forward pass): fragments are shaded
+// at the texel centers of a per-mesh atlas laid over the mesh's texture coordinates
+// (density texels per unit), once per texel on first use. A sample (pixel or SSAA
+// subsample) filters the four texels around its texture coordinate, so the shading cost
+// follows the shaded surface area instead of the number of samples.
+//
+// Texels are keyed by (mesh, texel, side): mirrored UV islands (flipped winding) shade
+// their own texels, overlapping islands with the same winding share them.
+class ShadingCache
+{
+public:
+    ShadingCache();
+    explicit ShadingCache(int density);
+
+    inline bool IsEnabled() const { return m_Density > 0; }
+    inline int  GetDensity() const { return m_Density; }
+
+    // Atlas and texture space of the triangle the shader draws next (its vertices are
+    // processed)
+    void BeginTriangle(Shader& shader);
+
+    // Color of the fragment at screen space barycentric coordinates, filtered from the
+    // texels around its texture coordinate. Returns whether to discard (as
+    // Shader::ProcessFragment does).
+    bool Shade(Shader& shader, const Vector3f& baryCoord, Color3& color);
+
+    inline std::size_t GetNumSamples() const { return m_NumSamples; }
+    inline std::size_t GetNumShaded() const { return m_NumShaded; }
+
+private:
+    static const int s_TileShift = 3;  // 8x8 texels
+    static const int s_TileSize = 1 << s_TileShift;
+    static const int s_TileMask = s_TileSize - 1;
+
+    struct Tile
+    {
+        Color3        colors[s_TileSize * s_TileSize];
+        std::uint64_t shaded;  // one bit per texel
+    };
+
+    // Tiles covering the texture coordinate bounds of a mesh, allocated on first use
+    struct Atlas
+    {
+        std::shared_ptr<const Mesh>        mesh;  // keeps the key from being reused
+        int                                tileX, tileY;  // first tile
+        int                                tilesPerRow, tileRows;
+        std::vector<std::unique_ptr<Tile>> tiles;  // per side, empty if too large
+    };
+
+    int                                    m_Density;
+    std::unordered_map<const Mesh*, Atlas> m_Atlases;
+
+    // Triangle being drawn: texture coordinate -> barycentric (second and third vertex)
+    Atlas*     m_Atlas;
+    int        m_Side;
+    Vector2f   m_TexCoord0;
+    Matrix2x2f m_ToBary;
+
+    std::size_t m_NumSamples;
+    std::size_t m_NumShaded;
+
+    Atlas& getAtlas(const Mesh& mesh);
+    Color3 getTexel(Shader& shader, int x, int y);
+    Color3 shadeTexel(Shader& shader, int x, int y) const;
+};
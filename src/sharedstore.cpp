@@ -0,0 +1,171 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#include "sharedstore.h"
+
+#include <spdlog/spdlog.h>
+
+#include "mappedfile.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define FORKER_HAS_SHM
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char          s_ObjectMagic[4] = { 'F', 'K', 'S', 'A' };
+static const std::uint32_t s_ObjectVersion = 1;
+static const std::size_t   s_HeaderSize = 64;  // keeps the payload cache line aligned
+static const int           s_ReadyTimeoutMs = 10000;
+
+struct SharedObjectHeader
+{
+    char          magic[4];
+    std::uint32_t version;
+    std::uint32_t ready;  // set last by the publisher (release)
+    std::uint32_t reserved;
+    std::uint64_t payloadSize;
+};
+
+static_assert(sizeof(SharedObjectHeader) <= s_HeaderSize, "header does not fit");
+
+/////////////////////////////////////////////////////////////////////////////////
+
+std::string SharedAssetStore::MakeName(const std::string& filename,
+                                       const std::string& options)
+{
+#ifdef FORKER_HAS_SHM
+    std::uint64_t size;
+    std::int64_t  mtime;
+    if (!GetFileStat(filename, size, mtime)) return "";
+
+    // Processes may start from different working directories
+    char        resolved[PATH_MAX];
+    std::string path = realpath(filename.c_str(), resolved) ? resolved : filename;
+
+    std::string key = path + '\n' + std::to_string(size) + '\n' + std::to_string(mtime) +
+                      '\n' + options + '\n' + std::to_string(s_ObjectVersion);
+
+    std::uint64_t hash = 14695981039346656037ull;  // FNV-1a
+    for (char c : key)
+    {
+        hash = (hash ^ (std::uint8_t)c) * 1099511628211ull;
+    }
+
+    // Short enough for the 31 character limit on macOS
+    char name[32];
+    snprintf(name, sizeof(name), "/fkr-%016llx", (unsigned long long)hash);
+    return name;
+#else
+    return "";
+#endif
+}
+
+std::shared_ptr<const MappedFile> SharedAssetStore::Attach(const std::string& name)
+{
+#ifdef FORKER_HAS_SHM
+    if (name.empty()) return nullptr;
+
+    // The object exists as soon as a publisher created it, but it is sized and
+    // filled afterwards
+    for (int waited = 0; waited < s_ReadyTimeoutMs; ++waited)
+    {
+        auto object = std::make_shared<MappedFile>();
+        if (!object->OpenSharedMemory(name))
+        {
+            int fd = shm_open(name.c_str(), O_RDONLY, 0);
+            if (fd < 0) return nullptr;  // not published
+            close(fd);
+        }
+        else if (object->GetSize() >= s_HeaderSize)
+        {
+            // The rest of the header is written before the ready flag
+            const auto* header =
+                reinterpret_cast<const SharedObjectHeader*>(object->GetData());
+            if (__atomic_load_n(&header->ready, __ATOMIC_ACQUIRE))
+            {
+                if (memcmp(header->magic, s_ObjectMagic, 4) != 0 ||
+                    header->version != s_ObjectVersion ||
+                    header->payloadSize > object->GetSize() - s_HeaderSize)
+                {
+                    spdlog::warn("Invalid shared asset object: \'{}\'", name);
+                    return nullptr;
+                }
+                return object;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // The publisher probably died, the object stays unusable until it is removed
+    spdlog::warn("Shared asset object \'{}\' is not ready, loading privately", name);
+    return nullptr;
+#else
+    return nullptr;
+#endif
+}
+
+std::shared_ptr<const MappedFile> SharedAssetStore::Publish(const std::string& name,
+                                                            std::size_t        size,
+                                                            const Writer&      writer)
+{
+#ifdef FORKER_HAS_SHM
+    if (name.empty()) return nullptr;
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0)
+    {
+        if (errno == EEXIST) return Attach(name);  // lost the race
+        spdlog::warn("shm_open failed for \'{}\': {}", name, strerror(errno));
+        return nullptr;
+    }
+
+    std::size_t total = s_HeaderSize + size;
+    void*       addr = MAP_FAILED;
+    if (ftruncate(fd, (off_t)total) == 0)
+    {
+        addr = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+
+    if (addr == MAP_FAILED)
+    {
+        shm_unlink(name.c_str());
+        spdlog::warn("Failed to create shared asset object \'{}\'", name);
+        return nullptr;
+    }
+
+    std::uint8_t* data = static_cast<std::uint8_t*>(addr);
+    if (!writer(data + s_HeaderSize, size))
+    {
+        munmap(addr, total);
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+
+    auto* header = reinterpret_cast<SharedObjectHeader*>(data);
+    memcpy(header->magic, s_ObjectMagic, 4);
+    header->version = s_ObjectVersion;
+    header->payloadSize = size;
+    __atomic_store_n(&header->ready, 1u, __ATOMIC_RELEASE);
+    munmap(addr, total);
+
+    // Everyone, including the publisher, reads the object through the same mapping
+    return Attach(name);
+#else
+    return nullptr;
+#endif
+}
+
+const std::uint8_t* SharedAssetStore::GetPayload(const MappedFile& object)
+{
+    return object.GetData() + s_HeaderSize;
+}
+
+std::size_t SharedAssetStore::GetPayloadSize(const MappedFile& object)
+{
+    return reinterpret_cast<const SharedObjectHeader*>(object.GetData())->payloadSize;
+}
@@ -0,0 +1,39 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#pragma once
+
+class MappedFile;
+
+// Decoded assets shared by all renderer processes on one host. Every asset is a POSIX
+// shared memory object named after its source file (path, size, mtime) and the load
+// options. The first process to load an asset publishes it, later processes map the
+// same pages read-only, so host memory grows with unique assets, not processes.
+//
+// Objects outlive the processes (until reboot or 'rm /dev/shm/fkr-*' on Linux), which
+// also makes later runs start warm.
+//
+// Layout: [Header (64 bytes)] [payload]
+class SharedAssetStore
+{
+public:
+    // Fills 'size' bytes of payload, returns false to abandon publishing
+    using Writer = std::function<bool(std::uint8_t* payload, std::size_t size)>;
+
+    // "" if the source file does not exist or shared memory is not supported
+    static std::string MakeName(const std::string& filename, const std::string& options);
+
+    // nullptr if the asset was not published. Waits for an object that is still being
+    // written by another process.
+    static std::shared_ptr<const MappedFile> Attach(const std::string& name);
+
+    // Creates, fills and attaches the object. If another process published it first,
+    // that object is attached instead. nullptr on failure (load privately then).
+    static std::shared_ptr<const MappedFile> Publish(const std::string& name,
+                                                     std::size_t        size,
+                                                     const Writer&      writer);
+
+    static const std::uint8_t* GetPayload(const MappedFile& object);
+    static std::size_t         GetPayloadSize(const MappedFile& object);
+};
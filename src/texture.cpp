@@ -0,0 +1,825 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#include "texture.h"
+
+#include <spdlog/spdlog.h>
+
+#include "utility.h"
+#include "virtualtexture.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define FORKER_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+// table[i] = (i / 255)^gamma
+static std::array<Float, 256> makeDecodeTable(Float gamma)
+{
+    std::array<Float, 256> table;
+    for (int i = 0; i < 256; ++i)
+        table[i] = std::pow(i * (1.f / 255.f), gamma);
+    return table;
+}
+
+// table[i] = (i / 255) * 2 - 1
+static std::array<Float, 256> makeSignedTable()
+{
+    std::array<Float, 256> table = makeDecodeTable(1.f);
+    for (Float& value : table)
+        value = value * 2.f - 1.f;
+    return table;
+}
+
+const std::array<Float, 256> Texture::s_UnitTable = makeDecodeTable(1.f);
+const std::array<Float, 256> Texture::s_LinearTable = makeDecodeTable(Gamma);
+const std::array<Float, 256> Texture::s_SignedTable = makeSignedTable();
+
+// 2x2 box filter, odd edges reuse the last row / column
+static TGAImage downsample(const TGAImage& image)
+{
+    int      width = image.GetWidth(), height = image.GetHeight();
+    int      bytespp = image.GetBytespp();
+    int      halfWidth = Max(1, width / 2), halfHeight = Max(1, height / 2);
+    TGAImage half(halfWidth, halfHeight, bytespp);
+
+    const std::uint8_t* src = image.Buffer();
+    std::uint8_t*       dst = half.Buffer();
+    for (int y = 0; y < halfHeight; ++y)
+    {
+        const std::uint8_t* row0 = src + Min(2 * y, height - 1) * width * bytespp;
+        const std::uint8_t* row1 = src + Min(2 * y + 1, height - 1) * width * bytespp;
+        for (int x = 0; x < halfWidth; ++x)
+        {
+            int x0 = Min(2 * x, width - 1) * bytespp;
+            int x1 = Min(2 * x + 1, width - 1) * bytespp;
+            for (int c = 0; c < bytespp; ++c)
+            {
+                int sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+                *dst++ = (std::uint8_t)((sum + 2) >> 2);
+            }
+        }
+    }
+    return half;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+// Block Compression
+// Texels of a block are in tile order (row by row). Encoding takes the endpoints at the
+// ends of the block's principal color axis (BC1) or its value range (BC4), and every
+// texel the nearest palette entry. Decoding computes the one palette entry a texel uses.
+
+static inline int expand5(int v)
+{
+    return (v << 3) | (v >> 2);
+}
+
+static inline int expand6(int v)
+{
+    return (v << 2) | (v >> 4);
+}
+
+static inline std::uint16_t packRGB565(const std::uint8_t* rgb)
+{
+    int r = (rgb[0] * 31 + 127) / 255;
+    int g = (rgb[1] * 63 + 127) / 255;
+    int b = (rgb[2] * 31 + 127) / 255;
+    return (std::uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static inline void unpackRGB565(int c, int rgb[3])
+{
+    rgb[0] = expand5(c >> 11);
+    rgb[1] = expand6((c >> 5) & 63);
+    rgb[2] = expand5(c & 31);
+}
+
+// c0 > c1: four colors (two interpolated), otherwise three and black
+static inline int getBC1Entry(int e0, int e1, int index, bool fourColors)
+{
+    switch (index)
+    {
+        case 0: return e0;
+        case 1: return e1;
+        case 2: return fourColors ? (2 * e0 + e1 + 1) / 3 : (e0 + e1 + 1) / 2;
+        default: return fourColors ? (e0 + 2 * e1 + 1) / 3 : 0;
+    }
+}
+
+// r0 > r1: eight values (six interpolated), otherwise six and 0, 255
+static inline int getBC4Entry(int r0, int r1, int index)
+{
+    if (index < 2) return index == 0 ? r0 : r1;
+    if (r0 > r1) return ((8 - index) * r0 + (index - 1) * r1 + 3) / 7;
+    if (index < 6) return ((6 - index) * r0 + (index - 1) * r1 + 2) / 5;
+    return index == 6 ? 0 : 255;
+}
+
+static inline void decodeBC1(const std::uint8_t* block, int i, std::uint8_t rgb[3])
+{
+    int c0 = block[0] | (block[1] << 8);
+    int c1 = block[2] | (block[3] << 8);
+    int index = (block[4 + (i >> 2)] >> ((i & 3) * 2)) & 3;
+
+    int e0[3], e1[3];
+    unpackRGB565(c0, e0);
+    unpackRGB565(c1, e1);
+    for (int c = 0; c < 3; ++c)
+        rgb[c] = (std::uint8_t)getBC1Entry(e0[c], e1[c], index, c0 > c1);
+}
+
+static inline int decodeBC4(const std::uint8_t* block, int i)
+{
+    // 3-bit indices after the endpoints, an index may span two bytes
+    int bit = 3 * i;
+    int bits = block[2 + (bit >> 3)];
+    if ((bit & 7) > 5) bits |= block[3 + (bit >> 3)] << 8;
+    return getBC4Entry(block[0], block[1], (bits >> (bit & 7)) & 7);
+}
+
+static void encodeBC1(const std::uint8_t texels[16][3], std::uint8_t* block)
+{
+    Float mean[3] = { 0.f, 0.f, 0.f };
+    for (int i = 0; i < 16; ++i)
+        for (int c = 0; c < 3; ++c)
+            mean[c] += texels[i][c] * (1.f / 16.f);
+
+    // Covariance (xx, xy, xz, yy, yz, zz), principal axis by power iteration
+    Float cov[6] = { 0.f, 0.f, 0.f, 0.f, 0.f, 0.f };
+    for (int i = 0; i < 16; ++i)
+    {
+        Float d[3] = { texels[i][0] - mean[0], texels[i][1] - mean[1],
+                       texels[i][2] - mean[2] };
+        cov[0] += d[0] * d[0];
+        cov[1] += d[0] * d[1];
+        cov[2] += d[0] * d[2];
+        cov[3] += d[1] * d[1];
+        cov[4] += d[1] * d[2];
+        cov[5] += d[2] * d[2];
+    }
+    Float axis[3] = { 1.f, 1.f, 1.f };
+    for (int iteration = 0; iteration < 4; ++iteration)
+    {
+        Float next[3] = { cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2],
+                          cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2],
+                          cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2] };
+        Float length = Max(std::abs(next[0]), Max(std::abs(next[1]), std::abs(next[2])));
+        if (length <= 0.f) break;  // one color
+        for (int c = 0; c < 3; ++c)
+            axis[c] = next[c] / length;
+    }
+
+    int   minIdx = 0, maxIdx = 0;
+    Float minT = FLT_MAX, maxT = -FLT_MAX;
+    for (int i = 0; i < 16; ++i)
+    {
+        Float t =
+            texels[i][0] * axis[0] + texels[i][1] * axis[1] + texels[i][2] * axis[2];
+        if (t < minT) minT = t, minIdx = i;
+        if (t > maxT) maxT = t, maxIdx = i;
+    }
+
+    std::uint16_t c0 = packRGB565(texels[maxIdx]);
+    std::uint16_t c1 = packRGB565(texels[minIdx]);
+    if (c0 < c1) std::swap(c0, c1);
+    block[0] = c0 & 0xFF;
+    block[1] = c0 >> 8;
+    block[2] = c1 & 0xFF;
+    block[3] = c1 >> 8;
+    memset(block + 4, 0, 4);
+    if (c0 == c1) return;  // every texel takes entry 0
+
+    int e0[3], e1[3], palette[4][3];
+    unpackRGB565(c0, e0);
+    unpackRGB565(c1, e1);
+    for (int index = 0; index < 4; ++index)
+        for (int c = 0; c < 3; ++c)
+            palette[index][c] = getBC1Entry(e0[c], e1[c], index, true);
+
+    for (int i = 0; i < 16; ++i)
+    {
+        int best = 0, bestDistance = INT_MAX;
+        for (int index = 0; index < 4; ++index)
+        {
+            int distance = 0;
+            for (int c = 0; c < 3; ++c)
+            {
+                int d = palette[index][c] - texels[i][c];
+                distance += d * d;
+            }
+            if (distance < bestDistance) best = index, bestDistance = distance;
+        }
+        block[4 + (i >> 2)] |= best << ((i & 3) * 2);
+    }
+}
+
+static void encodeBC4(const std::uint8_t values[16], std::uint8_t* block)
+{
+    int lo = 255, hi = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        lo = Min(lo, (int)values[i]);
+        hi = Max(hi, (int)values[i]);
+    }
+    block[0] = (std::uint8_t)hi;
+    block[1] = (std::uint8_t)lo;
+    memset(block + 2, 0, 6);
+    if (hi == lo) return;  // every texel takes entry 0
+
+    std::uint64_t bits = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        int best = 0, bestDistance = INT_MAX;
+        for (int index = 0; index < 8; ++index)
+        {
+            int distance = std::abs(getBC4Entry(hi, lo, index) - values[i]);
+            if (distance < bestDistance) best = index, bestDistance = distance;
+        }
+        bits |= (std::uint64_t)best << (3 * i);
+    }
+    for (int b = 0; b < 6; ++b)
+        block[2 + b] = (std::uint8_t)(bits >> (8 * b));
+}
+
+// BGR(A) or grayscale texel
+template <int Bytespp>
+static inline Color3 decodeTexel(const std::uint8_t* texel, const Float* table)
+{
+    if (Bytespp == 1) return Color3(0, 0, table[texel[0]]);
+    return Color3(table[texel[2]], table[texel[1]], table[texel[0]]);
+}
+
+#ifdef FORKER_HAS_SSE2
+// BGR(A) bytes of a texel in the low 32 bits
+template <int Bytespp>
+static inline __m128i loadTexel(const std::uint8_t* texel)
+{
+    std::uint32_t bytes = 0;
+    memcpy(&bytes, texel, Bytespp);  // 3-byte texels may end the level
+    return _mm_cvtsi32_si128((int)bytes);
+}
+#endif
+
+// Bilinear blend of a 2x2 footprint (top left, top right, bottom left, bottom right)
+// with 8-bit fixed-point weights that sum to 256, converted to [0, 1] only at the end.
+// Removing the weights first (exact) keeps a uniform footprint equal to its texel in
+// s_UnitTable.
+template <int Bytespp>
+static inline Color3 blendTexels(const std::uint8_t* const texels[4], Float tx, Float ty)
+{
+    int fx = (int)(tx * 256.f + 0.5f), fy = (int)(ty * 256.f + 0.5f);
+    int w1 = (fx * (256 - fy)) >> 8, w2 = ((256 - fx) * fy) >> 8, w3 = (fx * fy) >> 8;
+    int w0 = 256 - w1 - w2 - w3;
+
+    if (Bytespp == 1)
+    {
+        int v = w0 * texels[0][0] + w1 * texels[1][0] + w2 * texels[2][0] +
+                w3 * texels[3][0];
+        return Color3(0, 0, v * (1.f / 256.f) * (1.f / 255.f));
+    }
+
+#ifdef FORKER_HAS_SSE2
+    // Channels of two texels interleaved as 16-bit pairs, one madd weighs both
+    __m128i zero = _mm_setzero_si128();
+    __m128i top =
+        _mm_unpacklo_epi16(_mm_unpacklo_epi8(loadTexel<Bytespp>(texels[0]), zero),
+                           _mm_unpacklo_epi8(loadTexel<Bytespp>(texels[1]), zero));
+    __m128i bottom =
+        _mm_unpacklo_epi16(_mm_unpacklo_epi8(loadTexel<Bytespp>(texels[2]), zero),
+                           _mm_unpacklo_epi8(loadTexel<Bytespp>(texels[3]), zero));
+    __m128i sum = _mm_add_epi32(_mm_madd_epi16(top, _mm_set1_epi32((w1 << 16) | w0)),
+                                _mm_madd_epi16(bottom, _mm_set1_epi32((w3 << 16) | w2)));
+
+    alignas(16) float bgr[4];
+    __m128 unit = _mm_mul_ps(_mm_cvtepi32_ps(sum), _mm_set1_ps(1.f / 256.f));
+    _mm_store_ps(bgr, _mm_mul_ps(unit, _mm_set1_ps(1.f / 255.f)));
+    return Color3(bgr[2], bgr[1], bgr[0]);
+#else
+    Float bgr[3];
+    for (int c = 0; c < 3; ++c)
+    {
+        int v = w0 * texels[0][c] + w1 * texels[1][c] + w2 * texels[2][c] +
+                w3 * texels[3][c];
+        bgr[c] = v * (1.f / 256.f) * (1.f / 255.f);
+    }
+    return Color3(bgr[2], bgr[1], bgr[0]);
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+Texture::Texture(const TGAImage& img, WrapMode wrap, FilterMode filter)
+    : m_Width(img.GetWidth()),
+      m_Height(img.GetHeight()),
+      m_Bytespp(img.GetBytespp()),
+      m_Format(Format::Uncompressed),
+      m_WrapMode(wrap),
+      m_FilterMode(filter),
+      m_Loader(nullptr),
+      m_Loaded(true)
+{
+    std::vector<TGAImage> chain;
+    if (IsMipmapped(filter)) chain = MakeMipChain(img);
+
+    std::vector<const TGAImage*> images = { &img };
+    for (const TGAImage& mip : chain)
+        images.push_back(&mip);
+
+    // All levels in one buffer, each starting on a cache line
+    std::vector<std::size_t> offsets;
+    std::size_t              size = 0;
+    for (const TGAImage* image : images)
+    {
+        offsets.push_back(size);
+        size += GetTiledSize(image->GetWidth(), image->GetHeight(), m_Bytespp);
+        size = (size + 63) & ~(std::size_t)63;
+    }
+
+    m_Texels.resize(size);
+    for (std::size_t i = 0; i < images.size(); ++i)
+    {
+        TileImage(*images[i], m_Texels.data() + offsets[i]);
+        m_Levels.push_back(Level{ m_Texels.data() + offsets[i], images[i]->GetWidth(),
+                                  images[i]->GetHeight() });
+    }
+    selectSampler();
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+std::vector<TGAImage> Texture::MakeMipChain(const TGAImage& image)
+{
+    std::vector<TGAImage> chain;
+    const TGAImage*       last = &image;
+    while (last->GetWidth() > 1 || last->GetHeight() > 1)
+    {
+        chain.push_back(downsample(*last));
+        last = &chain.back();
+    }
+    return chain;
+}
+
+std::size_t Texture::GetTiledSize(int width, int height, int bytespp)
+{
+    std::size_t tilesPerRow = (width + s_TileSize - 1) >> s_TileShift;
+    std::size_t tileRows = (height + s_TileSize - 1) >> s_TileShift;
+    return tilesPerRow * tileRows * s_TileSize * s_TileSize * bytespp;
+}
+
+// Copies each row segment of s_TileSize texels into its tile (padding stays zero)
+void Texture::TileImage(const TGAImage& image, std::uint8_t* dst)
+{
+    int                 width = image.GetWidth(), height = image.GetHeight();
+    int                 bytespp = image.GetBytespp();
+    int                 tilesPerRow = (width + s_TileSize - 1) >> s_TileShift;
+    std::size_t         tileBytes = s_TileSize * s_TileSize * bytespp;
+    const std::uint8_t* src = image.Buffer();
+
+    memset(dst, 0, GetTiledSize(width, height, bytespp));
+    for (int y = 0; y < height; ++y)
+    {
+        const std::uint8_t* row = src + (std::size_t)y * width * bytespp;
+        std::uint8_t*       tileRow = dst + (y >> s_TileShift) * tilesPerRow * tileBytes +
+                                (y & s_TileMask) * s_TileSize * bytespp;
+        for (int x = 0; x < width; x += s_TileSize)
+        {
+            int count = Min(s_TileSize, width - x);
+            memcpy(tileRow + (x >> s_TileShift) * tileBytes, row + x * bytespp,
+                   count * bytespp);
+        }
+    }
+}
+
+std::size_t Texture::GetPageBytes(int bytespp)
+{
+    return (std::size_t)s_PageSize * s_PageSize * bytespp;
+}
+
+// Tile rows of the page are contiguous runs of tiles in the level
+void Texture::CopyPage(const Level& level, int bytespp, int pageX, int pageY,
+                       std::uint8_t* dst)
+{
+    const int   tilesPerPage = s_PageSize >> s_TileShift;  // per row
+    int         tilesPerRow = (level.width + s_TileSize - 1) >> s_TileShift;
+    int         tileRows = (level.height + s_TileSize - 1) >> s_TileShift;
+    std::size_t tileBytes = s_TileSize * s_TileSize * bytespp;
+
+    int tileX = pageX * tilesPerPage;
+    int count = Min(tilesPerPage, tilesPerRow - tileX);
+    memset(dst, 0, GetPageBytes(bytespp));
+    for (int row = 0; row < tilesPerPage; ++row)
+    {
+        int tileY = pageY * tilesPerPage + row;
+        if (tileY >= tileRows) break;
+        memcpy(dst + row * tilesPerPage * tileBytes,
+               level.data + ((std::size_t)tileY * tilesPerRow + tileX) * tileBytes,
+               count * tileBytes);
+    }
+}
+
+void Texture::RecordFeedback(const Vector2f& coord, Float lod) const
+{
+    if (!m_Virtual) return;
+
+    Vector2f uv;
+    switch (m_WrapMode)
+    {
+        case Repeat: uv = wrapCoord<Repeat>(coord); break;
+        case MirroredRepeat: uv = wrapCoord<MirroredRepeat>(coord); break;
+        case ClampToEdge: uv = wrapCoord<ClampToEdge>(coord); break;
+        default: uv = coord; break;
+    }
+
+    // Levels and texel footprint of sample()
+    int maxLevel = (int)m_Levels.size() - 1;
+    int first = 0, last = 0;
+    if (IsMipmapped(m_FilterMode) && maxLevel > 0)
+    {
+        Float level = lod + m_LodBias;
+        if (level >= maxLevel)
+            first = last = maxLevel;
+        else if (level > 0.f && m_FilterMode == NearestMipmap)
+            first = last = (int)(level + 0.5f);
+        else if (level > 0.f)
+            first = (int)level, last = first + 1;
+    }
+    bool bilinear = (m_FilterMode == Linear || m_FilterMode == Trilinear);
+
+    for (int l = first; l <= last; ++l)
+    {
+        const Level& level = m_Levels[l];
+        Float        w = level.width - 0.001, h = level.height - 0.001;
+        Vector2f     p = Vector2f(uv.u * w, uv.v * h);
+        int          x0 = std::floor(bilinear ? p.x - 0.5f : p.x);
+        int          y0 = std::floor(bilinear ? p.y - 0.5f : p.y);
+        int          x1 = bilinear ? x0 + 1 : x0, y1 = bilinear ? y0 + 1 : y0;
+        x0 = Clamp(x0, 0, level.width - 1) >> s_PageShift;
+        y0 = Clamp(y0, 0, level.height - 1) >> s_PageShift;
+        x1 = Clamp(x1, 0, level.width - 1) >> s_PageShift;
+        y1 = Clamp(y1, 0, level.height - 1) >> s_PageShift;
+
+        int pagesPerRow = (level.width + s_PageSize - 1) >> s_PageShift;
+        for (int py = y0; py <= y1; ++py)
+            for (int px = x0; px <= x1; ++px)
+                m_Virtual->Request(l, py * pagesPerRow + px);
+    }
+}
+
+std::shared_ptr<Texture> Texture::PackChannels(
+    const std::array<std::shared_ptr<const Texture>, 3>& sources,
+    const std::array<int, 3>& channels, WrapMode wrap, FilterMode filter)
+{
+    int width = 1, height = 1;
+    for (const std::shared_ptr<const Texture>& source : sources)
+    {
+        if (!source) continue;
+        source->Prefetch();
+        width = Max(width, source->m_Width);
+        height = Max(height, source->m_Height);
+    }
+
+    TGAImage      image(width, height, TGAImage::RGB);
+    std::uint8_t* dst = image.Buffer();
+    for (int i = 0; i < 3; ++i)
+    {
+        const Texture* source = sources[i].get();
+        if (source && source->m_Virtual) source = source->m_Virtual->GetBacking().get();
+        if (!source || !source->m_Levels[0].data || source->m_Format != Uncompressed)
+            continue;  // stays 0
+
+        // Byte of the channel in a BGR(A) texel, grayscale texels only have B
+        const Level& level = source->m_Levels[0];
+        int          bytespp = source->m_Bytespp;
+        int          offset = (bytespp == TGAImage::GRAYSCALE) ? 0 : 2 - channels[i];
+        if (bytespp == TGAImage::GRAYSCALE && channels[i] != 2) continue;
+
+        std::uint8_t* out = dst + (2 - i);  // channel i of the packed BGR texel
+        for (int y = 0; y < height; ++y)
+        {
+            int sy = (int)((std::int64_t)y * level.height / height);
+            for (int x = 0; x < width; ++x)
+            {
+                int sx = (int)((std::int64_t)x * level.width / width);
+                out[(y * width + x) * 3] =
+                    level.data[getTexelIndex(level, sx, sy) * bytespp + offset];
+            }
+        }
+    }
+    return std::make_shared<Texture>(image, wrap, filter);
+}
+
+std::shared_ptr<Texture> Texture::Compress(const Texture& source, Format format,
+                                           int channel)
+{
+    source.Prefetch();
+    if (format == Format::Uncompressed || source.m_Format != Format::Uncompressed ||
+        !source.m_Levels[0].data)
+        return nullptr;
+
+    // One block per tile, levels start on a cache line as uncompressed ones
+    const std::vector<Level>& sourceLevels = source.m_Levels;
+    int                       blockSize = GetBlockSize(format);
+    std::vector<std::size_t>  offsets;
+    std::size_t               size = 0;
+    for (const Level& level : sourceLevels)
+    {
+        offsets.push_back(size);
+        size += GetTiledSize(level.width, level.height, 1) /
+                (s_TileSize * s_TileSize) * blockSize;
+        size = (size + 63) & ~(std::size_t)63;
+    }
+
+    std::vector<std::uint8_t> blocks(size);
+    std::vector<Level>        levels;
+    int                       bytespp = source.m_Bytespp;
+    for (std::size_t l = 0; l < sourceLevels.size(); ++l)
+    {
+        const Level&  level = sourceLevels[l];
+        std::uint8_t* dst = blocks.data() + offsets[l];
+        for (int ty = 0; ty < level.height; ty += s_TileSize)
+        {
+            for (int tx = 0; tx < level.width; tx += s_TileSize, dst += blockSize)
+            {
+                // RGB of the tile (grayscale in B), the edge texels repeat past the edge
+                std::uint8_t rgb[16][3];
+                std::uint8_t values[2][16];
+                for (int i = 0; i < 16; ++i)
+                {
+                    int x = Min(tx + (i & s_TileMask), level.width - 1);
+                    int y = Min(ty + (i >> s_TileShift), level.height - 1);
+                    const std::uint8_t* texel =
+                        level.data + getTexelIndex(level, x, y) * bytespp;
+                    rgb[i][0] = bytespp == TGAImage::GRAYSCALE ? 0 : texel[2];
+                    rgb[i][1] = bytespp == TGAImage::GRAYSCALE ? 0 : texel[1];
+                    rgb[i][2] = texel[0];
+                    values[0][i] = rgb[i][format == Format::BC4 ? channel : 0];
+                    values[1][i] = rgb[i][1];
+                }
+
+                if (format == Format::BC1)
+                {
+                    encodeBC1(rgb, dst);
+                }
+                else
+                {
+                    encodeBC4(values[0], dst);
+                    if (format == Format::BC5) encodeBC4(values[1], dst + 8);
+                }
+            }
+        }
+        levels.push_back(Level{ blocks.data() + offsets[l], level.width, level.height });
+    }
+    return std::make_shared<Texture>(format, std::move(blocks), std::move(levels),
+                                     source.m_WrapMode, source.m_FilterMode);
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+// Specialized Samplers
+
+// Samplers of one wrap and filter mode, by texel size (2 bytes is not supported), then
+// by block format, then paged by texel size
+#define FORKER_TEXTURE_SAMPLERS(wrap, filter)                                      \
+    {                                                                              \
+        &sample<wrap, filter, Uncompressed, 1>, nullptr,                           \
+            &sample<wrap, filter, Uncompressed, 3>,                                \
+            &sample<wrap, filter, Uncompressed, 4>, &sample<wrap, filter, BC1, 0>, \
+            &sample<wrap, filter, BC4, 0>, &sample<wrap, filter, BC5, 0>,          \
+            &sample<wrap, filter, Paged, 1>, nullptr,                              \
+            &sample<wrap, filter, Paged, 3>, &sample<wrap, filter, Paged, 4>       \
+    }
+
+#define FORKER_TEXTURE_FILTERS(wrap)                                                   \
+    {                                                                                  \
+        FORKER_TEXTURE_SAMPLERS(wrap, Nearest), FORKER_TEXTURE_SAMPLERS(wrap, Linear), \
+            FORKER_TEXTURE_SAMPLERS(wrap, NearestMipmap),                              \
+            FORKER_TEXTURE_SAMPLERS(wrap, Trilinear)                                   \
+    }
+
+void Texture::selectSampler() const
+{
+    // [wrap][filter][bytespp - 1, 3 + block format or 7 + bytespp - 1], in enum order
+    static const Sampler s_Samplers[4][4][11] = {
+        FORKER_TEXTURE_FILTERS(NoWrap), FORKER_TEXTURE_FILTERS(Repeat),
+        FORKER_TEXTURE_FILTERS(MirroredRepeat), FORKER_TEXTURE_FILTERS(ClampToEdge)
+    };
+
+    m_LodBias = 0.5f * std::log2((Float)m_Width * m_Height);
+    m_Sampler = &sampleMissing;
+    if (!m_Levels[0].data && !m_Levels[0].pages) return;
+    bool bytewise = (m_Format == Uncompressed || m_Format == Paged);
+    if (bytewise && (m_Bytespp < 1 || m_Bytespp > 4)) return;
+
+    int texelIdx = m_Bytespp - 1;
+    if (m_Format == Paged)
+        texelIdx += 7;
+    else if (m_Format != Uncompressed)
+        texelIdx = 3 + m_Format;
+    if (Sampler sampler = s_Samplers[m_WrapMode][m_FilterMode][texelIdx])
+        m_Sampler = sampler;
+}
+
+#undef FORKER_TEXTURE_FILTERS
+#undef FORKER_TEXTURE_SAMPLERS
+
+// Texels could not be loaded
+Color3 Texture::sampleMissing(const Texture& texture, const Vector2f& coord, Float lod,
+                              const Float* table)
+{
+    return Color3(0.f);
+}
+
+template <Texture::WrapMode Wrap, Texture::FilterMode Filter, Texture::Format Fmt,
+          int Bytespp>
+Color3 Texture::sample(const Texture& texture, const Vector2f& coord, Float lod,
+                       const Float* table)
+{
+    Vector2f     uv = wrapCoord<Wrap>(coord);
+    const Level* levels = texture.m_Levels.data();
+    if (Filter == Nearest) return nearest<Wrap, Fmt, Bytespp>(levels[0], uv, table);
+    if (Filter == Linear) return bilinear<Wrap, Fmt, Bytespp>(levels[0], uv, table);
+
+    // Level of this texture: the footprint of a pixel in its level 0 texels
+    int   maxLevel = (int)texture.m_Levels.size() - 1;
+    Float level = lod + texture.m_LodBias;
+    int   levelIdx = -1;  // single level to sample
+    if (level <= 0.f || maxLevel == 0)  // magnified
+        levelIdx = 0;
+    else if (level >= maxLevel)
+        levelIdx = maxLevel;
+    else if (Filter == NearestMipmap)
+        levelIdx = (int)(level + 0.5f);
+
+    if (levelIdx >= 0)
+    {
+        const Level& single = levels[levelIdx];
+        return Filter == Trilinear ? bilinear<Wrap, Fmt, Bytespp>(single, uv, table)
+                                   : nearest<Wrap, Fmt, Bytespp>(single, uv, table);
+    }
+
+    int   level0 = (int)level;
+    Float t = level - level0;
+    return Lerp(t, bilinear<Wrap, Fmt, Bytespp>(levels[level0], uv, table),
+                bilinear<Wrap, Fmt, Bytespp>(levels[level0 + 1], uv, table));
+}
+
+template <Texture::WrapMode Wrap>
+inline Vector2f Texture::wrapCoord(const Vector2f& coord)
+{
+    if (Wrap == Repeat)
+    {
+        return Vector2f(coord.x - std::floor(coord.x), coord.y - std::floor(coord.y));
+    }
+    else if (Wrap == MirroredRepeat)
+    {
+        int      xi = std::floor(coord.x), yi = std::floor(coord.y);
+        Vector2f repeat = Vector2f(coord.x - xi, coord.y - yi);
+        return Vector2f(xi % 2 == 0 ? repeat.x : 1.f - repeat.x,
+                        yi % 2 == 0 ? repeat.y : 1.f - repeat.y);
+    }
+    else if (Wrap == ClampToEdge)
+    {
+        return Clamp01(coord);
+    }
+    else  // No Wrap (Default)
+    {
+        return coord;  // fetch() returns black outside of the image
+    }
+}
+
+template <Texture::WrapMode Wrap, Texture::Format Fmt, int Bytespp>
+inline Color3 Texture::nearest(const Level& level, const Vector2f& coord,
+                               const Float* table)
+{
+    Float    w = level.width - 0.001, h = level.height - 0.001;
+    Vector2i imageUV = Vector2i(std::floor(coord.u * w), std::floor(coord.v * h));
+    return fetch<Wrap, Fmt, Bytespp>(level, imageUV, table);
+}
+
+template <Texture::WrapMode Wrap, Texture::Format Fmt, int Bytespp>
+inline Color3 Texture::bilinear(const Level& level, const Vector2f& coord,
+                                const Float* table)
+{
+    Float w = level.width - 0.001, h = level.height - 0.001;
+
+    // Point in image space (not truncated)
+    Vector2f p = Vector2f(coord.u * w, coord.v * h);
+
+    // Find the top-left pixel in the sample region
+    Vector2f topLeft = Vector2f(std::floor(p.x - 0.5f), std::floor(p.y - 0.5f));
+
+    // Bilinear Interpolation
+    Float tx = p.x - (topLeft.x + 0.5f);  // sample point is at center (+ 0.5f)
+    Float ty = p.y - (topLeft.y + 0.5f);
+
+    // Sample Points
+    int x0 = topLeft.x, y0 = topLeft.y;
+    int x1 = x0 + 1, y1 = y0 + 1;
+
+    // Texels read as stored (or remapped to [-1, 1], which commutes with the weights)
+    // are blended in fixed point. sRGB texels are decoded to linear before filtering, so
+    // they take the float path.
+    bool remapped = (table == s_SignedTable.data());
+    bool bytewise = (Fmt == Uncompressed || Fmt == Paged);
+    if (bytewise && (table == s_UnitTable.data() || remapped))
+    {
+        const std::uint8_t* texels[4] = { getTexel<Wrap, Fmt, Bytespp>(level, x0, y0),
+                                          getTexel<Wrap, Fmt, Bytespp>(level, x1, y0),
+                                          getTexel<Wrap, Fmt, Bytespp>(level, x0, y1),
+                                          getTexel<Wrap, Fmt, Bytespp>(level, x1, y1) };
+        Color3 color = blendTexels<Bytespp>(texels, tx, ty);
+        return remapped ? color * 2.f - Color3(1.f) : color;
+    }
+
+    Color3 c0 = fetch<Wrap, Fmt, Bytespp>(level, Vector2i(x0, y0), table);
+    Color3 c1 = fetch<Wrap, Fmt, Bytespp>(level, Vector2i(x1, y0), table);
+    Color3 c2 = fetch<Wrap, Fmt, Bytespp>(level, Vector2i(x0, y1), table);
+    Color3 c3 = fetch<Wrap, Fmt, Bytespp>(level, Vector2i(x1, y1), table);
+
+    Color3 cx1 = Lerp(tx, c0, c1);  // Horizontal Interpolation
+    Color3 cx2 = Lerp(tx, c2, c3);
+    return Lerp(ty, cx1, cx2);  // Vertical Interpolation
+}
+
+// Texel decoded through table. NoWrap returns black outside of the image (as
+// TGAImage::Get), other modes clamp to the edge texels. Block formats decode the texel
+// from its block, paged levels read it from its page.
+template <Texture::WrapMode Wrap, Texture::Format Fmt, int Bytespp>
+inline Color3 Texture::fetch(const Level& level, const Vector2i& imageUV,
+                             const Float* table)
+{
+    if (Fmt == Uncompressed || Fmt == Paged)
+    {
+        return decodeTexel<Bytespp>(
+            getTexel<Wrap, Fmt, Bytespp>(level, imageUV.u, imageUV.v), table);
+    }
+
+    int x = imageUV.u, y = imageUV.v;
+    if (Wrap == NoWrap)
+    {
+        if (x < 0 || y < 0 || x >= level.width || y >= level.height) return Color3(0.f);
+    }
+    else
+    {
+        x = Clamp(x, 0, level.width - 1);
+        y = Clamp(y, 0, level.height - 1);
+    }
+
+    int index = getTexelIndex(level, x, y);
+
+    // Block of the tile, texel i inside it
+    int                 tile = index >> (2 * s_TileShift);
+    int                 i = index & (s_TileSize * s_TileSize - 1);
+    const std::uint8_t* block = level.data + tile * GetBlockSize(Fmt);
+    if (Fmt == BC1)
+    {
+        std::uint8_t rgb[3];
+        decodeBC1(block, i, rgb);
+        return Color3(table[rgb[0]], table[rgb[1]], table[rgb[2]]);
+    }
+    if (Fmt == BC4) return Color3(0, 0, table[decodeBC4(block, i)]);
+
+    // BC5: unit normal with Z >= 0 (tangent space), remapped unless read as a normal
+    int   r = decodeBC4(block, i), g = decodeBC4(block + 8, i);
+    Float nx = s_SignedTable[r], ny = s_SignedTable[g];
+    Float nz = std::sqrt(Max(0.f, 1.f - nx * nx - ny * ny));
+    if (table == s_SignedTable.data()) return Color3(nx, ny, nz);
+    return Color3(table[r], table[g], nz * 0.5f + 0.5f);
+}
+
+// Bytes of an uncompressed or paged texel, wrapped as in fetch() (zero bytes outside of
+// the image for NoWrap)
+template <Texture::WrapMode Wrap, Texture::Format Fmt, int Bytespp>
+inline const std::uint8_t* Texture::getTexel(const Level& level, int x, int y)
+{
+    static const std::uint8_t s_Black[4] = { 0, 0, 0, 0 };
+    if (Wrap == NoWrap)
+    {
+        if (x < 0 || y < 0 || x >= level.width || y >= level.height) return s_Black;
+    }
+    else
+    {
+        x = Clamp(x, 0, level.width - 1);
+        y = Clamp(y, 0, level.height - 1);
+    }
+
+    if (Fmt == Paged)
+    {
+        // A page that is not resident reads the coarser levels (the last one is)
+        for (const Level* l = &level;; ++l)
+        {
+            int pagesPerRow = (l->width + s_PageSize - 1) >> s_PageShift;
+            const std::uint8_t* page =
+                l->pages[(y >> s_PageShift) * pagesPerRow + (x >> s_PageShift)];
+            if (page)
+            {
+                int inPage = getTexelIndex(s_PageSize, x & (s_PageSize - 1),
+                                           y & (s_PageSize - 1));
+                return page + inPage * Bytespp;
+            }
+            x = Min(x >> 1, l[1].width - 1);
+            y = Min(y >> 1, l[1].height - 1);
+        }
+    }
+    return level.data + getTexelIndex(level, x, y) * Bytespp;
+}
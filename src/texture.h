@@ -8,6 +8,9 @@
 #include "geometry.h"
 #include "tgaimage.h"
 
+class MappedFile;
+class VirtualTexture;
+
 class Texture
 {
 public:
@@ -22,125 +25,305 @@ public:
     enum FilterMode
     {
         Nearest,
-        Linear  // Bilinear
+        Linear,         // Bilinear
+        NearestMipmap,  // nearest texel of the nearest mip level
+        Trilinear       // bilinear in the two nearest mip levels, blended
+    };
+
+    // Texel storage of the levels. Block formats store each 4x4 tile as one block, in
+    // tile order, and decode single texels on fetch (see Compress).
+    enum Format
+    {
+        Uncompressed,  // m_Bytespp bytes per texel
+        BC1,           // RGB, two 5:6:5 endpoints and 2-bit indices, 8 bytes per block
+        BC4,           // one channel, two 8-bit endpoints and 3-bit indices, 8 bytes
+        BC5,           // two BC4 blocks (normal X and Y, Z rebuilt), 16 bytes
+        Paged          // m_Bytespp bytes per texel in resident pages (VirtualTexture)
     };
 
+    enum LoadMode
+    {
+        Eager,     // decode while loading the model
+        Deferred,  // decode on first sample or prefetch
+        Virtual    // page in what visible pixels sample from the texture cache
+    };
+
+    // Produces the texels on first use, the returned texture's levels are adopted
+    // (nullptr if loading failed)
+    using Loader = std::function<std::shared_ptr<const Texture>()>;
+
+    // Texels of one mip level in 4x4 tiles: tiles row by row, texels row by row inside a
+    // tile, each texel laid out like TGAImage (BGR(A) or grayscale). A bilinear
+    // footprint or a column of samples mostly stays within one or two cache lines.
+    // Levels are padded to whole tiles (GetTiledSize).
+    //
+    // Paged levels have no data but a page table: one entry per 64x64 texels (pages row
+    // by row), each page tiled like a level of that size, nullptr if not resident.
+    struct Level
+    {
+        const std::uint8_t*        data;
+        int                        width;
+        int                        height;
+        const std::uint8_t* const* pages;
+    };
+
+    // Re-lays the image into tiles, mipmapping filters build the mip chain here
     Texture(const TGAImage& img, WrapMode wrap = WrapMode::NoWrap,
+            FilterMode filter = FilterMode::Nearest);
+
+    // Deferred Texture (size is known from the file header, format from the loader)
+    Texture(int width, int height, Loader loader, WrapMode wrap = WrapMode::NoWrap,
+            FilterMode filter = FilterMode::Nearest, Format format = Format::Uncompressed)
+        : m_Width(width),
+          m_Height(height),
+          m_Bytespp(0),
+          m_Format(format),
+          m_WrapMode(wrap),
+          m_FilterMode(filter),
+          m_Loader(std::move(loader)),
+          m_Loaded(false),
+          m_Sampler(nullptr)
+    {
+        m_Levels.push_back(Level{ nullptr, width, height });
+    }
+
+    // Texels inside a mapped file (e.g. a texture cache), levels[0] is the full size
+    Texture(std::shared_ptr<const MappedFile> mapping, std::vector<Level> levels,
+            int bytespp, WrapMode wrap = WrapMode::NoWrap,
             FilterMode filter = FilterMode::Nearest)
-        : m_Width(img.GetWidth()),
-          m_Height(img.GetHeight()),
-          m_Image(img),
+        : m_Width(levels[0].width),
+          m_Height(levels[0].height),
+          m_Levels(std::move(levels)),
+          m_Bytespp(bytespp),
+          m_Format(Format::Uncompressed),
+          m_Mapping(std::move(mapping)),
           m_WrapMode(wrap),
-          m_FilterMode(filter)
+          m_FilterMode(filter),
+          m_Loader(nullptr),
+          m_Loaded(true)
     {
+        selectSampler();
     }
 
-    inline int GetWidth() const { return m_Width; }
-    inline int GetHeight() const { return m_Height; }
+    // Block-compressed texels (see Compress), levels point into blocks
+    Texture(Format format, std::vector<std::uint8_t> blocks, std::vector<Level> levels,
+            WrapMode wrap = WrapMode::NoWrap, FilterMode filter = FilterMode::Nearest)
+        : m_Width(levels[0].width),
+          m_Height(levels[0].height),
+          m_Texels(std::move(blocks)),
+          m_Levels(std::move(levels)),
+          m_Bytespp(0),
+          m_Format(format),
+          m_WrapMode(wrap),
+          m_FilterMode(filter),
+          m_Loader(nullptr),
+          m_Loaded(true)
+    {
+        selectSampler();
+    }
 
-    inline Color3 Sample(const Vector2f& coord) const
+    // Paged texels of a virtual texture, levels[0] is the full size
+    Texture(std::shared_ptr<VirtualTexture> pages, std::vector<Level> levels, int bytespp,
+            WrapMode wrap = WrapMode::NoWrap, FilterMode filter = FilterMode::Nearest)
+        : m_Width(levels[0].width),
+          m_Height(levels[0].height),
+          m_Levels(std::move(levels)),
+          m_Bytespp(bytespp),
+          m_Format(Format::Paged),
+          m_Virtual(std::move(pages)),
+          m_WrapMode(wrap),
+          m_FilterMode(filter),
+          m_Loader(nullptr),
+          m_Loaded(true)
     {
-        Vector2f wrapUV = wrapCoord(coord);
-        return colorFromFiltering(wrapUV) / 255.f;
+        selectSampler();
     }
 
-    inline Float SampleFloat(const Vector2f& coord) const
+    Texture(const Texture& t) = delete;
+
+    static bool IsMipmapped(FilterMode filter)
     {
-        Vector2f wrapUV = wrapCoord(coord);
-        return colorFromFiltering(wrapUV)[2] / 255.f;
+        return filter == FilterMode::NearestMipmap || filter == FilterMode::Trilinear;
     }
 
-private:
-    // Private Data
-    int        m_Width;
-    int        m_Height;
-    TGAImage   m_Image;
-    WrapMode   m_WrapMode;
-    FilterMode m_FilterMode;
-
-    // Texture Wrapping
-    inline Vector2f wrapCoord(const Vector2f& coord) const
-    {
-        if (m_WrapMode == WrapMode::Repeat)
-        {
-            return Vector2f(coord.x - std::floor(coord.x), coord.y - std::floor(coord.y));
-        }
-        else if (m_WrapMode == WrapMode::MirroredRepeat)
-        {
-            int      xi = std::floor(coord.x), yi = std::floor(coord.y);
-            Vector2f repeat = Vector2f(coord.x - xi, coord.y - yi);
-            return Vector2f(xi % 2 == 0 ? repeat.x : 1.f - repeat.x,
-                            yi % 2 == 0 ? repeat.y : 1.f - repeat.y);
-        }
-        else if (m_WrapMode == WrapMode::ClampToEdge)
-        {
-            return Clamp01(coord);
-        }
-        else  // No Wrap (Default)
-        {
-            return coord;  // TGAImage::Get will return a specific color
-        }
+    // Levels 1, 2, ... down to 1x1 (2x2 box filter, odd edges reuse the last texels)
+    static std::vector<TGAImage> MakeMipChain(const TGAImage& image);
+
+    // Tiled Layout (see Level)
+    static std::size_t GetTiledSize(int width, int height, int bytespp);
+    static void        TileImage(const TGAImage& image, std::uint8_t* dst);
+
+    // Channel i of the packed RGB texture is channel channels[i] (0 R, 1 G, 2 B) of
+    // sources[i], 0 where a source is missing or has no texels. Sources are loaded first
+    // and resampled (nearest) to the largest source size.
+    static std::shared_ptr<Texture> PackChannels(
+        const std::array<std::shared_ptr<const Texture>, 3>& sources,
+        const std::array<int, 3>& channels, WrapMode wrap, FilterMode filter);
+
+    // Encodes every level of an uncompressed texture into a block format (loaded first).
+    // BC4 keeps channel (0 R, 1 G, 2 B) and decodes into B like a grayscale texture.
+    // nullptr if the source has no texels.
+    static std::shared_ptr<Texture> Compress(const Texture& source, Format format,
+                                             int channel = 2);
+
+    // Paged Layout (see Level)
+    static const int s_PageShift = 6;  // 64x64 texels
+    static const int s_PageSize = 1 << s_PageShift;
+
+    static std::size_t GetPageBytes(int bytespp);
+    // Copies page (pageX, pageY) of an uncompressed level (texels past the edge are 0)
+    static void CopyPage(const Level& level, int bytespp, int pageX, int pageY,
+                         std::uint8_t* dst);
+
+    static inline int GetBlockSize(Format format)
+    {
+        return format == Format::BC5 ? 16 : (format == Format::Uncompressed ? 0 : 8);
     }
 
-    // Texture Filtering
-    inline Color3 colorFromFiltering(const Vector2f& coord) const
+    // Level of detail of a triangle for a 1x1 texture: log2 of the texture coordinate
+    // footprint of one pixel (see ForkerGL::DrawTriangle)
+    static Float GetTriangleLod(Float texCoordArea, Float screenArea)
     {
-        Float w = m_Width - 0.001, h = m_Height - 0.001;
-        if (m_FilterMode == FilterMode::Linear)
-        {
-            // Point in image space (not truncated)
-            Vector2f p = Vector2f(coord.u * w, coord.v * h);
+        if (texCoordArea <= 0.f || screenArea <= 0.f) return -FLT_MAX;  // magnified
+        return 0.5f * std::log2(texCoordArea / screenArea);
+    }
 
-            // Find the top-left pixel in the sample region
-            Vector2f topLeft = Vector2f(std::floor(p.x - 0.5f), std::floor(p.y - 0.5f));
+    inline int    GetWidth() const { return m_Width; }
+    inline int    GetHeight() const { return m_Height; }
+    inline int    GetNumLevels() const { return (int)m_Levels.size(); }
+    inline Format GetFormat() const { return m_Format; }
+    inline int    GetBytespp() const { return m_Bytespp; }
 
-            // Bilinear Interpolation
-            Float tx = p.x - (topLeft.x + 0.5f);  // sample point is at center (+ 0.5f)
-            Float ty = p.y - (topLeft.y + 0.5f);
+    inline const Level& GetLevel(int index) const { return m_Levels[index]; }
+    inline bool   IsLoaded() const { return m_Loaded.load(std::memory_order_acquire); }
 
-            // Sample Points
-            Vector2i s0 = Vector2i(topLeft.x, topLeft.y);
-            Vector2i s1 = Vector2i(topLeft.x + 1.f, topLeft.y);
-            Vector2i s2 = Vector2i(topLeft.x, topLeft.y + 1.f);
-            Vector2i s3 = Vector2i(topLeft.x + 1.f, topLeft.y + 1.f);
+    // Materialize texel data now (thread-safe, decodes at most once)
+    inline void Prefetch() const
+    {
+        if (!IsLoaded()) load();
+    }
 
-            if (m_WrapMode != WrapMode::NoWrap)
-            {
-                // For modes except NoWrap, we need to manually clamp the image
-                // coordinate. For NoWrap, don't clamp it to retrieve black color when out
-                // of image region.
-                s0 = clampImageCoord(s0);
-                s1 = clampImageCoord(s1);
-                s2 = clampImageCoord(s2);
-                s3 = clampImageCoord(s3);
-            }
+    // lod: triangle level of detail (GetTriangleLod), mipmapping filters only
+    inline Color3 Sample(const Vector2f& coord, Float lod = -FLT_MAX) const
+    {
+        Prefetch();
+        return m_Sampler(*this, coord, lod, s_UnitTable.data());
+    }
 
-            Color3 c0 = getColorFromImage(s0);
-            Color3 c1 = getColorFromImage(s1);
-            Color3 c2 = getColorFromImage(s2);
-            Color3 c3 = getColorFromImage(s3);
-
-            Color3 cx1 = Lerp(tx, c0, c1);  // Horizontal Interpolation
-            Color3 cx2 = Lerp(tx, c2, c3);
-            return Lerp(ty, cx1, cx2);  // Vertical Interpolation
-        }
-        else  // Nearest (Default)
-        {
-            Vector2i imageUV = Vector2i(std::floor(coord.u * w), std::floor(coord.v * h));
-            return getColorFromImage(imageUV);
-        }
+    // Color maps (sRGB texels), decoded to linear space before filtering
+    inline Color3 SampleLinear(const Vector2f& coord, Float lod = -FLT_MAX) const
+    {
+        Prefetch();
+        return m_Sampler(*this, coord, lod, s_LinearTable.data());
     }
 
-    // Return Color3 [0, 255]
-    inline Color3 getColorFromImage(const Vector2i& imageUV) const
+    // Normal maps: the tangent space vector in [-1, 1] (texel * 2 - 1, decoded through
+    // s_SignedTable). Not normalized, an orthonormal TBN keeps its length for the one
+    // normalize of the world space normal.
+    inline Vector3f SampleNormal(const Vector2f& coord, Float lod = -FLT_MAX) const
     {
-        const TGAColor& color = m_Image.Get(imageUV.u, imageUV.v);
-        return Color3(color.r, color.g, color.b);
+        Prefetch();
+        return m_Sampler(*this, coord, lod, s_SignedTable.data());
     }
 
-    inline Vector2i clampImageCoord(const Vector2i& imageUV) const
+    // channel: 0 (R), 1 (G), 2 (B)
+    inline Float SampleFloat(const Vector2f& coord, int channel = 2,
+                             Float lod = -FLT_MAX) const
     {
-        return Vector2i(Clamp(imageUV.u, 0, m_Image.GetWidth() - 1),
-                        Clamp(imageUV.v, 0, m_Image.GetHeight() - 1));
+        Prefetch();
+        return m_Sampler(*this, coord, lod, s_UnitTable.data())[channel];
+    }
+
+    // Virtual textures: requests the pages Sample(coord, lod) reads from the next
+    // VirtualTexture::Update() (feedback pass), other textures ignore it
+    void RecordFeedback(const Vector2f& coord, Float lod) const;
+
+private:
+    static const int s_TileShift = 2;  // 4x4 texels
+    static const int s_TileSize = 1 << s_TileShift;
+    static const int s_TileMask = s_TileSize - 1;
+
+    // Texel byte -> [0, 1], sRGB byte -> linear [0, 1] (replaces Pow(Gamma) per
+    // fragment), and normal map byte -> [-1, 1]
+    static const std::array<Float, 256> s_UnitTable;
+    static const std::array<Float, 256> s_LinearTable;
+    static const std::array<Float, 256> s_SignedTable;
+
+    // Private Data (levels and size are filled in by a deferred load)
+    mutable int                            m_Width;
+    mutable int                            m_Height;
+    std::vector<std::uint8_t>              m_Texels;  // owns tiled texels of all levels
+    mutable std::vector<Level>             m_Levels;
+    mutable int                            m_Bytespp;  // 0 for block formats
+    mutable Format                         m_Format;
+    std::shared_ptr<const MappedFile>      m_Mapping;  // owns mapped texels
+    mutable std::shared_ptr<const Texture> m_Source;   // owns adopted texels
+    std::shared_ptr<VirtualTexture>        m_Virtual;  // owns paged texels
+    WrapMode                               m_WrapMode;
+    FilterMode                             m_FilterMode;
+
+    // Deferred Decoding
+    mutable Loader            m_Loader;
+    mutable std::atomic<bool> m_Loaded;
+    mutable std::once_flag    m_LoadFlag;
+
+    // Sampling: one function per wrap mode, filter mode and texel format (texel size or
+    // block format), chosen when the texels are available. table decodes texel bytes
+    // (s_UnitTable, s_LinearTable or s_SignedTable).
+    using Sampler = Color3 (*)(const Texture& texture, const Vector2f& coord, Float lod,
+                               const Float* table);
+    mutable Sampler m_Sampler;
+    mutable Float   m_LodBias;  // level of one texel per pixel, 0.5 * log2(w * h)
+
+    void selectSampler() const;
+
+    template <WrapMode Wrap, FilterMode Filter, Format Fmt, int Bytespp>
+    static Color3 sample(const Texture& texture, const Vector2f& coord, Float lod,
+                         const Float* table);
+    static Color3 sampleMissing(const Texture& texture, const Vector2f& coord, Float lod,
+                                const Float* table);
+
+    template <WrapMode Wrap>
+    static Vector2f wrapCoord(const Vector2f& coord);
+    template <WrapMode Wrap, Format Fmt, int Bytespp>
+    static Color3 nearest(const Level& level, const Vector2f& coord, const Float* table);
+    template <WrapMode Wrap, Format Fmt, int Bytespp>
+    static Color3 bilinear(const Level& level, const Vector2f& coord, const Float* table);
+    template <WrapMode Wrap, Format Fmt, int Bytespp>
+    static Color3 fetch(const Level& level, const Vector2i& imageUV, const Float* table);
+    template <WrapMode Wrap, Format Fmt, int Bytespp>
+    static const std::uint8_t* getTexel(const Level& level, int x, int y);
+
+    // Texel (x, y) of a level: tile, then the texel inside it
+    static inline int getTexelIndex(const Level& level, int x, int y)
+    {
+        return getTexelIndex(level.width, x, y);
+    }
+
+    static inline int getTexelIndex(int width, int x, int y)
+    {
+        int tilesPerRow = (width + s_TileSize - 1) >> s_TileShift;
+        int tile = (y >> s_TileShift) * tilesPerRow + (x >> s_TileShift);
+        int inTile = ((y & s_TileMask) << s_TileShift) + (x & s_TileMask);
+        return (tile << (2 * s_TileShift)) + inTile;
+    }
+
+    void load() const
+    {
+        std::call_once(m_LoadFlag, [this]() {
+            std::shared_ptr<const Texture> source = m_Loader ? m_Loader() : nullptr;
+            if (source)
+            {
+                m_Width = source->m_Width;
+                m_Height = source->m_Height;
+                m_Bytespp = source->m_Bytespp;
+                m_Format = source->m_Format;
+                m_Levels = source->m_Levels;
+                m_Source = std::move(source);
+            }
+            m_Loader = nullptr;  // release captured state
+            selectSampler();
+            m_Loaded.store(true, std::memory_order_release);
+        });
     }
-};
\ No newline at end of file
+};
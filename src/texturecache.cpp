@@ -0,0 +1,257 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#include "texturecache.h"
+
+#include <spdlog/spdlog.h>
+
+#include "mappedfile.h"
+#include "packarchive.h"
+#include "sharedstore.h"
+#include "utility.h"
+
+static const char          s_CacheFileMagic[4] = { 'F', 'K', 'T', 'C' };
+static const std::uint32_t s_CacheFileVersion = 2;  // 2: tiled levels
+static const std::uint32_t s_FlagFlipVertically = 0x1;
+static const std::size_t   s_LevelAlignment = 64;  // cache line
+
+#pragma pack(push, 1)
+struct CacheFileHeader
+{
+    char          magic[4];
+    std::uint32_t version;
+    std::uint32_t flags;
+    std::uint32_t bytespp;
+    std::uint32_t numLevels;
+    std::uint32_t reserved;
+    std::uint64_t sourceSize;
+    std::int64_t  sourceMtime;
+    std::uint64_t contentHash;  // of the source image file
+};
+
+struct CacheFileLevel
+{
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint64_t offset;  // from the beginning of the file
+};
+#pragma pack(pop)
+
+/////////////////////////////////////////////////////////////////////////////////
+
+static std::size_t alignUp(std::size_t value)
+{
+    return (value + s_LevelAlignment - 1) / s_LevelAlignment * s_LevelAlignment;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+std::string TextureCache::GetCacheFilename(const std::string& imageFilename)
+{
+    return imageFilename + ".ftc";
+}
+
+std::shared_ptr<Texture> TextureCache::Load(const std::string& imageFilename,
+                                            bool flipVertically, Texture::WrapMode wrap,
+                                            Texture::FilterMode filter)
+{
+    auto mapping = std::make_shared<MappedFile>();
+    if (!mapping->Open(GetCacheFilename(imageFilename))) return nullptr;
+
+    return decode(mapping, mapping->GetData(), mapping->GetSize(), imageFilename,
+                  flipVertically, wrap, filter);
+}
+
+bool TextureCache::Store(const std::string& imageFilename, bool flipVertically,
+                         const TGAImage& image)
+{
+    std::vector<std::uint8_t> bytes;
+    if (!encode(imageFilename, flipVertically, image, bytes)) return false;
+
+    // Written under a temporary name, so other processes never map a partial file
+    std::string cacheFilename = GetCacheFilename(imageFilename);
+    std::string tempFilename =
+        cacheFilename + ".tmp" + std::to_string(std::random_device{}());
+    std::ofstream out(tempFilename, std::ios::binary);
+    if (!out.is_open()) return false;
+
+    out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    out.close();
+
+    if (!out || std::rename(tempFilename.c_str(), cacheFilename.c_str()) != 0)
+    {
+        std::remove(tempFilename.c_str());
+        spdlog::warn("Failed to write texture cache: {}", cacheFilename);
+        return false;
+    }
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+static const char* getOptions(bool flipVertically)
+{
+    return flipVertically ? "texture flipped" : "texture";
+}
+
+static std::string getSharedName(const std::string& imageFilename, bool flipVertically)
+{
+    return SharedAssetStore::MakeName(imageFilename, getOptions(flipVertically));
+}
+
+std::shared_ptr<Texture> TextureCache::AttachShared(const std::string& imageFilename,
+                                                    bool                flipVertically,
+                                                    Texture::WrapMode   wrap,
+                                                    Texture::FilterMode filter)
+{
+    std::shared_ptr<const MappedFile> object =
+        SharedAssetStore::Attach(getSharedName(imageFilename, flipVertically));
+    if (!object) return nullptr;
+
+    return decode(object, SharedAssetStore::GetPayload(*object),
+                  SharedAssetStore::GetPayloadSize(*object), imageFilename,
+                  flipVertically, wrap, filter);
+}
+
+std::shared_ptr<Texture> TextureCache::PublishShared(const std::string& imageFilename,
+                                                     bool                flipVertically,
+                                                     const TGAImage&     image,
+                                                     Texture::WrapMode   wrap,
+                                                     Texture::FilterMode filter)
+{
+    std::vector<std::uint8_t> bytes;
+    if (!encode(imageFilename, flipVertically, image, bytes)) return nullptr;
+
+    std::shared_ptr<const MappedFile> object = SharedAssetStore::Publish(
+        getSharedName(imageFilename, flipVertically), bytes.size(),
+        [&bytes](std::uint8_t* payload, std::size_t size) {
+            memcpy(payload, bytes.data(), size);
+            return true;
+        });
+    if (!object) return nullptr;
+
+    return decode(object, SharedAssetStore::GetPayload(*object),
+                  SharedAssetStore::GetPayloadSize(*object), imageFilename,
+                  flipVertically, wrap, filter);
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<Texture> TextureCache::LoadPacked(const std::string&  imageFilename,
+                                                  bool                flipVertically,
+                                                  Texture::WrapMode   wrap,
+                                                  Texture::FilterMode filter)
+{
+    std::shared_ptr<const MappedFile> entry = PackArchive::Find(
+        PackArchive::GetCookedName(imageFilename, getOptions(flipVertically)));
+    if (!entry) return nullptr;
+
+    return decode(entry, entry->GetData(), entry->GetSize(), imageFilename, flipVertically,
+                  wrap, filter, false);
+}
+
+bool TextureCache::RecordPacked(const std::string& imageFilename, bool flipVertically,
+                                const TGAImage& image)
+{
+    std::vector<std::uint8_t> bytes;
+    if (!encode(imageFilename, flipVertically, image, bytes)) return false;
+
+    PackArchive::Record(
+        PackArchive::GetCookedName(imageFilename, getOptions(flipVertically)),
+        std::move(bytes));
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+bool TextureCache::encode(const std::string& imageFilename, bool flipVertically,
+                          const TGAImage& image, std::vector<std::uint8_t>& bytes)
+{
+    CacheFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, s_CacheFileMagic, 4);
+    header.version = s_CacheFileVersion;
+    header.flags = flipVertically ? s_FlagFlipVertically : 0;
+    header.bytespp = image.GetBytespp();
+    if (!GetFileStat(imageFilename, header.sourceSize, header.sourceMtime)) return false;
+    header.contentHash = HashFile(imageFilename);
+
+    // Mip Chain (down to 1x1)
+    std::vector<TGAImage> chain = Texture::MakeMipChain(image);
+    chain.insert(chain.begin(), image);
+    header.numLevels = (std::uint32_t)chain.size();
+
+    std::vector<CacheFileLevel> levels(chain.size());
+    std::size_t offset = alignUp(sizeof(header) + levels.size() * sizeof(CacheFileLevel));
+    for (std::size_t i = 0; i < chain.size(); ++i)
+    {
+        levels[i].width = chain[i].GetWidth();
+        levels[i].height = chain[i].GetHeight();
+        levels[i].offset = offset;
+        offset = alignUp(offset + Texture::GetTiledSize(levels[i].width, levels[i].height,
+                                                        header.bytespp));
+    }
+
+    bytes.assign(offset, 0);
+    memcpy(bytes.data(), &header, sizeof(header));
+    memcpy(bytes.data() + sizeof(header), levels.data(),
+           levels.size() * sizeof(CacheFileLevel));
+    for (std::size_t i = 0; i < chain.size(); ++i)
+        Texture::TileImage(chain[i], bytes.data() + levels[i].offset);
+    return true;
+}
+
+std::shared_ptr<Texture> TextureCache::decode(std::shared_ptr<const MappedFile> owner,
+                                              const std::uint8_t* data, std::size_t size,
+                                              const std::string&  imageFilename,
+                                              bool                flipVertically,
+                                              Texture::WrapMode   wrap,
+                                              Texture::FilterMode filter,
+                                              bool                checkSource)
+{
+    CacheFileHeader header;
+    if (size < sizeof(header)) return nullptr;
+    memcpy(&header, data, sizeof(header));
+
+    if (checkSource)
+    {
+        std::uint64_t sourceSize;
+        std::int64_t  sourceMtime;
+        if (!GetFileStat(imageFilename, sourceSize, sourceMtime) ||
+            header.sourceSize != sourceSize || header.sourceMtime != sourceMtime)
+            return nullptr;
+    }
+
+    if (memcmp(header.magic, s_CacheFileMagic, 4) != 0 ||
+        header.version != s_CacheFileVersion ||
+        ((header.flags & s_FlagFlipVertically) != 0) != flipVertically ||
+        (header.bytespp != TGAImage::GRAYSCALE && header.bytespp != TGAImage::RGB &&
+         header.bytespp != TGAImage::RGBA) ||
+        header.numLevels == 0 || header.numLevels > 32 ||
+        size < sizeof(header) + header.numLevels * sizeof(CacheFileLevel))
+    {
+        return nullptr;
+    }
+
+    std::vector<Texture::Level> levels(header.numLevels);
+    for (std::uint32_t i = 0; i < header.numLevels; ++i)
+    {
+        CacheFileLevel level;
+        memcpy(&level, data + sizeof(header) + i * sizeof(level), sizeof(level));
+
+        // Sizes are bounded first, so the tiled size cannot overflow
+        if (level.width == 0 || level.height == 0 || level.width > 65536 ||
+            level.height > 65536 || level.offset > size ||
+            Texture::GetTiledSize(level.width, level.height, header.bytespp) >
+                size - level.offset)
+        {
+            return nullptr;
+        }
+        levels[i] = Texture::Level{ data + level.offset, (int)level.width,
+                                    (int)level.height };
+    }
+
+    return std::make_shared<Texture>(owner, std::move(levels), (int)header.bytespp,
+                                     wrap, filter);
+}
@@ -0,0 +1,66 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#pragma once
+
+#include "texture.h"
+
+// On-disk cache of decoded textures, one '<image>.ftc' file next to each source image.
+// It holds the texels exactly as Texture samples them (final orientation applied, in
+// tiles) plus the mip chain. A valid cache file is mapped read-only, so a warm start
+// does no decoding or conversion at all.
+//
+// The same layout is published to the shared asset store, where processes on one host
+// map a single copy of each texture, and stored in scene pack archives.
+//
+// Layout: [Header] [Level x numLevels] [texels of level 0] [level 1] ...
+class TextureCache
+{
+public:
+    static std::string GetCacheFilename(const std::string& imageFilename);
+
+    // nullptr if there is no cache file, or it is stale (source size or mtime changed,
+    // or it was made with another orientation)
+    static std::shared_ptr<Texture> Load(const std::string& imageFilename,
+                                         bool flipVertically, Texture::WrapMode wrap,
+                                         Texture::FilterMode filter);
+
+    // Writes the decoded image and its mip chain (atomically replaces the old file)
+    static bool Store(const std::string& imageFilename, bool flipVertically,
+                      const TGAImage& image);
+
+    // Shared memory counterparts of Load() and Store(). PublishShared() returns the
+    // texture backed by the published object (nullptr if publishing failed).
+    static std::shared_ptr<Texture> AttachShared(const std::string& imageFilename,
+                                                 bool               flipVertically,
+                                                 Texture::WrapMode  wrap,
+                                                 Texture::FilterMode filter);
+    static std::shared_ptr<Texture> PublishShared(const std::string& imageFilename,
+                                                  bool               flipVertically,
+                                                  const TGAImage&    image,
+                                                  Texture::WrapMode  wrap,
+                                                  Texture::FilterMode filter);
+
+    // Pack archive counterparts. LoadPacked() reads the entry of the mounted archive (the
+    // source image is not needed), RecordPacked() adds one to the archive being recorded.
+    static std::shared_ptr<Texture> LoadPacked(const std::string&  imageFilename,
+                                               bool                flipVertically,
+                                               Texture::WrapMode   wrap,
+                                               Texture::FilterMode filter);
+    static bool RecordPacked(const std::string& imageFilename, bool flipVertically,
+                             const TGAImage& image);
+
+private:
+    static bool encode(const std::string& imageFilename, bool flipVertically,
+                       const TGAImage& image, std::vector<std::uint8_t>& bytes);
+    // Validates the data (owned by owner) and builds a texture reading it in place.
+    // Packed textures are not checked against their source image.
+    static std::shared_ptr<Texture> decode(std::shared_ptr<const MappedFile> owner,
+                                           const std::uint8_t* data, std::size_t size,
+                                           const std::string&  imageFilename,
+                                           bool                flipVertically,
+                                           Texture::WrapMode   wrap,
+                                           Texture::FilterMode filter,
+                                           bool                checkSource = true);
+};
@@ -7,6 +7,8 @@
 
 #include <spdlog/spdlog.h>
 
+#include "assetio.h"
+
 /////////////////////////////////////////////////////////////////////////////////
 
 TGAImage::TGAImage() : m_Data(), m_Width(0), m_Height(0), m_Bytespp(0)
@@ -38,132 +40,200 @@ TGAImage& TGAImage::operator=(const TGAImage& img)
     return *this;
 }
 
+TGAImage::TGAImage(TGAImage&& img) noexcept
+    : m_Data(std::move(img.m_Data)),
+      m_Width(img.m_Width),
+      m_Height(img.m_Height),
+      m_Bytespp(img.m_Bytespp)
+{
+    img.m_Width = img.m_Height = img.m_Bytespp = 0;
+}
+
+TGAImage& TGAImage::operator=(TGAImage&& img) noexcept
+{
+    if (this != &img)
+    {
+        m_Data = std::move(img.m_Data);
+        m_Width = img.m_Width;
+        m_Height = img.m_Height;
+        m_Bytespp = img.m_Bytespp;
+        img.m_Width = img.m_Height = img.m_Bytespp = 0;
+    }
+    return *this;
+}
+
 /////////////////////////////////////////////////////////////////////////////////
 
-bool TGAImage::ReadTgaFile(const std::string filename)
+bool TGAImage::ReadTgaFile(const std::string filename, bool flipVertically)
 {
-    std::ifstream in;
-    in.open(filename, std::ios::binary);
-    if (!in.is_open())
+    // The whole file is decoded from memory, which avoids a stream call per byte
+    // (its read may already be in flight, see AssetIO::Prefetch)
+    std::vector<std::uint8_t> file;
+    if (!AssetIO::Read(filename, file))
     {
         spdlog::error("can't open file: {}", filename);
-        in.close();
         return false;
     }
-    TGA_Header header;
-    in.read(reinterpret_cast<char*>(&header), sizeof(header));
-    if (!in.good())
+    if (file.size() < sizeof(TGA_Header))
     {
-        in.close();
         spdlog::error("an error occurred while reading the header");
         return false;
     }
+
+    TGA_Header header;
+    memcpy(&header, file.data(), sizeof(header));
     m_Width = header.width;
     m_Height = header.height;
     m_Bytespp = header.bitsperpixel >> 3;  // divided by 8
     if (m_Width <= 0 || m_Height <= 0 ||
         (m_Bytespp != GRAYSCALE && m_Bytespp != RGB && m_Bytespp != RGBA))
     {
-        in.close();
         spdlog::error("bad bpp (or width/height) value");
         return false;
     }
 
+    // Image ID and color map are skipped
+    size_t offset = sizeof(header) + header.idlength;
+    if (header.colormaptype == 1)
+    {
+        offset += header.colormaplength * ((header.colormapdepth + 7) >> 3);
+    }
+    if (offset > file.size())
+    {
+        spdlog::error("an error occurred while reading the data");
+        return false;
+    }
+    const std::uint8_t* data = file.data() + offset;
+    size_t              dataSize = file.size() - offset;
+
+    // Rows are written directly to their final place: bottom-left origin files are
+    // flipped by default, and the caller's flip cancels or adds to it
+    bool flipRows = !(header.imagedescriptor & 0x20) != flipVertically;
+
     size_t nbytes = m_Bytespp * m_Width * m_Height;
-    m_Data = std::vector<std::uint8_t>(nbytes, 0);
+    m_Data.resize(nbytes);
 
     if (3 == header.datatypecode || 2 == header.datatypecode)
     {
-        in.read(reinterpret_cast<char*>(m_Data.data()), nbytes);
-        if (!in.good())
+        size_t bytesPerLine = m_Width * m_Bytespp;
+        if (dataSize < nbytes)
         {
-            in.close();
             spdlog::error("an error occurred while reading the data");
             return false;
         }
+        for (int j = 0; j < m_Height; ++j)
+        {
+            int row = flipRows ? m_Height - 1 - j : j;
+            memcpy(m_Data.data() + row * bytesPerLine, data + j * bytesPerLine,
+                   bytesPerLine);
+        }
     }
     else if (10 == header.datatypecode || 11 == header.datatypecode)
     {
-        if (!loadRleData(in))
+        if (!loadRleData(data, dataSize, flipRows))
         {
-            in.close();
             spdlog::error("an error occurred while reading the data");
             return false;
         }
     }
     else
     {
-        in.close();
         spdlog::error("unknown file format: {}", (int)header.datatypecode);
         return false;
     }
-    if (!(header.imagedescriptor & 0x20)) FlipVertically();
     if (header.imagedescriptor & 0x10) FlipHorizontally();
     // spdlog::info("{}x{}/{}", width, height, bytespp);
-    in.close();
     return true;
 }
 
+bool TGAImage::ReadTgaInfo(const std::string filename, int& width, int& height,
+                           int& bytespp)
+{
+    std::ifstream in;
+    in.open(filename, std::ios::binary);
+    if (!in.is_open())
+    {
+        return false;
+    }
+    TGA_Header header;
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in.good())
+    {
+        return false;
+    }
+    width = header.width;
+    height = header.height;
+    bytespp = header.bitsperpixel >> 3;
+    return width > 0 && height > 0 &&
+           (bytespp == GRAYSCALE || bytespp == RGB || bytespp == RGBA);
+}
+
 /////////////////////////////////////////////////////////////////////////////////
 
-bool TGAImage::loadRleData(std::ifstream& in)
+bool TGAImage::loadRleData(const std::uint8_t* data, size_t size, bool flipRows)
 {
-    size_t   pixelcount = m_Width * m_Height;
-    size_t   currentpixel = 0;
-    size_t   currentbyte = 0;
-    TGAColor colorbuffer;
-    do
+    const std::uint8_t* end = data + size;
+    size_t              bytesPerLine = m_Width * m_Bytespp;
+    int                 j = 0;  // row in file order
+    size_t              x = 0;  // byte offset inside the row
+    std::uint8_t*       line = m_Data.data() + (flipRows ? m_Height - 1 : 0) * bytesPerLine;
+
+    while (j < m_Height)
     {
-        std::uint8_t chunkheader = 0;
-        chunkheader = in.get();
-        if (!in.good())
+        if (data >= end)
         {
-            spdlog::error("an error occurred while reading the data");
+            spdlog::error("an error occurred while reading the header");
             return false;
         }
-        if (chunkheader < 128)
+        std::uint8_t chunkheader = *data++;
+        bool         raw = chunkheader < 128;
+        size_t       count = raw ? chunkheader + 1 : chunkheader - 127;  // in pixels
+        size_t       packetBytes = raw ? count * m_Bytespp : m_Bytespp;
+        if ((size_t)(end - data) < packetBytes)
         {
-            chunkheader++;
-            for (int i = 0; i < chunkheader; i++)
-            {
-                in.read(reinterpret_cast<char*>(colorbuffer.bgra), m_Bytespp);
-                if (!in.good())
-                {
-                    spdlog::error("an error occurred while reading the header");
-                    return false;
-                }
-                for (int t = 0; t < m_Bytespp; t++)
-                    m_Data[currentbyte++] = colorbuffer.bgra[t];
-                currentpixel++;
-                if (currentpixel > pixelcount)
-                {
-                    spdlog::error("Too many pixels read");
-                    return false;
-                }
-            }
+            spdlog::error("an error occurred while reading the data");
+            return false;
         }
-        else
+
+        // A packet may cross scanlines, so it is written in row-sized pieces
+        const std::uint8_t* pixel = data;
+        while (count > 0)
         {
-            chunkheader -= 127;
-            in.read(reinterpret_cast<char*>(colorbuffer.bgra), m_Bytespp);
-            if (!in.good())
+            if (j >= m_Height)
             {
-                spdlog::error("an error occurred while reading the header");
+                spdlog::error("too many pixels read");
                 return false;
             }
-            for (int i = 0; i < chunkheader; i++)
+            size_t n = std::min(count, (bytesPerLine - x) / m_Bytespp);
+            size_t bytes = n * m_Bytespp;
+            if (raw)
+            {
+                memcpy(line + x, pixel, bytes);
+                pixel += bytes;
+            }
+            else if (m_Bytespp == GRAYSCALE)
             {
-                for (int t = 0; t < m_Bytespp; t++)
-                    m_Data[currentbyte++] = colorbuffer.bgra[t];
-                currentpixel++;
-                if (currentpixel > pixelcount)
+                memset(line + x, *pixel, bytes);
+            }
+            else
+            {
+                // Copy the first pixel, then keep doubling the filled span
+                memcpy(line + x, pixel, m_Bytespp);
+                for (size_t filled = m_Bytespp; filled < bytes; filled <<= 1)
                 {
-                    spdlog::error("too many pixels read");
-                    return false;
+                    memcpy(line + x + filled, line + x, std::min(filled, bytes - filled));
                 }
             }
+            count -= n;
+            x += bytes;
+            if (x == bytesPerLine && ++j < m_Height)
+            {
+                x = 0;
+                line = m_Data.data() + (flipRows ? m_Height - 1 - j : j) * bytesPerLine;
+            }
         }
-    } while (currentpixel < pixelcount);
+        data += packetBytes;
+    }
     return true;
 }
 
@@ -334,15 +404,14 @@ int TGAImage::GetHeight() const
 void TGAImage::FlipHorizontally()
 {
     if (!m_Data.size()) return;
-    int half = m_Width >> 1;
-    for (int i = 0; i < half; i++)
+    size_t bytesPerLine = m_Width * m_Bytespp;
+    for (int j = 0; j < m_Height; ++j)
     {
-        for (int j = 0; j < m_Height; j++)
+        std::uint8_t* left = m_Data.data() + j * bytesPerLine;
+        std::uint8_t* right = left + bytesPerLine - m_Bytespp;
+        for (; left < right; left += m_Bytespp, right -= m_Bytespp)
         {
-            TGAColor c1 = Get(i, j);
-            TGAColor c2 = Get(m_Width - 1 - i, j);
-            Set(i, j, c2);
-            Set(m_Width - 1 - i, j, c1);
+            std::swap_ranges(left, left + m_Bytespp, right);
         }
     }
 }
@@ -350,17 +419,13 @@ void TGAImage::FlipHorizontally()
 void TGAImage::FlipVertically()
 {
     if (!m_Data.size()) return;
-    size_t                    bytes_per_line = m_Width * m_Bytespp;
-    std::vector<std::uint8_t> line(bytes_per_line, 0);
-    int                       half = m_Height >> 1;
-    for (int j = 0; j < half; j++)
+    size_t bytesPerLine = m_Width * m_Bytespp;
+    int    half = m_Height >> 1;
+    for (int j = 0; j < half; ++j)
     {
-        size_t l1 = j * bytes_per_line;
-        size_t l2 = (m_Height - 1 - j) * bytes_per_line;
-        std::copy(m_Data.begin() + l1, m_Data.begin() + l1 + bytes_per_line, line.begin());
-        std::copy(m_Data.begin() + l2, m_Data.begin() + l2 + bytes_per_line,
-                  m_Data.begin() + l1);
-        std::copy(line.begin(), line.end(), m_Data.begin() + l2);
+        std::uint8_t* l1 = m_Data.data() + j * bytesPerLine;
+        std::uint8_t* l2 = m_Data.data() + (m_Height - 1 - j) * bytesPerLine;
+        std::swap_ranges(l1, l1 + bytesPerLine, l2);
     }
 }
 
@@ -369,6 +434,11 @@ std::uint8_t* TGAImage::Buffer()
     return m_Data.data();
 }
 
+const std::uint8_t* TGAImage::Buffer() const
+{
+    return m_Data.data();
+}
+
 void TGAImage::Clear()
 {
     m_Data = std::vector<std::uint8_t>(m_Width * m_Height * m_Bytespp, 0);
@@ -116,24 +116,31 @@ public:
     TGAImage();
     TGAImage(int w, int h, int bpp);
     TGAImage(const TGAImage& img);
+    TGAImage(TGAImage&& img) noexcept;
 
-    bool ReadTgaFile(const std::string filename);
+    // flipVertically flips rows relative to the top-left origin while decoding
+    bool ReadTgaFile(const std::string filename, bool flipVertically = false);
+    // Reads and validates only the header
+    static bool ReadTgaInfo(const std::string filename, int& width, int& height,
+                            int& bytespp);
     bool WriteTgaFile(const std::string filename, bool vFlip = true,
                       bool rle = true) const;
 
     TGAColor  Get(int x, int y) const;
     void      Set(int x, int y, const TGAColor& c);
     TGAImage& operator=(const TGAImage& img);
+    TGAImage& operator=(TGAImage&& img) noexcept;
 
     void FlipHorizontally();
     void FlipVertically();
     void Scale(int w, int h);
 
-    int           GetWidth() const;
-    int           GetHeight() const;
-    int           GetBytespp() const;
-    std::uint8_t* Buffer();
-    void          Clear();
+    int                 GetWidth() const;
+    int                 GetHeight() const;
+    int                 GetBytespp() const;
+    std::uint8_t*       Buffer();
+    const std::uint8_t* Buffer() const;
+    void                Clear();
 
 protected:
     std::vector<std::uint8_t> m_Data;
@@ -141,6 +148,6 @@ protected:
     int                       m_Height;
     int                       m_Bytespp;
 
-    bool loadRleData(std::ifstream& in);
+    bool loadRleData(const std::uint8_t* data, size_t size, bool flipRows);
     bool unloadRleData(std::ofstream& out) const;
 };
@@ -0,0 +1,50 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#include "threadpool.h"
+
+ThreadPool::ThreadPool(unsigned int numThreads) : m_Stopping(false)
+{
+    if (numThreads == 0) numThreads = 1;
+    m_Workers.reserve(numThreads);
+    for (unsigned int i = 0; i < numThreads; ++i)
+    {
+        m_Workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stopping = true;
+    }
+    m_Condition.notify_all();
+    for (std::thread& worker : m_Workers)
+    {
+        worker.join();
+    }
+}
+
+unsigned int ThreadPool::DefaultNumThreads()
+{
+    unsigned int n = std::thread::hardware_concurrency();
+    return n == 0 ? 4 : n;  // hardware_concurrency() may be unknown
+}
+
+void ThreadPool::workerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Condition.wait(lock, [this]() { return m_Stopping || !m_Tasks.empty(); });
+            if (m_Stopping && m_Tasks.empty()) return;
+            task = std::move(m_Tasks.front());
+            m_Tasks.pop();
+        }
+        task();
+    }
+}
@@ -0,0 +1,53 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed-size worker pool. Tasks must not block on other tasks of the same pool,
+// since a waiting worker cannot pick up the task it waits for.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned int numThreads = DefaultNumThreads());
+    ~ThreadPool();  // finishes queued tasks, then joins
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template <typename F>
+    auto Enqueue(F&& f) -> std::future<decltype(f())>
+    {
+        using ReturnType = decltype(f());
+        auto task = std::make_shared<std::packaged_task<ReturnType()>>(std::forward<F>(f));
+        std::future<ReturnType> future = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Tasks.emplace([task]() { (*task)(); });
+        }
+        m_Condition.notify_one();
+        return future;
+    }
+
+    unsigned int GetNumThreads() const { return (unsigned int)m_Workers.size(); }
+
+    static unsigned int DefaultNumThreads();
+
+private:
+    std::vector<std::thread>          m_Workers;
+    std::queue<std::function<void()>> m_Tasks;
+    std::mutex                        m_Mutex;
+    std::condition_variable           m_Condition;
+    bool                              m_Stopping;
+
+    void workerLoop();
+};
@@ -16,6 +16,19 @@ inline std::string Ltrim(const std::string& s)
     return (start == std::string::npos) ? "" : s.substr(start);
 }
 
+// Lowercase extension including the dot, e.g. ".obj"
+inline std::string GetExtension(const std::string& filename)
+{
+    size_t dotPos = filename.find_last_of('.');
+    size_t slashPos = filename.find_last_of('/');
+    if (dotPos == std::string::npos) return "";
+    if (slashPos != std::string::npos && dotPos < slashPos) return "";
+    std::string extension = filename.substr(dotPos);
+    for (char& c : extension)
+        c = (char)std::tolower((unsigned char)c);
+    return extension;
+}
+
 inline void TimeElapsed(spdlog::stopwatch& sw, std::string note = "")
 {
     spdlog::info("------------------------------------------------------------");
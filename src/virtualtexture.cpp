@@ -0,0 +1,201 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#include "virtualtexture.h"
+
+#include <spdlog/spdlog.h>
+
+#include "threadpool.h"
+
+static const std::uint32_t s_Pinned = UINT32_MAX;  // mip tail, never evicted
+
+// Live virtual textures (models are loaded in parallel)
+static std::mutex                                 s_Mutex;
+static std::vector<std::weak_ptr<VirtualTexture>> s_Textures;
+static std::size_t                                s_Budget = 256 * 1024 * 1024;
+static std::size_t                                s_ResidentBytes = 0;
+
+std::uint32_t VirtualTexture::s_Frame = 1;
+
+/////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<Texture> VirtualTexture::Create(std::shared_ptr<const Texture> backing,
+                                                Texture::WrapMode           wrap,
+                                                Texture::FilterMode         filter)
+{
+    int  bytespp = backing->GetBytespp();
+    auto pages = std::make_shared<VirtualTexture>(backing);
+
+    std::vector<Texture::Level> levels;
+    for (int i = 0; i < backing->GetNumLevels(); ++i)
+    {
+        const Texture::Level& level = backing->GetLevel(i);
+        levels.push_back(
+            Texture::Level{ nullptr, level.width, level.height, pages->GetPageTable(i) });
+    }
+
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    s_Textures.push_back(pages);
+    return std::make_shared<Texture>(std::move(pages), std::move(levels), bytespp, wrap,
+                                     filter);
+}
+
+void VirtualTexture::SetBudget(std::size_t bytes)
+{
+    s_Budget = bytes;
+}
+
+std::size_t VirtualTexture::GetBudget()
+{
+    return s_Budget;
+}
+
+void VirtualTexture::Update()
+{
+    std::vector<std::shared_ptr<VirtualTexture>> textures;  // released after the lock
+    std::lock_guard<std::mutex>                  lock(s_Mutex);
+
+    struct PageRef
+    {
+        VirtualTexture* texture;
+        int             level;
+        int             page;
+        std::uint32_t   requested;
+    };
+    std::vector<PageRef> missing, evictable;
+    int                  numRequested = 0;
+
+    for (const std::weak_ptr<VirtualTexture>& weak : s_Textures)
+    {
+        std::shared_ptr<VirtualTexture> texture = weak.lock();
+        if (!texture) continue;
+        textures.push_back(texture);
+
+        for (int l = 0; l < (int)texture->m_Levels.size(); ++l)
+        {
+            const PagedLevel& level = texture->m_Levels[l];
+            for (int page = 0; page < (int)level.table.size(); ++page)
+            {
+                std::uint32_t requested = level.requested[page];
+                PageRef       ref = { texture.get(), l, page, requested };
+                if (requested == s_Frame)
+                {
+                    ++numRequested;
+                    if (!level.table[page]) missing.push_back(ref);
+                }
+                else if (level.table[page] && requested != s_Pinned)
+                {
+                    evictable.push_back(ref);
+                }
+            }
+        }
+    }
+    s_Textures.assign(textures.begin(), textures.end());  // drops released textures
+
+    // Coarser levels first, they cover the most pixels per page. Least recently
+    // requested pages are evicted first.
+    std::stable_sort(
+        missing.begin(), missing.end(),
+        [](const PageRef& a, const PageRef& b) { return a.level > b.level; });
+    std::sort(evictable.begin(), evictable.end(), [](const PageRef& a, const PageRef& b) {
+        return a.requested < b.requested;
+    });
+
+    std::vector<PageRef> loads;
+    std::size_t          numEvicted = 0, numSkipped = 0;
+    for (const PageRef& ref : missing)
+    {
+        std::size_t bytes = ref.texture->m_PageBytes;
+        while (s_ResidentBytes + bytes > s_Budget && numEvicted < evictable.size())
+        {
+            const PageRef& victim = evictable[numEvicted++];
+            PagedLevel&    level = victim.texture->m_Levels[victim.level];
+            level.table[victim.page] = nullptr;
+            level.pages[victim.page].reset();
+            victim.texture->m_ResidentBytes -= victim.texture->m_PageBytes;
+            s_ResidentBytes -= victim.texture->m_PageBytes;
+        }
+        if (s_ResidentBytes + bytes > s_Budget)
+        {
+            ++numSkipped;
+            continue;
+        }
+
+        ref.texture->m_Levels[ref.level].pages[ref.page].reset(new std::uint8_t[bytes]);
+        ref.texture->m_ResidentBytes += bytes;
+        s_ResidentBytes += bytes;
+        loads.push_back(ref);
+    }
+
+    // Copies read the mapped cache files, which may wait for the disk
+    {
+        ThreadPool pool;
+        for (const PageRef& ref : loads)
+        {
+            pool.Enqueue([ref]() { ref.texture->loadPage(ref.level, ref.page); });
+        }
+    }  // join
+
+    spdlog::info("  [Virtual] {} textures, {} pages requested, {} loaded, {} evicted, "
+                 "{} skipped",
+                 textures.size(), numRequested, loads.size(), numEvicted, numSkipped);
+    spdlog::info("  [Resident] {:.2f} MB (budget {:.2f} MB)",
+                 s_ResidentBytes / (1024.0 * 1024.0), s_Budget / (1024.0 * 1024.0));
+    ++s_Frame;
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+
+VirtualTexture::VirtualTexture(std::shared_ptr<const Texture> backing)
+    : m_Backing(std::move(backing)),
+      m_PageBytes(Texture::GetPageBytes(m_Backing->GetBytespp())),
+      m_ResidentBytes(0)
+{
+    const int pageSize = Texture::s_PageSize;
+    for (int l = 0; l < m_Backing->GetNumLevels(); ++l)
+    {
+        const Texture::Level& level = m_Backing->GetLevel(l);
+        PagedLevel            paged;
+        paged.pagesPerRow = (level.width + pageSize - 1) / pageSize;
+        int numPages = paged.pagesPerRow * ((level.height + pageSize - 1) / pageSize);
+        paged.table.assign(numPages, nullptr);
+        paged.pages.resize(numPages);
+        paged.requested.assign(numPages, 0);
+        m_Levels.push_back(std::move(paged));
+    }
+
+    // Mip tail (and the last level whatever its size), the fallback of other pages
+    for (int l = 0; l < (int)m_Levels.size(); ++l)
+    {
+        PagedLevel& level = m_Levels[l];
+        if (level.table.size() > 1 && l + 1 < (int)m_Levels.size()) continue;
+
+        for (int page = 0; page < (int)level.table.size(); ++page)
+        {
+            level.pages[page].reset(new std::uint8_t[m_PageBytes]);
+            level.requested[page] = s_Pinned;
+            loadPage(l, page);
+            m_ResidentBytes += m_PageBytes;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    s_ResidentBytes += m_ResidentBytes;
+}
+
+VirtualTexture::~VirtualTexture()
+{
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    s_ResidentBytes -= m_ResidentBytes;
+}
+
+// Copies the page from the backing level, then publishes it in the page table
+void VirtualTexture::loadPage(int level, int page)
+{
+    PagedLevel& paged = m_Levels[level];
+    Texture::CopyPage(m_Backing->GetLevel(level), m_Backing->GetBytespp(),
+                      page % paged.pagesPerRow, page / paged.pagesPerRow,
+                      paged.pages[page].get());
+    paged.table[page] = paged.pages[page].get();
+}
@@ -0,0 +1,69 @@
+//
+// Created by Junhao Wang (@Forkercat) on 2026/10/18.
+//
+
+#pragma once
+
+#include "texture.h"
+
+// Virtual textures ('texture virtual <MB>'): texels stay in the mapped texture cache file
+// and a texture only holds the 64x64 texel pages (see Texture::Level) that visible pixels
+// sampled in the last feedback pass (Texture::RecordFeedback).
+//
+// Pages of all virtual textures share one memory budget, the least recently requested
+// ones are evicted first. Levels of one page (the mip tail) stay resident, so sampling a
+// page that is not resident reads a coarser level instead.
+class VirtualTexture
+{
+public:
+    // Pages of the levels of an uncompressed texture (e.g. a mapped cache file), which is
+    // kept to load them from
+    static std::shared_ptr<Texture> Create(std::shared_ptr<const Texture> backing,
+                                           Texture::WrapMode           wrap,
+                                           Texture::FilterMode         filter);
+
+    static void        SetBudget(std::size_t bytes);
+    static std::size_t GetBudget();
+
+    // Loads the pages requested since the last update (coarser levels first), evicting
+    // pages of any virtual texture that were not requested. Pages that do not fit the
+    // budget are skipped.
+    static void Update();
+
+    explicit VirtualTexture(std::shared_ptr<const Texture> backing);
+    ~VirtualTexture();
+
+    VirtualTexture(const VirtualTexture&) = delete;
+    VirtualTexture& operator=(const VirtualTexture&) = delete;
+
+    inline void Request(int level, int page)
+    {
+        m_Levels[level].requested[page] = s_Frame;
+    }
+
+    inline const std::shared_ptr<const Texture>& GetBacking() const { return m_Backing; }
+
+    // Page table of a level (Texture::Level::pages)
+    inline const std::uint8_t* const* GetPageTable(int level) const
+    {
+        return m_Levels[level].table.data();
+    }
+
+private:
+    static std::uint32_t s_Frame;  // of the requests Update() loads
+
+    struct PagedLevel
+    {
+        int                                          pagesPerRow;
+        std::vector<const std::uint8_t*>             table;
+        std::vector<std::unique_ptr<std::uint8_t[]>> pages;
+        std::vector<std::uint32_t>                   requested;  // frame of last request
+    };
+
+    std::shared_ptr<const Texture> m_Backing;
+    std::vector<PagedLevel>        m_Levels;
+    std::size_t                    m_PageBytes;
+    std::size_t                    m_ResidentBytes;
+
+    void loadPage(int level, int page);
+};